@@ -0,0 +1,57 @@
+#include <cinttypes>
+
+#include "../headers/RBTreeArchive.h"
+#include "bench_header.h"
+
+namespace {
+
+using Map = s21::map<uint64_t, uint64_t>;
+
+// The baseline the archive replaces: one "key,value" line per element,
+// parsed and inserted one by one.
+double LoadCsv(const char *path, Map &map) {
+  bench::Timer timer;
+  std::FILE *file = std::fopen(path, "r");
+  uint64_t key = 0;
+  uint64_t value = 0;
+  while (std::fscanf(file, "%" SCNu64 ",%" SCNu64, &key, &value) == 2) {
+    map.insert(key, value);
+  }
+  std::fclose(file);
+  return timer.Seconds();
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  size_t count = bench::SizeArg(argc, argv, 5000000);
+  std::vector<int> keys = bench::ShuffledKeys(count);
+  Map map;
+  for (int key : keys) map.insert(uint64_t(key) * 7919, uint64_t(key));
+  const char *csv = "/tmp/s21_archive_bench.csv";
+  const char *archive = "/tmp/s21_archive_bench.bin";
+  std::FILE *file = std::fopen(csv, "w");
+  for (int key : keys) {
+    std::fprintf(file, "%" PRIu64 ",%d\n", uint64_t(key) * 7919, key);
+  }
+  std::fclose(file);
+
+  std::printf("reload of a %zu element <uint64_t, uint64_t> map\n", count);
+  bench::Timer save;
+  map.save(archive);
+  std::printf("%-22s %10.3f s\n", "save", save.Seconds());
+  bench::Isolated([&] {
+    Map loaded;
+    double seconds = LoadCsv(csv, loaded);
+    std::printf("%-22s %10.3f s\n", "csv + insert", seconds);
+  });
+  bench::Isolated([&] {
+    Map loaded;
+    bench::Timer timer;
+    loaded.load(archive);
+    std::printf("%-22s %10.3f s\n", "load", timer.Seconds());
+  });
+  std::remove(csv);
+  std::remove(archive);
+  return 0;
+}
@@ -0,0 +1,69 @@
+#include <map>
+
+#include "bench_header.h"
+
+namespace {
+
+using Map = s21::map<int, int>;
+
+// Lookups in batches of the size a router resolves per packet burst.
+constexpr size_t kBatch = 1024;
+
+double FindLoop(Map &map, const std::vector<int> &probes, long &sum) {
+  std::vector<Map::iterator> found(kBatch);
+  bench::Timer timer;
+  for (size_t start = 0; start + kBatch <= probes.size(); start += kBatch) {
+    for (size_t i = 0; i < kBatch; ++i) found[i] = map.find(probes[start + i]);
+    for (size_t i = 0; i < kBatch; ++i) sum += found[i]->second;
+  }
+  return timer.Seconds() * 1e9 / probes.size();
+}
+
+double FindMany(Map &map, const std::vector<int> &probes, long &sum) {
+  std::vector<Map::iterator> found(kBatch);
+  bench::Timer timer;
+  for (size_t start = 0; start + kBatch <= probes.size(); start += kBatch) {
+    map.find_many(probes.data() + start, kBatch, found.data());
+    for (size_t i = 0; i < kBatch; ++i) sum += found[i]->second;
+  }
+  return timer.Seconds() * 1e9 / probes.size();
+}
+
+double ContainsMany(Map &map, const std::vector<int> &probes, long &sum) {
+  uint64_t bits[kBatch / 64];
+  bench::Timer timer;
+  for (size_t start = 0; start + kBatch <= probes.size(); start += kBatch) {
+    map.contains_many(probes.data() + start, kBatch, bits);
+    for (uint64_t word : bits) sum += __builtin_popcountll(word);
+  }
+  return timer.Seconds() * 1e9 / probes.size();
+}
+
+double StdFind(std::map<int, int> &map, const std::vector<int> &probes,
+               long &sum) {
+  bench::Timer timer;
+  for (int key : probes) sum += map.find(key)->second;
+  return timer.Seconds() * 1e9 / probes.size();
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  size_t count = bench::SizeArg(argc, argv, 4000000);
+  std::vector<int> keys = bench::ShuffledKeys(count);
+  Map map;
+  std::map<int, int> stdMap;
+  for (int key : keys) {
+    map.insert(key, key);
+    stdMap.insert({key, key});
+  }
+  std::vector<int> probes = bench::ShuffledKeys(count);
+  long sum = 0;
+  std::printf("random lookups in a %zu element map, batches of %zu, ns/key\n",
+              count, kBatch);
+  std::printf("%-22s %8.1f\n", "find loop", FindLoop(map, probes, sum));
+  std::printf("%-22s %8.1f\n", "find_many", FindMany(map, probes, sum));
+  std::printf("%-22s %8.1f\n", "contains_many", ContainsMany(map, probes, sum));
+  std::printf("%-22s %8.1f\n", "std::map::find", StdFind(stdMap, probes, sum));
+  return sum == 0;
+}
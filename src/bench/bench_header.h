@@ -0,0 +1,87 @@
+#ifndef CPP2_S21_CONTAINERS_1_SRC_BENCH_BENCH_HEADER_H_
+#define CPP2_S21_CONTAINERS_1_SRC_BENCH_BENCH_HEADER_H_
+
+#include <malloc.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "../headers/s21_map.h"
+#include "../headers/s21_multiset.h"
+#include "../headers/s21_set.h"
+
+namespace bench {
+
+class Timer {
+ public:
+  Timer() : start_(std::chrono::steady_clock::now()) {}
+  double Seconds() const {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         start_)
+        .count();
+  }
+
+ private:
+  std::chrono::steady_clock::time_point start_;
+};
+
+// Resident set size of the current process in kilobytes (Linux only).
+inline long CurrentRssKb() {
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.compare(0, 6, "VmRSS:") == 0) return std::atol(line.c_str() + 6);
+  }
+  return 0;
+}
+
+// Bytes the process got from malloc for its heap and for large blocks,
+// including what is lost to alignment and fragmentation, unlike RSS which
+// misses pages never touched.
+inline size_t HeapBytes() {
+  struct mallinfo2 info = mallinfo2();
+  return info.arena + info.hblkhd;
+}
+
+// Runs a case in a child process so that RSS is not skewed by memory the
+// allocator kept around after the previous case.
+template <typename Func>
+void Isolated(Func func) {
+  std::fflush(stdout);
+  pid_t pid = fork();
+  if (pid == 0) {
+    func();
+    std::fflush(stdout);
+    _exit(0);
+  }
+  int status = 0;
+  waitpid(pid, &status, 0);
+}
+
+inline size_t SizeArg(int argc, char **argv, size_t fallback) {
+  return argc > 1 ? std::strtoul(argv[1], nullptr, 10) : fallback;
+}
+
+// Deterministic shuffled keys: a multiplicative permutation of [0, count).
+inline std::vector<int> ShuffledKeys(size_t count) {
+  std::vector<int> keys(count);
+  unsigned long long state = 88172645463325252ull;
+  for (size_t i = 0; i < count; ++i) keys[i] = static_cast<int>(i);
+  for (size_t i = count; i > 1; --i) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    std::swap(keys[i - 1], keys[state % i]);
+  }
+  return keys;
+}
+
+}  // namespace bench
+
+#endif  // CPP2_S21_CONTAINERS_1_SRC_BENCH_BENCH_HEADER_H_
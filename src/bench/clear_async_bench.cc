@@ -0,0 +1,41 @@
+#include "bench_header.h"
+
+namespace {
+
+// How long clearing a large map holds up the calling thread, with clear()
+// and with clear_async(), and how long the reclaimer then takes to finish.
+template <typename Map, typename Value>
+void Run(const char *name, size_t count, Value value) {
+  bench::Isolated([&]() {
+    Map map;
+    for (int key : bench::ShuffledKeys(count)) map[key] = value(key);
+    bench::Timer timer;
+    map.clear();
+    double clear = timer.Seconds();
+    for (int key : bench::ShuffledKeys(count)) map[key] = value(key);
+    timer = bench::Timer();
+    map.clear_async();
+    double async = timer.Seconds();
+    s21::Reclaimer::Global().Wait();
+    double reclaimed = timer.Seconds();
+    std::printf("%-30s %10.3f s %10.6f s %10.3f s\n", name, clear, async,
+                reclaimed);
+  });
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  size_t largest = bench::SizeArg(argc, argv, 10000000);
+  auto number = [](int key) { return key; };
+  auto text = [](int key) { return std::to_string(key); };
+  for (size_t count = largest / 10; count <= largest; count *= 10) {
+    std::printf("%zu elements\n", count);
+    std::printf("%-30s %12s %12s %12s\n", "", "clear", "clear_async",
+                "reclaimed");
+    Run<s21::map<int, int>>("s21::map<int, int>", count, number);
+    Run<s21::map<int, std::string>>("s21::map<int, std::string>", count,
+                                    text);
+  }
+  return 0;
+}
@@ -0,0 +1,69 @@
+#include <mutex>
+#include <thread>
+
+#include "../headers/s21_concurrent_map.h"
+#include "bench_header.h"
+
+namespace {
+
+constexpr int kOpsPerThread = 400000;
+
+// Half of the operations write: an insert or an erase of a random key.
+template <typename Op>
+double Run(unsigned threads, Op op) {
+  std::vector<std::thread> workers;
+  bench::Timer timer;
+  for (unsigned t = 0; t < threads; ++t) {
+    workers.emplace_back([&op, t]() {
+      unsigned state = t * 7919 + 1;
+      for (int i = 0; i < kOpsPerThread; ++i) {
+        state = state * 1103515245 + 12345;
+        op(state >> 8, state & 1);
+      }
+    });
+  }
+  for (std::thread &worker : workers) worker.join();
+  return threads * kOpsPerThread / timer.Seconds() / 1e6;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  size_t count = bench::SizeArg(argc, argv, 100000);
+  std::printf("random insert/erase/find on %zu keys, millions of ops/s, "
+              "%u hardware threads\n",
+              count, std::thread::hardware_concurrency());
+  std::printf("%-26s %10s %10s %10s\n", "threads", "1", "2", "4");
+  std::printf("%-26s", "s21::map + mutex");
+  for (unsigned threads : {1u, 2u, 4u}) {
+    s21::map<int, int> map;
+    std::mutex mutex;
+    std::printf(" %10.2f", Run(threads, [&](unsigned random, bool write) {
+                  int key = static_cast<int>(random % count);
+                  std::lock_guard<std::mutex> lock(mutex);
+                  if (!write) {
+                    map.contains(key);
+                  } else if (random & 2) {
+                    map.insert(key, key);
+                  } else {
+                    map.erase(key);
+                  }
+                }));
+  }
+  std::printf("\n%-26s", "s21::concurrent_map");
+  for (unsigned threads : {1u, 2u, 4u}) {
+    s21::concurrent_map<int, int> map;
+    std::printf(" %10.2f", Run(threads, [&](unsigned random, bool write) {
+                  int key = static_cast<int>(random % count);
+                  if (!write) {
+                    map.contains(key);
+                  } else if (random & 2) {
+                    map.insert(key, key);
+                  } else {
+                    map.erase(key);
+                  }
+                }));
+  }
+  std::printf("\n");
+  return 0;
+}
@@ -0,0 +1,55 @@
+#include <algorithm>
+#include <map>
+
+#include "bench_header.h"
+
+namespace {
+
+// Copy construction, copy assignment over a map of the same size and
+// destruction, for maps filled in random key order. Best of three runs.
+template <typename Map, typename Value>
+void Run(const char *name, size_t count, Value value) {
+  bench::Isolated([&]() {
+    Map source;
+    for (int key : bench::ShuffledKeys(count)) source[key] = value(key);
+    double best[4] = {1e9, 1e9, 1e9, 1e9};
+    for (int run = 0; run < 3; ++run) {
+      Map target;
+      for (int key : bench::ShuffledKeys(count)) target[key] = value(key);
+      bench::Timer timer;
+      Map *copy = new Map(source);
+      best[0] = std::min(best[0], timer.Seconds());
+      timer = bench::Timer();
+      target = *copy;
+      best[1] = std::min(best[1], timer.Seconds());
+      timer = bench::Timer();
+      delete copy;
+      best[2] = std::min(best[2], timer.Seconds());
+      timer = bench::Timer();
+      target.clear();
+      best[3] = std::min(best[3], timer.Seconds());
+    }
+    std::printf("%-30s %10.3f s %10.3f s %10.3f s %10.3f s\n", name, best[0],
+                best[1], best[2], best[3]);
+  });
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  size_t largest = bench::SizeArg(argc, argv, 10000000);
+  auto number = [](int key) { return key; };
+  auto text = [](int key) { return std::to_string(key); };
+  for (size_t count = largest / 10; count <= largest; count *= 10) {
+    std::printf("%zu elements\n", count);
+    std::printf("%-30s %12s %12s %12s %12s\n", "", "copy", "assign",
+                "destroy", "clear");
+    Run<s21::map<int, int>>("s21::map<int, int>", count, number);
+    Run<std::map<int, int>>("std::map<int, int>", count, number);
+    Run<s21::map<int, std::string>>("s21::map<int, std::string>", count,
+                                    text);
+    Run<std::map<int, std::string>>("std::map<int, std::string>", count,
+                                    text);
+  }
+  return 0;
+}
@@ -0,0 +1,51 @@
+#include <map>
+#include <new>
+
+#include "bench_header.h"
+
+namespace {
+
+size_t allocations = 0;
+
+template <typename Map>
+void Run(const char *name, size_t count) {
+  size_t before = allocations;
+  bench::Timer timer;
+  for (size_t i = 0; i < count; ++i) {
+    Map map;
+    Map moved(std::move(map));
+    asm volatile("" : : "g"(&map), "g"(&moved) : "memory");
+  }
+  double loop = timer.Seconds() * 1e9 / count;
+  double allocs = double(allocations - before) / count;
+  timer = bench::Timer();
+  { std::vector<Map> maps(count); }
+  double held = timer.Seconds() * 1e9 / count;
+  std::printf("%-22s %8zu %14.1f %14.1f %12.2f\n", name, sizeof(Map), loop,
+              held, allocs);
+}
+
+}  // namespace
+
+// Counts every allocation of the process.
+void *operator new(size_t size) {
+  ++allocations;
+  if (void *ptr = std::malloc(size)) return ptr;
+  throw std::bad_alloc();
+}
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
+
+int main(int argc, char **argv) {
+  size_t count = bench::SizeArg(argc, argv, 10000000);
+  std::printf("%zu empty containers: constructed, moved and destroyed one "
+              "at a time,\nthen all held at once in a vector\n",
+              count);
+  std::printf("%-22s %8s %14s %14s %12s\n", "", "bytes", "one, ns",
+              "vector, ns", "allocs each");
+  Run<s21::map<int, int>>("s21::map<int, int>", count);
+  Run<s21::set<int>>("s21::set<int>", count);
+  Run<s21::multiset<int>>("s21::multiset<int>", count);
+  Run<std::map<int, int>>("std::map<int, int>", count);
+  return 0;
+}
@@ -0,0 +1,44 @@
+#include <algorithm>
+
+#include "bench_header.h"
+
+namespace {
+
+double Plain(const std::vector<int> &keys) {
+  s21::map<int, int> map;
+  bench::Timer timer;
+  for (int key : keys) map.insert(key, key);
+  return keys.size() / timer.Seconds() / 1e6;
+}
+
+// Ascending input is appended with end() as the hint, any other order uses
+// the previous insertion point, which is exact for descending input.
+double Hinted(const std::vector<int> &keys, bool ascending) {
+  s21::map<int, int> map;
+  bench::Timer timer;
+  auto hint = map.end();
+  for (int key : keys) {
+    hint = map.emplace_hint(ascending ? map.end() : hint, key, key);
+  }
+  return keys.size() / timer.Seconds() / 1e6;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  size_t count = bench::SizeArg(argc, argv, 1000000);
+  std::vector<int> sorted(count);
+  for (size_t i = 0; i < count; ++i) sorted[i] = static_cast<int>(i);
+  std::vector<int> reversed(sorted.rbegin(), sorted.rend());
+  std::vector<int> shuffled = bench::ShuffledKeys(count);
+  std::printf("s21::map<int, int>, %zu inserts, Mops/s\n", count);
+  std::printf("%-10s %10s %10s\n", "order", "insert", "hinted");
+
+  std::printf("%-10s %10.2f %10.2f\n", "sorted", Plain(sorted),
+              Hinted(sorted, true));
+  std::printf("%-10s %10.2f %10.2f\n", "reverse", Plain(reversed),
+              Hinted(reversed, false));
+  std::printf("%-10s %10.2f %10.2f\n", "random", Plain(shuffled),
+              Hinted(shuffled, false));
+  return 0;
+}
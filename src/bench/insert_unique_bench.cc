@@ -0,0 +1,45 @@
+#include "bench_header.h"
+
+namespace {
+
+// The insert path map::insert used before InsertUnique existed.
+bool InsertThrowing(s21::RBTree<int, int> &tree, int key) {
+  try {
+    tree.Insert(key, key);
+    return true;
+  } catch (std::logic_error const &) {
+    return false;
+  }
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  size_t count = bench::SizeArg(argc, argv, 1000000);
+  // Keys are drawn from a range one tenth the size of the workload, so about
+  // 90% of the inserts hit a key that is already present.
+  std::vector<int> keys = bench::ShuffledKeys(count);
+  for (int &key : keys) key %= static_cast<int>(count / 10 + 1);
+  std::printf("%zu inserts, ~90%% duplicates\n", count);
+
+  size_t inserted = 0;
+  s21::RBTree<int, int> throwing;
+  bench::Timer throw_timer;
+  for (int key : keys) inserted += InsertThrowing(throwing, key);
+  std::printf("Insert + catch   %8.2f Mops/s  (%zu new)\n",
+              count / throw_timer.Seconds() / 1e6, inserted);
+
+  inserted = 0;
+  s21::RBTree<int, int> unique;
+  bench::Timer unique_timer;
+  for (int key : keys) inserted += unique.InsertUnique(key, key).second;
+  std::printf("InsertUnique     %8.2f Mops/s  (%zu new)\n",
+              count / unique_timer.Seconds() / 1e6, inserted);
+
+  size_t erased = 0;
+  bench::Timer erase_timer;
+  for (int key : keys) erased += unique.EraseUnique(key);
+  std::printf("EraseUnique      %8.2f Mops/s  (%zu hits)\n",
+              count / erase_timer.Seconds() / 1e6, erased);
+  return 0;
+}
@@ -0,0 +1,48 @@
+#include "../headers/s21_mapped_map.h"
+#include "bench_header.h"
+
+namespace {
+
+template <typename Map>
+double Lookups(Map &map, const std::vector<int> &keys) {
+  bench::Timer timer;
+  long sum = 0;
+  for (int key : keys) sum += map.find(key)->second;
+  if (sum == 0) std::abort();
+  return timer.Seconds() * 1e9 / keys.size();
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  size_t count = bench::SizeArg(argc, argv, 5000000);
+  std::vector<int> keys = bench::ShuffledKeys(count);
+  const char *path = "/tmp/s21_mapped_map_bench.bin";
+  std::remove(path);
+  bench::Timer build;
+  {
+    s21::mapped_map<int, long> writer(path);
+    writer.reserve(count);
+    for (int key : keys) writer.insert(key, key + 1L);
+  }
+  std::printf("a %zu element <int, long> index, built once in %.2f s\n",
+              count, build.Seconds());
+  std::printf("%-34s %12s %12s\n", "", "ready, ms", "find, ns");
+  bench::Isolated([&] {
+    bench::Timer timer;
+    s21::map<int, long> copy;
+    for (int key : keys) copy.insert(key, key + 1L);
+    double ready = timer.Seconds() * 1e3;
+    std::printf("%-34s %12.1f %12.1f\n", "s21::map, private copy", ready,
+                Lookups(copy, keys));
+  });
+  bench::Isolated([&] {
+    bench::Timer timer;
+    s21::mapped_map<int, long> reader(path, s21::MappedMode::READ_ONLY);
+    double ready = timer.Seconds() * 1e3;
+    std::printf("%-34s %12.3f %12.1f\n", "s21::mapped_map, READ_ONLY attach",
+                ready, Lookups(reader, keys));
+  });
+  std::remove(path);
+  return 0;
+}
@@ -0,0 +1,48 @@
+#include <map>
+#include <string>
+
+#include "bench_header.h"
+
+namespace {
+
+// Half of the keys of other are new to the target, half are duplicates.
+template <typename Map>
+void Fill(Map &map, Map &other, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    int key = static_cast<int>(i * 2);
+    map.insert({key, std::to_string(key)});
+    other.insert({key + static_cast<int>(i % 2), std::to_string(key)});
+  }
+}
+
+double CopyInsert(size_t count) {
+  s21::map<int, std::string> map;
+  s21::map<int, std::string> other;
+  Fill(map, other, count);
+  bench::Timer timer;
+  for (auto &item : other) map.insert(item);
+  return timer.Seconds() * 1e3;
+}
+
+template <typename Map>
+double Merge(size_t count) {
+  Map map;
+  Map other;
+  Fill(map, other, count);
+  bench::Timer timer;
+  map.merge(other);
+  return timer.Seconds() * 1e3;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  size_t count = bench::SizeArg(argc, argv, 1000000);
+  std::printf("merge of two maps of %zu <int, string> each, ms\n", count);
+  std::printf("%-26s %10.1f\n", "s21::map copy + insert", CopyInsert(count));
+  std::printf("%-26s %10.1f\n", "s21::map::merge",
+              Merge<s21::map<int, std::string>>(count));
+  std::printf("%-26s %10.1f\n", "std::map::merge",
+              Merge<std::map<int, std::string>>(count));
+  return 0;
+}
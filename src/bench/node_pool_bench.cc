@@ -0,0 +1,76 @@
+#include "bench_header.h"
+
+namespace {
+
+template <typename Tree>
+void Run(const char *name, const std::vector<int> &keys) {
+  long rss_before = bench::CurrentRssKb();
+  Tree tree;
+
+  bench::Timer insert_timer;
+  for (int key : keys) tree.Insert(key, key);
+  double insert_time = insert_timer.Seconds();
+  long rss_after = bench::CurrentRssKb();
+
+  bench::Timer erase_timer;
+  for (size_t i = 0; i < keys.size(); i += 2) tree.Delete(keys[i]);
+  double erase_time = erase_timer.Seconds();
+
+  for (size_t i = 0; i < keys.size(); i += 2) tree.Insert(keys[i], keys[i]);
+
+  bench::Timer clear_timer;
+  tree.clear();
+  double clear_time = clear_timer.Seconds();
+
+  double count = static_cast<double>(keys.size());
+  std::printf("%-10s insert %8.2f Mops/s  erase %8.2f Mops/s  clear %8.3f ms"
+              "  rss %8ld KB\n",
+              name, count / insert_time / 1e6, count / 2 / erase_time / 1e6,
+              clear_time * 1e3, rss_after - rss_before);
+}
+
+// Heap taken per tree, besides the tree object, by many small trees held at
+// once.
+template <typename Tree>
+void Footprint(const char *name, size_t trees) {
+  std::printf("%-10s", name);
+  for (int count : {1, 2, 8, 64}) {
+    bench::Isolated([&] {
+      std::vector<Tree> all(trees);
+      size_t before = bench::HeapBytes();
+      for (Tree &tree : all) {
+        for (int key = 0; key < count; ++key) tree.Insert(key, key);
+      }
+      std::printf(" %9.1f", double(bench::HeapBytes() - before) / trees);
+    });
+  }
+  std::printf("\n");
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  size_t count = bench::SizeArg(argc, argv, 1000000);
+  std::vector<int> keys = bench::ShuffledKeys(count);
+  std::printf("RBTree<int, int>, %zu shuffled keys\n", count);
+
+  using Less = std::less<int>;
+  using s21::Ranking;
+  bench::Isolated([&] {
+    Run<s21::RBTree<int, int, Less, Ranking::NONE, s21::NodeHeap>>(
+        "new/delete", keys);
+  });
+  bench::Isolated([&] {
+    Run<s21::RBTree<int, int, Less, Ranking::NONE, s21::NodePool>>("NodePool",
+                                                                   keys);
+  });
+
+  size_t trees = count / 10;
+  std::printf("\nheap bytes per tree, %zu trees of\n%-10s %9d %9d %9d %9d\n",
+              trees, "", 1, 2, 8, 64);
+  Footprint<s21::RBTree<int, int, Less, Ranking::NONE, s21::NodeHeap>>(
+      "new/delete", trees);
+  Footprint<s21::RBTree<int, int, Less, Ranking::NONE, s21::NodePool>>(
+      "NodePool", trees);
+  return 0;
+}
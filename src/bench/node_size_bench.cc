@@ -0,0 +1,33 @@
+#include "bench_header.h"
+
+namespace {
+
+// Resident memory per element, slab and allocator overhead included.
+template <typename Container>
+void Run(const char *name, const std::vector<int> &keys) {
+  long rss_before = bench::CurrentRssKb();
+  Container container;
+  for (int key : keys) container.insert(key);
+  long rss_after = bench::CurrentRssKb();
+  std::printf("%-16s %8.1f bytes/element\n", name,
+              (rss_after - rss_before) * 1024.0 / keys.size());
+}
+
+template <typename Key, typename T>
+struct MapOf : s21::map<Key, T> {
+  void insert(Key key) { s21::map<Key, T>::insert(key, key); }
+};
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  size_t count = bench::SizeArg(argc, argv, 4000000);
+  std::vector<int> keys = bench::ShuffledKeys(count);
+  std::printf("%zu shuffled int keys\n", count);
+  bench::Isolated([&] { Run<s21::set<int>>("set<int>", keys); });
+  bench::Isolated([&] { Run<MapOf<int, int>>("map<int, int>", keys); });
+  bench::Isolated([&] { Run<s21::multiset<int>>("multiset<int>", keys); });
+  bench::Isolated(
+      [&] { Run<s21::set<int, std::less<int>, true>>("ranked set<int>", keys); });
+  return 0;
+}
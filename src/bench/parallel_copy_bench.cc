@@ -0,0 +1,42 @@
+#include <algorithm>
+#include <thread>
+
+#include "bench_header.h"
+
+namespace {
+
+// Copies of one map made with 1 to 16 threads, best of three runs each, and
+// the speedup over the copy made on the calling thread alone.
+template <typename Map, typename Value>
+void Run(const char *name, size_t count, Value value) {
+  bench::Isolated([&]() {
+    Map source;
+    for (int key : bench::ShuffledKeys(count)) source[key] = value(key);
+    double serial = 0;
+    for (unsigned threads : {1u, 2u, 4u, 8u, 16u}) {
+      double best = 1e9;
+      for (int run = 0; run < 3; ++run) {
+        bench::Timer timer;
+        Map copy(source, {threads, 0});
+        best = std::min(best, timer.Seconds());
+      }
+      if (threads == 1) serial = best;
+      std::printf("%-30s %8u %10.3f s %9.2fx\n", name, threads, best,
+                  serial / best);
+    }
+  });
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  size_t count = bench::SizeArg(argc, argv, 10000000);
+  std::printf("%zu elements, %u hardware threads\n", count,
+              std::thread::hardware_concurrency());
+  std::printf("%-30s %8s %12s %10s\n", "", "threads", "copy", "speedup");
+  auto number = [](int key) { return key; };
+  auto text = [](int key) { return std::to_string(key); };
+  Run<s21::map<int, int>>("s21::map<int, int>", count, number);
+  Run<s21::map<int, std::string>>("s21::map<int, std::string>", count, text);
+  return 0;
+}
@@ -0,0 +1,67 @@
+#include <set>
+
+#include "bench_header.h"
+
+namespace {
+
+constexpr int kWidth = 64;
+
+// Sums the keys in [lo, lo + kWidth) of every query.
+template <typename Set>
+long long ScanBounded(Set &set, const std::vector<int> &queries) {
+  long long sum = 0;
+  for (int lo : queries) {
+    auto last = set.lower_bound(lo + kWidth);
+    for (auto it = set.lower_bound(lo); it != last; ++it) sum += *it;
+  }
+  return sum;
+}
+
+// What a range scan had to do without lower_bound: walk from begin().
+template <typename Set>
+long long ScanLinear(Set &set, const std::vector<int> &queries) {
+  long long sum = 0;
+  for (int lo : queries) {
+    auto it = set.begin();
+    while (it != set.end() && *it < lo) ++it;
+    for (; it != set.end() && *it < lo + kWidth; ++it) sum += *it;
+  }
+  return sum;
+}
+
+template <typename Func>
+void Report(const char *name, size_t queries, Func func) {
+  bench::Timer timer;
+  long long sum = func();
+  std::printf("%-28s %10.0f scans/s  (checksum %lld)\n", name,
+              queries / timer.Seconds(), sum);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  size_t count = bench::SizeArg(argc, argv, 1000000);
+  std::vector<int> keys = bench::ShuffledKeys(count);
+  std::vector<int> queries(keys.begin(), keys.begin() + count / 10);
+  std::vector<int> few(keys.begin(), keys.begin() + 100);
+  std::printf("%zu keys, scans of width %d\n", count, kWidth);
+
+  s21::set<int> set;
+  s21::multiset<int> multiset;
+  std::set<int> std_set;
+  for (int key : keys) {
+    set.insert(key);
+    multiset.insert(key);
+    std_set.insert(key);
+  }
+
+  Report("s21::set lower_bound", queries.size(),
+         [&] { return ScanBounded(set, queries); });
+  Report("s21::multiset lower_bound", queries.size(),
+         [&] { return ScanBounded(multiset, queries); });
+  Report("std::set lower_bound", queries.size(),
+         [&] { return ScanBounded(std_set, queries); });
+  Report("s21::set linear walk", few.size(),
+         [&] { return ScanLinear(set, few); });
+  return 0;
+}
@@ -0,0 +1,87 @@
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#include "../headers/s21_rcu_map.h"
+#include "bench_header.h"
+
+namespace {
+
+// Lookups per second per reader while one writer updates a key every
+// millisecond.
+template <typename Lookup, typename Write>
+double Run(unsigned readers, size_t count, Lookup lookup, Write write) {
+  std::atomic<bool> done{false};
+  std::atomic<long> lookups{0};
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < readers; ++t) {
+    threads.emplace_back([&, t]() {
+      auto find = lookup();
+      long local = 0;
+      unsigned state = t * 7919 + 1;
+      while (!done.load(std::memory_order_relaxed)) {
+        for (int i = 0; i < 1000; ++i) {
+          state = state * 1103515245 + 12345;
+          local += find(static_cast<int>((state >> 8) % count));
+        }
+      }
+      lookups += local;
+    });
+  }
+  bench::Timer timer;
+  for (int i = 0; timer.Seconds() < 1.0; ++i) {
+    write(i % static_cast<int>(count));
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  done = true;
+  for (std::thread &thread : threads) thread.join();
+  return lookups / timer.Seconds() / readers / 1e6;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  size_t count = bench::SizeArg(argc, argv, 1000000);
+  std::vector<int> keys = bench::ShuffledKeys(count);
+  s21::map<int, int> locked;
+  std::mutex mutex;
+  s21::rcu_map<int, int> rcu;
+  rcu.update([&](auto &map) {
+    for (int key : keys) map.insert(key, key);
+  });
+  for (int key : keys) locked.insert(key, key);
+  std::printf("lookups in a %zu element map with 1000 writes/s, "
+              "millions/s per reader, %u hardware threads\n",
+              count, std::thread::hardware_concurrency());
+  std::printf("%-22s %10s %10s %10s\n", "readers", "1", "2", "4");
+  std::printf("%-22s", "s21::map + mutex");
+  for (unsigned readers : {1u, 2u, 4u}) {
+    std::printf(" %10.2f",
+                Run(
+                    readers, count,
+                    [&]() {
+                      return [&](int key) {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        return locked.contains(key);
+                      };
+                    },
+                    [&](int key) {
+                      std::lock_guard<std::mutex> lock(mutex);
+                      locked.insert_or_assign(key, -key);
+                    }));
+  }
+  std::printf("\n%-22s", "s21::rcu_map");
+  for (unsigned readers : {1u, 2u, 4u}) {
+    std::printf(" %10.2f",
+                Run(
+                    readers, count,
+                    [&]() {
+                      return [reader = rcu.make_reader()](int key) {
+                        return reader.contains(key);
+                      };
+                    },
+                    [&](int key) { rcu.insert_or_assign(key, -key); }));
+  }
+  std::printf("\n");
+  return 0;
+}
@@ -0,0 +1,57 @@
+#include <algorithm>
+#include <set>
+#include <thread>
+
+#include "bench_header.h"
+
+namespace {
+
+using Set = s21::set<int>;
+using Operation = Set (Set::*)(Set &, const s21::ParallelPolicy &);
+
+double Run(Set &a, Set &b, Operation operation, unsigned threads) {
+  bench::Timer timer;
+  Set result = (a.*operation)(b, s21::ParallelPolicy{threads, 0});
+  return timer.Seconds() * 1e3;
+}
+
+// The same result through std::set and its sequential algorithms.
+double StdUnion(std::set<int> &a, std::set<int> &b) {
+  bench::Timer timer;
+  std::set<int> result;
+  std::set_union(a.begin(), a.end(), b.begin(), b.end(),
+                 std::inserter(result, result.end()));
+  return timer.Seconds() * 1e3;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  size_t count = bench::SizeArg(argc, argv, 2000000);
+  std::vector<int> keys = bench::ShuffledKeys(count * 2);
+  Set a(keys.begin(), keys.begin() + count);
+  Set b(keys.begin() + count / 2, keys.begin() + count / 2 + count);
+  std::printf("set algebra on two sets of %zu ints overlapping by half, ms, "
+              "%u hardware threads\n",
+              count, std::thread::hardware_concurrency());
+  std::printf("%-14s %10s %10s %10s %10s\n", "operation", "1", "2", "4", "8");
+  struct {
+    const char *name;
+    Operation operation;
+  } cases[] = {{"union", &Set::set_union},
+               {"intersection", &Set::set_intersection},
+               {"difference", &Set::set_difference},
+               {"symmetric", &Set::symmetric_difference}};
+  for (const auto &item : cases) {
+    std::printf("%-14s", item.name);
+    for (unsigned threads : {1u, 2u, 4u, 8u}) {
+      std::printf(" %10.1f", Run(a, b, item.operation, threads));
+    }
+    std::printf("\n");
+  }
+  std::set<int> stdA(keys.begin(), keys.begin() + count);
+  std::set<int> stdB(keys.begin() + count / 2,
+                     keys.begin() + count / 2 + count);
+  std::printf("%-14s %10.1f\n", "std::set_union", StdUnion(stdA, stdB));
+  return 0;
+}
@@ -0,0 +1,47 @@
+#include <set>
+
+#include "bench_header.h"
+
+namespace {
+
+// Many sets of a few elements each, as kept per user: building them, looking
+// keys up in all of them and the heap they take, the set objects included.
+template <typename Set>
+void Run(const char *name, size_t sets, size_t elements) {
+  bench::Isolated([&]() {
+    std::vector<int> keys = bench::ShuffledKeys(sets * elements);
+    size_t heap = bench::HeapBytes();
+    bench::Timer timer;
+    std::vector<Set> all(sets);
+    for (size_t i = 0; i < keys.size(); ++i) {
+      all[i % sets].insert(keys[i] % 64);
+    }
+    double build = timer.Seconds();
+    size_t used = bench::HeapBytes() - heap;
+    timer = bench::Timer();
+    size_t found = 0;
+    for (int round = 0; round < 4; ++round) {
+      for (size_t i = 0; i < keys.size(); ++i) {
+        found += all[i % sets].count(keys[(i + round) % keys.size()] % 64);
+      }
+    }
+    double lookup = timer.Seconds() / 4;
+    std::printf("%-28s %10.3f s %10.3f s %10.1f B/set %8zu\n", name, build,
+                lookup, double(used) / sets, found);
+  });
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  size_t sets = bench::SizeArg(argc, argv, 1000000);
+  for (size_t elements : {2, 5, 8, 16}) {
+    std::printf("%zu sets of up to %zu ints\n", sets, elements);
+    std::printf("%-28s %12s %12s %16s\n", "", "build", "lookups", "memory");
+    Run<s21::set<int>>("s21::set<int>", sets, elements);
+    Run<s21::set<int, std::less<int>, false, 8>>("s21::set<int, ..., 8>", sets,
+                                                  elements);
+    Run<std::set<int>>("std::set<int>", sets, elements);
+  }
+  return 0;
+}
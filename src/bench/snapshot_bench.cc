@@ -0,0 +1,43 @@
+#include "../headers/s21_persistent_map.h"
+#include "bench_header.h"
+
+namespace {
+
+// Time to hand one consistent snapshot to each of readers readers.
+template <typename Map>
+double Snapshots(Map &map, int readers) {
+  bench::Timer timer;
+  for (int i = 0; i < readers; ++i) {
+    Map snapshot(map);
+    if (snapshot.size() != map.size()) std::abort();
+  }
+  return timer.Seconds() * 1e6 / readers;
+}
+
+template <typename Map>
+double Writes(Map &map, const std::vector<int> &keys) {
+  bench::Timer timer;
+  for (int key : keys) map.insert_or_assign(key, -key);
+  return timer.Seconds() * 1e9 / keys.size();
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  size_t count = bench::SizeArg(argc, argv, 1000000);
+  std::vector<int> keys = bench::ShuffledKeys(count);
+  s21::map<int, int> map;
+  s21::persistent_map<int, int> persistent;
+  for (int key : keys) {
+    map.insert(key, key);
+    persistent.insert(key, key);
+  }
+  std::printf("snapshots of a %zu element <int, int> map\n", count);
+  std::printf("%-22s %14s %14s\n", "", "copy, us", "write, ns");
+  s21::persistent_map<int, int> held(persistent);
+  std::printf("%-22s %14.1f %14.1f\n", "s21::map",
+              Snapshots(map, 8), Writes(map, keys));
+  std::printf("%-22s %14.3f %14.1f\n", "s21::persistent_map",
+              Snapshots(persistent, 1000), Writes(persistent, keys));
+  return held.size() != count;
+}
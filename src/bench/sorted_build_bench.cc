@@ -0,0 +1,28 @@
+#include "bench_header.h"
+
+int main(int argc, char **argv) {
+  size_t count = bench::SizeArg(argc, argv, 1000000);
+  std::vector<std::pair<int, int>> items(count);
+  for (size_t i = 0; i < count; ++i)
+    items[i] = {static_cast<int>(i), static_cast<int>(i)};
+  std::printf("s21::map<int, int> from %zu sorted pairs\n", count);
+
+  bench::Timer insert_timer;
+  {
+    s21::map<int, int> map;
+    for (const auto &item : items) map.insert(item);
+  }
+  std::printf("insert loop    %8.2f ms\n", insert_timer.Seconds() * 1e3);
+
+  bench::Timer range_timer;
+  { s21::map<int, int> map(items.begin(), items.end()); }
+  std::printf("range ctor     %8.2f ms\n", range_timer.Seconds() * 1e3);
+
+  bench::Timer assign_timer;
+  {
+    s21::map<int, int> map;
+    map.assign_sorted(items.begin(), items.end());
+  }
+  std::printf("assign_sorted  %8.2f ms\n", assign_timer.Seconds() * 1e3);
+  return 0;
+}
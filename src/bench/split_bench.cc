@@ -0,0 +1,45 @@
+#include "bench_header.h"
+
+namespace {
+
+template <typename Map>
+void Fill(Map &map, size_t count) {
+  for (int i = 0; i < static_cast<int>(count); ++i) {
+    map.insert(map.end(), {i, i});
+  }
+}
+
+// Drops the oldest keys of a time-keyed map, the way a rotating window
+// retires its oldest partition.
+double EraseLoop(size_t count, size_t cut) {
+  s21::map<int, int> map;
+  Fill(map, count);
+  bench::Timer timer;
+  for (size_t i = 0; i < cut; ++i) map.erase(static_cast<int>(i));
+  return timer.Seconds() * 1e3;
+}
+
+template <typename Map>
+double SplitAt(size_t count, size_t cut) {
+  Map map;
+  Fill(map, count);
+  bench::Timer timer;
+  Map newer = map.split_at(static_cast<int>(cut));
+  map.swap(newer);
+  return timer.Seconds() * 1e3;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  size_t count = bench::SizeArg(argc, argv, 1000000);
+  std::printf("retiring the oldest keys of a %zu element map, ms\n", count);
+  std::printf("%-10s %12s %12s %12s\n", "retired", "erase loop", "split_at",
+              "ranked");
+  for (size_t cut : {count / 1000, count / 60, count / 2}) {
+    std::printf("%-10zu %12.3f %12.3f %12.3f\n", cut, EraseLoop(count, cut),
+                SplitAt<s21::map<int, int>>(count, cut),
+                SplitAt<s21::map<int, int, std::less<int>, true>>(count, cut));
+  }
+  return 0;
+}
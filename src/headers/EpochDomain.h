@@ -0,0 +1,246 @@
+#ifndef CPP2_S21_CONTAINERS_1_SRC_RBTREE_EPOCHDOMAIN_H_
+#define CPP2_S21_CONTAINERS_1_SRC_RBTREE_EPOCHDOMAIN_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace s21 {
+
+// Epoch based reclamation. Writers retire objects that readers may still be
+// looking at, and the objects are deleted once every reader that was inside
+// a read section at the time has left it. Readers only load and store their
+// own slot, they never wait and never touch a shared counter.
+class EpochDomain {
+  static constexpr uint64_t kIdle = std::numeric_limits<uint64_t>::max();
+  static constexpr size_t kCollectBatch = 64;
+
+  struct Retired {
+    uint64_t epoch;
+    void* object;
+    void (*destroy)(void*);
+  };
+
+ public:
+  // A reading thread's announcement of the epoch it entered at. Slots are
+  // cache line aligned so that readers do not write to a shared line. Only
+  // the owning thread touches depth and retired.
+  struct alignas(64) Slot {
+    std::atomic<uint64_t> epoch{kIdle};
+    std::atomic<bool> owned{true};
+    Slot* next = nullptr;
+    int depth = 0;
+    std::vector<Retired> retired;
+    size_t collectAt = kCollectBatch;
+  };
+
+  // Keeps the calling thread inside a read section of domain.
+  class Guard {
+   public:
+    explicit Guard(EpochDomain& domain)
+        : domain_(domain), slot_(domain.LocalSlot()) {
+      domain_.Enter(slot_);
+    }
+    Guard(const Guard&) = delete;
+    Guard& operator=(const Guard&) = delete;
+    ~Guard() { domain_.Leave(slot_); }
+
+    Slot* slot() const { return slot_; }
+
+   private:
+    EpochDomain& domain_;
+    Slot* slot_;
+  };
+
+  EpochDomain() {}
+  EpochDomain(const EpochDomain&) = delete;
+  EpochDomain& operator=(const EpochDomain&) = delete;
+  // No reader may be inside a read section any more. A thread that is just
+  // giving back a slot may keep the slots alive a little longer.
+  ~EpochDomain() { Destroy(retired_, retired_.begin()); }
+
+  // Hands out a slot for one reader, reusing the slots of readers that left.
+  Slot* Register() {
+    std::atomic<Slot*>& slots = slots_->head;
+    for (Slot* slot = slots.load(std::memory_order_acquire); slot != nullptr;
+         slot = slot->next) {
+      bool expected = false;
+      if (!slot->owned.load(std::memory_order_relaxed) &&
+          slot->owned.compare_exchange_strong(expected, true,
+                                              std::memory_order_acquire)) {
+        return slot;
+      }
+    }
+    Slot* slot = new Slot;
+    slot->next = slots.load(std::memory_order_relaxed);
+    while (!slots.compare_exchange_weak(slot->next, slot,
+                                        std::memory_order_seq_cst,
+                                        std::memory_order_relaxed)) {
+    }
+    return slot;
+  }
+  // The slot must not be in a read section. What it retired and readers no
+  // longer hold is deleted, the rest waits for the next owner of the slot.
+  void Unregister(Slot* slot) { Release(*slots_, slot); }
+  // The calling thread's slot, registered on first use. The slots of the
+  // last few domains are cached; one pushed out of the cache, and those left
+  // when the thread exits, are given back unless the domain is gone.
+  Slot* LocalSlot() {
+    thread_local LocalSlots cache;
+    std::vector<CachedSlot>& slots = cache.slots;
+    for (auto it = slots.rbegin(); it != slots.rend(); ++it) {
+      if (it->id == id_) return it->slot;
+    }
+    for (auto it = slots.begin();
+         slots.size() >= kCachedDomains && it != slots.end(); ++it) {
+      // The slot of a gone domain is freed with it. A slot in a read section
+      // stays, its Leave is still to come.
+      std::shared_ptr<Slots> alive = it->slots.lock();
+      if (alive == nullptr || it->slot->depth == 0) {
+        if (alive != nullptr) Release(*alive, it->slot);
+        slots.erase(it);
+        break;
+      }
+    }
+    slots.push_back({id_, Register(), slots_});
+    return slots.back().slot;
+  }
+
+  // What the reader loads after Enter stays alive until its Leave, provided
+  // it loads the published pointer with memory_order_seq_cst. The slot store
+  // and that load are then ordered against the writer's publish and Collect,
+  // so either the writer sees the slot or the reader sees the new pointer.
+  // Read sections of one slot nest.
+  void Enter(Slot* slot) {
+    if (slot->depth++ > 0) return;
+    slot->epoch.store(epoch_.load(std::memory_order_acquire),
+                      std::memory_order_seq_cst);
+  }
+  void Leave(Slot* slot) {
+    if (--slot->depth > 0) return;
+    slot->epoch.store(kIdle, std::memory_order_release);
+  }
+
+  // Retire and Collect are called by one writer at a time. object must have
+  // been unpublished already, readers entering from now on cannot reach it.
+  template <typename P>
+  void Retire(P* object) {
+    retired_.push_back({NextEpoch(), object, &Delete<P>});
+  }
+  // Deletes the retired objects no reader can still hold.
+  void Collect() { Collect(retired_); }
+  size_t Pending() const { return retired_.size(); }
+  // Slots ever created, owned or not.
+  size_t SlotCount() const {
+    size_t count = 0;
+    for (Slot* slot = slots_->head.load(std::memory_order_acquire);
+         slot != nullptr; slot = slot->next) {
+      ++count;
+    }
+    return count;
+  }
+
+  // The same for any number of writers, each of which retires into its own
+  // slot and collects from it every so often. While a stalled reader holds
+  // the objects back, collecting waits for the list to double, so that the
+  // cost per retired object stays constant.
+  void Retire(Slot* slot, void* object, void (*destroy)(void*)) {
+    slot->retired.push_back({NextEpoch(), object, destroy});
+    if (slot->retired.size() < slot->collectAt) return;
+    Collect(slot->retired);
+    slot->collectAt = std::max(kCollectBatch, 2 * slot->retired.size());
+  }
+
+ private:
+  static constexpr size_t kCachedDomains = 8;
+
+  // The list of slots, which threads giving back a cached slot may keep alive
+  // past the domain.
+  struct Slots {
+    Slots() {}
+    Slots(const Slots&) = delete;
+    Slots& operator=(const Slots&) = delete;
+    ~Slots() {
+      Slot* slot = head.load(std::memory_order_acquire);
+      while (slot != nullptr) {
+        Slot* next = slot->next;
+        Destroy(slot->retired, slot->retired.begin());
+        delete slot;
+        slot = next;
+      }
+    }
+
+    std::atomic<Slot*> head{nullptr};
+  };
+
+  struct CachedSlot {
+    uint64_t id;
+    Slot* slot;
+    std::weak_ptr<Slots> slots;
+  };
+  struct LocalSlots {
+    ~LocalSlots() {
+      for (CachedSlot& cached : slots) Give(cached);
+    }
+
+    std::vector<CachedSlot> slots;
+  };
+
+  static void Give(CachedSlot& cached) {
+    if (std::shared_ptr<Slots> slots = cached.slots.lock()) {
+      Release(*slots, cached.slot);
+    }
+  }
+  static void Release(const Slots& slots, Slot* slot) {
+    Collect(slots, slot->retired);
+    slot->owned.store(false, std::memory_order_release);
+  }
+
+  template <typename P>
+  static void Delete(void* object) {
+    delete static_cast<P*>(object);
+  }
+  static void Destroy(std::vector<Retired>& items,
+                      std::vector<Retired>::iterator first) {
+    for (auto it = first; it != items.end(); ++it) it->destroy(it->object);
+    items.erase(first, items.end());
+  }
+  static uint64_t NewId() {
+    static std::atomic<uint64_t> next{1};
+    return next.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  uint64_t NextEpoch() {
+    return epoch_.fetch_add(1, std::memory_order_seq_cst);
+  }
+  void Collect(std::vector<Retired>& items) { Collect(*slots_, items); }
+  static void Collect(const Slots& slots, std::vector<Retired>& items) {
+    // A slot added after this load belongs to a reader that will see the
+    // published pointer, the seq_cst push and load make sure of that.
+    uint64_t oldest = kIdle;
+    for (Slot* slot = slots.head.load(std::memory_order_seq_cst);
+         slot != nullptr;
+         slot = slot->next) {
+      oldest = std::min(oldest, slot->epoch.load(std::memory_order_seq_cst));
+    }
+    Destroy(items, std::partition(items.begin(), items.end(),
+                                  [oldest](const Retired& item) {
+                                    return item.epoch >= oldest;
+                                  }));
+  }
+
+  // Never reused, so that a thread's cached slot of a destroyed domain does
+  // not match a new one at the same address.
+  const uint64_t id_ = NewId();
+  std::atomic<uint64_t> epoch_{0};
+  std::shared_ptr<Slots> slots_ = std::make_shared<Slots>();
+  std::vector<Retired> retired_;
+};
+
+}  // namespace s21
+
+#endif  // CPP2_S21_CONTAINERS_1_SRC_RBTREE_EPOCHDOMAIN_H_
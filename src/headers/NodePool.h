@@ -0,0 +1,452 @@
+#ifndef CPP2_S21_CONTAINERS_1_SRC_RBTREE_NODEPOOL_H_
+#define CPP2_S21_CONTAINERS_1_SRC_RBTREE_NODEPOOL_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace s21 {
+
+// Slab allocator for tree nodes. Storage is handed out uninitialized: the
+// owner constructs and destroys nodes itself and only returns raw slots.
+// Freed slots are recycled through an intrusive free list, all slabs are
+// released at once by Release().
+//
+// Nodes can move between trees without being copied. A pool that receives
+// nodes from another one adopts that pool's arena, the slabs it ever
+// allocated. Slots of an adopted arena are not reused by the adopter but go
+// back to the owner of the arena, or are counted off once the owner is gone.
+// An arena is freed when its owner has released it and the last node that
+// lives in it elsewhere is gone.
+//
+// Slabs start at two slots and double, so a tree of a few nodes does not hold
+// a large slab. The arena of a slot is found from the slab address ranges the
+// pool collects when it adopts.
+template <typename Node>
+class NodePool {
+ public:
+  using size_type = size_t;
+
+  static constexpr bool kBulkRelease = true;
+  static constexpr size_type kMinSlabSize = 2;
+  static constexpr size_type kMaxSlabSize = 8192;
+
+  NodePool() {}
+  NodePool(const NodePool &other) = delete;
+  NodePool(NodePool &&other) noexcept { MoveFrom(other); }
+  ~NodePool() { Release(); }
+  NodePool &operator=(const NodePool &other) = delete;
+  NodePool &operator=(NodePool &&other) noexcept;
+
+  void *Allocate();
+  void Deallocate(void *ptr);
+  void Reserve(size_type count);
+  // Nodes still allocated are given up with their slots. If Shared(), they
+  // must be deallocated first, so that nodes of other pools are counted off.
+  void Release();
+  void Adopt(const NodePool &other);
+  NodePool Share(const void *ptr) const;
+  bool Shared() const;
+
+  size_type capacity() const { return capacity_; }
+  // Also counts the adopted arenas this pool keeps alive.
+  size_type bytes() const;
+
+ private:
+  union Slot {
+    Slot *next;
+    alignas(Node) unsigned char storage[sizeof(Node)];
+  };
+
+  struct Slab {
+    Slab *next;
+    size_type count;
+  };
+
+  struct Arena {
+    Arena() {}
+    Arena(const Arena &other) = delete;
+    Arena &operator=(const Arena &other) = delete;
+    ~Arena();
+
+    // Marks returned once the owner is gone.
+    Slot *Orphaned() { return reinterpret_cast<Slot *>(this); }
+
+    Slab *slabs = nullptr;
+    // Slots not given up yet: the whole capacity while the owner lives, then
+    // those of nodes still alive in other pools.
+    std::atomic<size_type> live{0};
+    std::atomic<size_type> bytes{0};
+    // Slots freed by other pools, waiting for the owner.
+    std::atomic<Slot *> returned{nullptr};
+  };
+
+  // The slots of a slab of an adopted arena.
+  struct Range {
+    const Slot *begin;
+    const Slot *end;
+    Arena *arena;
+
+    bool operator<(const Range &other) const { return begin < other.begin; }
+    bool operator==(const Range &other) const { return begin == other.begin; }
+  };
+
+  static constexpr size_type kSlotsOffset =
+      (sizeof(Slab) + alignof(Slot) - 1) / alignof(Slot) * alignof(Slot);
+
+  // Slots are laid out in runs that start a fixed stride apart and leave a
+  // gap at the end, so that nodes allocated one after another do not map to
+  // the same cache sets at power of two distances.
+  static constexpr size_type RunBytes() {
+    size_type size = 256;
+    while (size < kSlotsOffset + 64 * sizeof(Slot)) size *= 2;
+    return size;
+  }
+  static constexpr size_type kRunBytes = RunBytes();
+  static constexpr size_type kSlotsPerRun =
+      (kRunBytes - kSlotsOffset) / sizeof(Slot);
+
+  static Slot *SlotsOf(Slab *slab) {
+    return reinterpret_cast<Slot *>(reinterpret_cast<unsigned char *>(slab) +
+                                    kSlotsOffset);
+  }
+  static size_type SlabBytes(size_type count) {
+    size_type runs = (count + kSlotsPerRun - 1) / kSlotsPerRun;
+    return (runs - 1) * kRunBytes + kSlotsOffset +
+           (count - (runs - 1) * kSlotsPerRun) * sizeof(Slot);
+  }
+  static void AddRanges(Arena *arena, std::vector<Range> &ranges);
+
+  void Free(Slot *slot) {
+    slot->next = free_;
+    free_ = slot;
+  }
+  const Range *Find(const void *ptr) const;
+  void Refill();
+  bool TakeBack();
+  void NextRun();
+  void AddSlab(size_type count);
+  void Return(Slot *slot, Arena *arena);
+  void DropDead();
+  void MoveFrom(NodePool &other);
+
+  std::shared_ptr<Arena> arena_;
+  std::vector<std::shared_ptr<Arena>> adopted_;
+  // The slabs of the adopted arenas that nodes here may live in, sorted. A
+  // slot in none of them is our own.
+  std::vector<Range> ranges_;
+  Slot *free_ = nullptr;
+  Slot *bump_ = nullptr;
+  Slot *bump_end_ = nullptr;
+  // Slots of the current slab past the run bump_ is in.
+  size_type slab_left_ = 0;
+  size_type next_slab_size_ = kMinSlabSize;
+  size_type capacity_ = 0;
+  // Slots of our arena handed out and not deallocated here.
+  size_type in_use_ = 0;
+  size_type bytes_ = 0;
+};
+
+// Plain operator new/delete per node, kept for comparison with NodePool.
+template <typename Node>
+class NodeHeap {
+ public:
+  using size_type = size_t;
+
+  static constexpr bool kBulkRelease = false;
+
+  void *Allocate() { return ::operator new(sizeof(Node)); }
+  void Deallocate(void *ptr) { ::operator delete(ptr); }
+  void Reserve(size_type) {}
+  void Release() {}
+  void Adopt(const NodeHeap &) {}
+  NodeHeap Share(const void *) const { return NodeHeap(); }
+  bool Shared() const { return false; }
+
+  size_type capacity() const { return 0; }
+  size_type bytes() const { return 0; }
+};
+
+template <typename Node>
+NodePool<Node> &NodePool<Node>::operator=(NodePool &&other) noexcept {
+  if (this != &other) {
+    Release();
+    MoveFrom(other);
+  }
+  return *this;
+}
+
+template <typename Node>
+void *NodePool<Node>::Allocate() {
+  if (free_ == nullptr && bump_ == bump_end_) Refill();
+  Slot *slot;
+  if (free_ != nullptr) {
+    slot = free_;
+    free_ = free_->next;
+  } else {
+    slot = bump_++;
+  }
+  ++in_use_;
+  return slot->storage;
+}
+
+template <typename Node>
+void NodePool<Node>::Deallocate(void *ptr) {
+  Slot *slot = reinterpret_cast<Slot *>(ptr);
+  const Range *range = Find(slot);
+  if (range == nullptr) {
+    Free(slot);
+    --in_use_;
+  } else {
+    Return(slot, range->arena);
+  }
+}
+
+template <typename Node>
+void NodePool<Node>::Reserve(size_type count) {
+  size_type available = static_cast<size_type>(bump_end_ - bump_) + slab_left_;
+  for (Slot *slot = free_; slot != nullptr && available < count;
+       slot = slot->next) {
+    ++available;
+  }
+  if (available < count) AddSlab(count - available);
+}
+
+// The slots we still hold are given up. If nobody else refers to the arena it
+// goes right away and there is nothing to count.
+template <typename Node>
+void NodePool<Node>::Release() {
+  if (arena_ != nullptr && arena_.use_count() > 1) {
+    Slot *slot = arena_->returned.exchange(arena_->Orphaned(),
+                                           std::memory_order_acquire);
+    size_type given_up = capacity_ - in_use_;
+    for (; slot != nullptr; slot = slot->next) ++given_up;
+    arena_->live.fetch_sub(given_up, std::memory_order_acq_rel);
+  }
+  arena_.reset();
+  adopted_.clear();
+  ranges_.clear();
+  free_ = nullptr;
+  bump_ = nullptr;
+  bump_end_ = nullptr;
+  slab_left_ = 0;
+  next_slab_size_ = kMinSlabSize;
+  capacity_ = 0;
+  in_use_ = 0;
+  bytes_ = 0;
+}
+
+// Called by the pool that receives nodes allocated by other. Arenas nothing
+// lives in any more are let go of on the way.
+template <typename Node>
+void NodePool<Node>::Adopt(const NodePool &other) {
+  DropDead();
+  auto keep = [this](const std::shared_ptr<Arena> &arena) {
+    if (arena == nullptr || arena == arena_ ||
+        arena->live.load(std::memory_order_acquire) == 0) {
+      return false;
+    }
+    for (const std::shared_ptr<Arena> &kept : adopted_) {
+      if (kept == arena) return true;
+    }
+    adopted_.push_back(arena);
+    return true;
+  };
+  size_type known = ranges_.size();
+  // The slabs other added since we last adopted from it may hold nodes too.
+  if (keep(other.arena_)) AddRanges(other.arena_.get(), ranges_);
+  for (const std::shared_ptr<Arena> &arena : other.adopted_) keep(arena);
+  for (const Range &range : other.ranges_) {
+    if (range.arena != arena_.get() &&
+        range.arena->live.load(std::memory_order_acquire) != 0) {
+      ranges_.push_back(range);
+    }
+  }
+  std::sort(ranges_.begin() + known, ranges_.end());
+  std::inplace_merge(ranges_.begin(), ranges_.begin() + known, ranges_.end());
+  ranges_.erase(std::unique(ranges_.begin(), ranges_.end()), ranges_.end());
+}
+
+// Returns an empty pool that keeps the arena of ptr alive. It is meant for
+// releasing that single node after the owning pool may be gone.
+template <typename Node>
+NodePool<Node> NodePool<Node>::Share(const void *ptr) const {
+  NodePool shared;
+  const Range *range = Find(ptr);
+  if (range == nullptr) {
+    shared.adopted_.push_back(arena_);
+    AddRanges(arena_.get(), shared.ranges_);
+    std::sort(shared.ranges_.begin(), shared.ranges_.end());
+  } else {
+    for (const std::shared_ptr<Arena> &kept : adopted_) {
+      if (kept.get() == range->arena) shared.adopted_.push_back(kept);
+    }
+    shared.ranges_.push_back(*range);
+  }
+  return shared;
+}
+
+template <typename Node>
+bool NodePool<Node>::Shared() const {
+  return !adopted_.empty() || (arena_ != nullptr && arena_.use_count() > 1);
+}
+
+template <typename Node>
+typename NodePool<Node>::size_type NodePool<Node>::bytes() const {
+  size_type total = bytes_;
+  for (const std::shared_ptr<Arena> &arena : adopted_) {
+    total += arena->bytes.load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+template <typename Node>
+NodePool<Node>::Arena::~Arena() {
+  while (slabs != nullptr) {
+    Slab *next = slabs->next;
+    ::operator delete(slabs, std::align_val_t(alignof(Slot)));
+    slabs = next;
+  }
+}
+
+template <typename Node>
+void NodePool<Node>::AddRanges(Arena *arena, std::vector<Range> &ranges) {
+  for (Slab *slab = arena->slabs; slab != nullptr; slab = slab->next) {
+    const unsigned char *end =
+        reinterpret_cast<unsigned char *>(slab) + SlabBytes(slab->count);
+    ranges.push_back(
+        {SlotsOf(slab), reinterpret_cast<const Slot *>(end), arena});
+  }
+}
+
+template <typename Node>
+const typename NodePool<Node>::Range *NodePool<Node>::Find(
+    const void *ptr) const {
+  if (ranges_.empty()) return nullptr;
+  const Slot *slot = static_cast<const Slot *>(ptr);
+  auto after = std::upper_bound(
+      ranges_.begin(), ranges_.end(), slot,
+      [](const Slot *slot, const Range &range) { return slot < range.begin; });
+  if (after == ranges_.begin() || !(slot < (after - 1)->end)) return nullptr;
+  return &*(after - 1);
+}
+
+// Slots given back by other pools are reused before the pool grows.
+template <typename Node>
+void NodePool<Node>::Refill() {
+  if (slab_left_ > 0) {
+    NextRun();
+  } else if (!TakeBack()) {
+    AddSlab(next_slab_size_);
+    if (next_slab_size_ < kMaxSlabSize) next_slab_size_ *= 2;
+  }
+}
+
+template <typename Node>
+bool NodePool<Node>::TakeBack() {
+  if (arena_ == nullptr ||
+      arena_->returned.load(std::memory_order_relaxed) == nullptr) {
+    return false;
+  }
+  Slot *slot = arena_->returned.exchange(nullptr, std::memory_order_acquire);
+  while (slot != nullptr) {
+    Slot *next = slot->next;
+    Free(slot);
+    --in_use_;
+    slot = next;
+  }
+  return true;
+}
+
+// The current run is full, the next one starts a stride after it.
+template <typename Node>
+void NodePool<Node>::NextRun() {
+  bump_ = reinterpret_cast<Slot *>(reinterpret_cast<unsigned char *>(
+                                       bump_end_ - kSlotsPerRun) +
+                                   kRunBytes);
+  size_type count = std::min(slab_left_, kSlotsPerRun);
+  bump_end_ = bump_ + count;
+  slab_left_ -= count;
+}
+
+template <typename Node>
+void NodePool<Node>::AddSlab(size_type count) {
+  DropDead();
+  if (arena_ == nullptr) arena_ = std::make_shared<Arena>();
+  size_type size = SlabBytes(count);
+  Slab *slab = static_cast<Slab *>(
+      ::operator new(size, std::align_val_t(alignof(Slot))));
+  slab->next = arena_->slabs;
+  slab->count = count;
+  arena_->slabs = slab;
+  arena_->live.fetch_add(count, std::memory_order_relaxed);
+  arena_->bytes.fetch_add(size, std::memory_order_relaxed);
+  // Slots left in the previous slab go to the free list so nothing is lost.
+  while (bump_ != bump_end_ || slab_left_ > 0) {
+    if (bump_ == bump_end_) NextRun();
+    Free(bump_++);
+  }
+  bump_ = SlotsOf(slab);
+  bump_end_ = bump_ + std::min(count, kSlotsPerRun);
+  slab_left_ = count - (bump_end_ - bump_);
+  capacity_ += count;
+  bytes_ += size;
+}
+
+// Gives a slot of an adopted arena back to its owner. Without an owner the
+// slot is counted off, and the arena is let go of with its last slot.
+template <typename Node>
+void NodePool<Node>::Return(Slot *slot, Arena *arena) {
+  Slot *head = arena->returned.load(std::memory_order_relaxed);
+  while (head != arena->Orphaned()) {
+    slot->next = head;
+    if (arena->returned.compare_exchange_weak(head, slot,
+                                              std::memory_order_release,
+                                              std::memory_order_relaxed)) {
+      return;
+    }
+  }
+  if (arena->live.fetch_sub(1, std::memory_order_acq_rel) == 1) DropDead();
+}
+
+template <typename Node>
+void NodePool<Node>::DropDead() {
+  ranges_.erase(
+      std::remove_if(ranges_.begin(), ranges_.end(),
+                     [](const Range &range) {
+                       return range.arena->live.load(
+                                  std::memory_order_acquire) == 0;
+                     }),
+      ranges_.end());
+  adopted_.erase(
+      std::remove_if(adopted_.begin(), adopted_.end(),
+                     [](const std::shared_ptr<Arena> &arena) {
+                       return arena->live.load(std::memory_order_acquire) == 0;
+                     }),
+      adopted_.end());
+}
+
+template <typename Node>
+void NodePool<Node>::MoveFrom(NodePool &other) {
+  arena_ = std::move(other.arena_);
+  adopted_ = std::move(other.adopted_);
+  other.adopted_.clear();
+  ranges_ = std::move(other.ranges_);
+  other.ranges_.clear();
+  free_ = std::exchange(other.free_, nullptr);
+  bump_ = std::exchange(other.bump_, nullptr);
+  bump_end_ = std::exchange(other.bump_end_, nullptr);
+  slab_left_ = std::exchange(other.slab_left_, 0);
+  next_slab_size_ = std::exchange(other.next_slab_size_, kMinSlabSize);
+  capacity_ = std::exchange(other.capacity_, 0);
+  in_use_ = std::exchange(other.in_use_, 0);
+  bytes_ = std::exchange(other.bytes_, 0);
+}
+
+}  // namespace s21
+
+#endif  // CPP2_S21_CONTAINERS_1_SRC_RBTREE_NODEPOOL_H_
@@ -1,575 +1,2194 @@
 #ifndef CPP2_S21_CONTAINERS_1_SRC_RBTREE_RBTREE_H_
 #define CPP2_S21_CONTAINERS_1_SRC_RBTREE_RBTREE_H_
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <new>
 #include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
-namespace s21 {
+#include "NodePool.h"
+#include "RBTreeBalance.h"
+#include "Reclaimer.h"
 
-enum class Color { RED, BLACK };
+namespace s21 {
 
 template <typename Key, typename T>
 class RBTreeIterator;
 template <typename Key, typename T>
 class RBTreeReverseIterator;
+template <typename Node, typename Allocator>
+class RBTreeNodeHandle;
+// Saving and loading, in RBTreeArchive.h so that only its users pull in the
+// file API.
+template <typename Tree>
+class RBTreeArchive;
+
+// Which container wrote an archive. A map of size_t values and a multiset
+// have the same records, the kind keeps them apart.
+enum class ArchiveKind : uint32_t { MAP = 1, SET = 2, MULTISET = 3 };
+
+// Links shared by the tree nodes and the header. The header is the parent of
+// the root, its left and right point to the minimum and maximum nodes and it
+// serves as end(). Leaves are nullptr.
+struct RBTreeNodeBase {
+  RBTreeNodeBase *parent() const {
+    return reinterpret_cast<RBTreeNodeBase *>(parentAndColor_ & ~kBlackBit);
+  }
+  void SetParent(RBTreeNodeBase *node) {
+    parentAndColor_ =
+        reinterpret_cast<uintptr_t>(node) | (parentAndColor_ & kBlackBit);
+  }
+  Color color() const {
+    return parentAndColor_ & kBlackBit ? Color::BLACK : Color::RED;
+  }
+  void SetColor(Color color) {
+    parentAndColor_ = (parentAndColor_ & ~kBlackBit) |
+                      (color == Color::BLACK ? kBlackBit : 0);
+  }
+  bool IsHeader() const {
+    return color() == Color::RED &&
+           (parent() == nullptr || parent()->parent() == this);
+  }
+  static RBTreeNodeBase *Minimum(RBTreeNodeBase *node);
+  static RBTreeNodeBase *Maximum(RBTreeNodeBase *node);
+  static RBTreeNodeBase *Next(RBTreeNodeBase *node);
+  static RBTreeNodeBase *Prev(RBTreeNodeBase *node);
+  // Hints the cache to load node ahead of use, nullptr is fine.
+  static void Prefetch(const RBTreeNodeBase *node) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(node);
+#else
+    (void)node;
+#endif
+  }
+
+  RBTreeNodeBase *left = nullptr;
+  RBTreeNodeBase *right = nullptr;
+
+ private:
+  static constexpr uintptr_t kBlackBit = 1;
+
+  // Nodes are pointer aligned, which leaves the lowest bit of the parent
+  // pointer free to hold the color.
+  uintptr_t parentAndColor_ = 0;
+};
+
+// Mapped type of trees that hold keys only, such as the one behind s21::set.
+struct NoValue {};
+
+// Takes the place of std::pair<Key, NoValue> in the nodes of key-only trees,
+// so that they do not pay for an empty member and its padding. It accepts the
+// same arguments as the pair.
+template <typename Key>
+struct RBTreeKey {
+  using first_type = Key;
+  using second_type = NoValue;
+
+  template <typename K, typename = std::enable_if_t<
+                            std::is_constructible_v<Key, K &&>>>
+  explicit RBTreeKey(K &&key, NoValue = NoValue())
+      : first(std::forward<K>(key)) {}
+  template <typename... KeyArgs, typename... ValueArgs>
+  RBTreeKey(std::piecewise_construct_t, std::tuple<KeyArgs...> key,
+            std::tuple<ValueArgs...>)
+      : first(std::make_from_tuple<Key>(std::move(key))) {}
+
+  Key first;
+  static inline NoValue second;
+};
 
 template <typename Key, typename T>
-struct RBTreeNode {
-  RBTreeNode *parent = nullptr;
-  RBTreeNode *left = nullptr;
-  RBTreeNode *right = nullptr;
-  Color color = Color::RED;
-  std::pair<Key, T> data;
+using RBTreeValue = std::conditional_t<std::is_same_v<T, NoValue>,
+                                       RBTreeKey<Key>, std::pair<Key, T>>;
+
+template <typename Key, typename T>
+struct RBTreeNode : RBTreeNodeBase {
+  template <typename... Args>
+  explicit RBTreeNode(Args &&...args) : data(std::forward<Args>(args)...) {}
+
+  RBTreeValue<Key, T> data;
 };
 
+// Node that also keeps the total weight of its subtree, which turns the tree
+// into an order-statistic tree.
 template <typename Key, typename T>
-class RBTree {
+struct RBTreeRankedNode : RBTreeNode<Key, T> {
+  using RBTreeNode<Key, T>::RBTreeNode;
+
+  size_t weight = 0;
+};
+
+// Keeps the comparator of a tree. Empty comparators such as std::less are
+// stored as a base class, so they add nothing to the size of the tree.
+template <typename Compare,
+          bool = std::is_empty_v<Compare> && !std::is_final_v<Compare>>
+class RBTreeCompare : private Compare {
+ public:
+  RBTreeCompare() = default;
+  explicit RBTreeCompare(const Compare &comp) : Compare(comp) {}
+
+  const Compare &compare() const { return *this; }
+  Compare &compare() { return *this; }
+};
+
+template <typename Compare>
+class RBTreeCompare<Compare, false> {
+ public:
+  RBTreeCompare() = default;
+  explicit RBTreeCompare(const Compare &comp) : comp_(comp) {}
+
+  const Compare &compare() const { return comp_; }
+  Compare &compare() { return comp_; }
+
+ private:
+  Compare comp_;
+};
+
+// Heterogeneous lookup is only offered for comparators that declare
+// is_transparent, as in the standard containers.
+template <typename Compare, typename K, typename = void>
+struct IsTransparent : std::false_type {};
+
+template <typename Compare, typename K>
+struct IsTransparent<Compare, K, std::void_t<typename Compare::is_transparent>>
+    : std::true_type {};
+
+template <typename Compare, typename K>
+using RequireTransparent = std::enable_if_t<IsTransparent<Compare, K>::value>;
+
+// How many threads a set operation or a copy may use, and from which input
+// size on. Smaller inputs are handled on the calling thread.
+struct ParallelPolicy {
+  unsigned threads = std::thread::hardware_concurrency();
+  size_t threshold = size_t(1) << 16;
+};
+
+// The policy of tree copies made by copy construction and assignment. It is
+// shared by all trees, change it while no copy is running.
+inline ParallelPolicy &ParallelCopyPolicy() {
+  static ParallelPolicy policy;
+  return policy;
+}
+
+// What a ranked tree counts: NODES gives every node a weight of one, PAYLOAD
+// uses the mapped value itself as the weight (a multiset stores its counts
+// there).
+enum class Ranking { NONE, NODES, PAYLOAD };
+
+// Shape of a tree and what its operations cost so far. The counters are
+// cumulative over the life of the tree and only kept in builds that define
+// S21_RBTREE_STATS, otherwise they read zero and counting compiles to nothing.
+struct RBTreeStats {
+  size_t height = 0;
+  size_t blackHeight = 0;
+  size_t nodes = 0;
+  size_t bytes = 0;
+  uint64_t comparisons = 0;
+  uint64_t rotations = 0;
+  // Calls of FixInsert, and the levels they climbed recoloring in total.
+  uint64_t fixInsertCalls = 0;
+  uint64_t fixInsertLevels = 0;
+  // Calls of FixDelete, and the iterations of its loop in total.
+  uint64_t fixDeleteCalls = 0;
+  uint64_t fixDeleteIterations = 0;
+};
+
+#ifdef S21_RBTREE_STATS
+// Counters of one tree. Lookups are const and may run in several threads, so
+// the counters are atomic, but they are bumped without a locked instruction:
+// concurrent lookups may lose counts, they never race. A copy of a tree
+// starts counting from zero.
+class RBTreeCounters {
+ public:
+  RBTreeCounters() {}
+  RBTreeCounters(const RBTreeCounters &) {}
+  RBTreeCounters &operator=(const RBTreeCounters &) { return *this; }
+
+  void Add(RBTreeCounter counter) const {
+    std::atomic<uint64_t> &value = values_[static_cast<int>(counter)];
+    value.store(value.load(std::memory_order_relaxed) + 1,
+                std::memory_order_relaxed);
+  }
+  uint64_t Get(RBTreeCounter counter) const {
+    return values_[static_cast<int>(counter)].load(std::memory_order_relaxed);
+  }
+
+ private:
+  mutable std::atomic<uint64_t>
+      values_[static_cast<int>(RBTreeCounter::COUNT)] = {};
+};
+#endif
+
+// Array of N nodes inside the tree. While a tree is small its elements sit
+// here in key order, linked as a balanced tree, and none of them is
+// allocated. With N == 0 it takes no space and the tree is never small.
+template <typename Node, size_t N>
+class RBTreeInline {
+ protected:
+  bool IsSmall() const { return small_; }
+  void SetSmall(bool small) { small_ = small; }
+  Node *Slot(size_t index) const {
+    return reinterpret_cast<Node *>(const_cast<unsigned char *>(slots_)) +
+           index;
+  }
+  size_t SlotOf(const RBTreeNodeBase *node) const {
+    return static_cast<const Node *>(node) - Slot(0);
+  }
+
+ private:
+  alignas(Node) unsigned char slots_[N * sizeof(Node)];
+  bool small_ = true;
+};
+
+template <typename Node>
+class RBTreeInline<Node, 0> {
+ protected:
+  bool IsSmall() const { return false; }
+  void SetSmall(bool) {}
+  Node *Slot(size_t) const { return nullptr; }
+  size_t SlotOf(const RBTreeNodeBase *) const { return 0; }
+};
+
+template <typename Key, typename T, typename Compare = std::less<Key>,
+          Ranking R = Ranking::NONE,
+          template <typename> class Allocator = NodePool, size_t N = 0>
+class RBTree
+    : private RBTreeCompare<Compare>,
+      private RBTreeInline<std::conditional_t<R == Ranking::NONE,
+                                              RBTreeNode<Key, T>,
+                                              RBTreeRankedNode<Key, T>>,
+                           N> {
  public:
   using size_type = size_t;
   using iterator = RBTreeIterator<Key, T>;
-  using Node = RBTreeNode<Key, T>;
-  RBTree();
-  RBTree(const RBTree<Key, T> &other);
-  RBTree(RBTree<Key, T> &&other);
+  using Node = std::conditional_t<R == Ranking::NONE, RBTreeNode<Key, T>,
+                                  RBTreeRankedNode<Key, T>>;
+  using NodeBase = RBTreeNodeBase;
+  using allocator_type = Allocator<Node>;
+  using key_compare = Compare;
+  using node_type = RBTreeNodeHandle<Node, allocator_type>;
+  static constexpr bool kNothrowMove =
+      std::is_nothrow_copy_constructible_v<Compare> &&
+      std::is_nothrow_swappable_v<Compare>;
+  // Moving a small tree moves its elements one by one.
+  static_assert(N == 0 ||
+                    std::is_nothrow_move_constructible_v<RBTreeValue<Key, T>>,
+                "Elements of small trees must be nothrow move constructible");
+  RBTree() : RBTree(Compare()) {}
+  explicit RBTree(const Compare &comp);
+  RBTree(const RBTree &other);
+  RBTree(const RBTree &other, const ParallelPolicy &policy);
+  RBTree(RBTree &&other) noexcept(kNothrowMove);
   ~RBTree();
-  RBTree &operator=(const RBTree<Key, T> &other);
-  RBTree &operator=(RBTree<Key, T> &&other);
-  bool operator==(const RBTree<Key, T> &other) { return root == other.root; }
+  RBTree &operator=(const RBTree &other);
+  RBTree &operator=(RBTree &&other) noexcept(kNothrowMove);
+  void Swap(RBTree &other) noexcept(kNothrowMove);
+  bool operator==(const RBTree &other) { return header() == other.header(); }
   iterator Insert(const Key &key, const T &value);
+  template <typename K, typename V>
+  std::pair<iterator, bool> InsertUnique(K &&key, V &&value);
+  template <typename... Args>
+  std::pair<iterator, bool> EmplaceUnique(Args &&...args);
+  template <typename K, typename... Args>
+  std::pair<iterator, bool> TryEmplace(K &&key, Args &&...args);
+  template <typename... Args>
+  std::pair<iterator, bool> EmplaceUniqueHint(iterator hint, Args &&...args);
+  template <typename K, typename... Args>
+  std::pair<iterator, bool> TryEmplaceHint(iterator hint, K &&key,
+                                           Args &&...args);
+  template <typename Source>
+  void AssignSorted(size_type count, Source source);
+  // Need RBTreeArchive.h, see there.
+  void Save(const std::string &path, ArchiveKind kind) const {
+    RBTreeArchive<RBTree>::Save(*this, path, kind);
+  }
+  template <typename Visit>
+  void Load(const std::string &path, ArchiveKind kind, Visit visit) {
+    RBTreeArchive<RBTree>::Load(*this, path, kind, visit);
+  }
   void Delete(const Key &key);
-  T *at(const Key &key);
-  iterator find(const Key &key);
-  bool empty() const { return root == TNULL; }
-  size_type size() const { return _size; }
+  size_type EraseUnique(const Key &key);
+  void Erase(iterator pos);
+  node_type Extract(iterator pos);
+  template <typename... Args>
+  node_type MakeNode(Args &&...args);
+  std::pair<iterator, bool> InsertNode(node_type &handle);
+  template <typename Absorb>
+  void Merge(RBTree &other, Absorb absorb);
+  void Split(const Key &key, RBTree &upper);
+  void Join(RBTree &other);
+  template <typename K>
+  T *at(const K &key);
+  template <typename K>
+  iterator find(const K &key);
+  template <typename K>
+  iterator FindHint(iterator hint, const K &key) const;
+  template <typename K, typename Out>
+  void FindMany(const K *keys, size_type count, Out *out) const;
+  template <typename K>
+  void ContainsMany(const K *keys, size_type count, uint64_t *bits) const;
+  template <typename K>
+  iterator LowerBound(const K &key) const;
+  template <typename K>
+  iterator UpperBound(const K &key) const;
+  std::vector<iterator> Pivots(int depth) const;
+  bool empty() const { return _size == 0; }
+  size_type size() const {
+    return _size != kUnknownSize ? _size : CountNodes();
+  }
   void clear();
-  iterator begin();
-  iterator end();
+  void ClearAsync(Reclaimer &reclaimer);
+  Compare key_comp() const { return compare(); }
+  iterator begin() { return iterator(header()->left); }
+  iterator end() { return iterator(header()); }
+
+  // Order statistics, available on ranked trees only.
+  std::pair<iterator, size_type> Select(size_type index) const;
+  size_type Rank(const Key &key) const;
+  size_type TotalWeight() const { return Weight(header()->parent()); }
+  void UpdateWeight(iterator pos);
+
+  RBTreeStats Stats() const;
 
  private:
-  Node *root = nullptr;
-  Node *TNULL;
+  template <typename Tree>
+  friend class RBTreeArchive;
+
+  // Inline, so that an empty tree allocates nothing. Moves and swaps relink
+  // the root and the extreme nodes to the header of their new tree.
+  NodeBase header_;
+  // Splitting an unranked tree leaves the sizes of both halves unknown, they
+  // are counted when first asked for. An empty tree always knows its size.
+  static constexpr size_type kUnknownSize =
+      std::numeric_limits<size_type>::max();
   size_type _size = 0;
+  // The count taken by size() while _size is unknown.
+  mutable std::atomic<size_type> counted_{kUnknownSize};
+  allocator_type pool_;
+#ifdef S21_RBTREE_STATS
+  RBTreeCounters counters_;
+
+  void Count(RBTreeCounter counter) const { counters_.Add(counter); }
+#else
+  void Count(RBTreeCounter) const {}
+#endif
+
+  using RBTreeCompare<Compare>::compare;
+  using Inline = RBTreeInline<Node, N>;
+  using Inline::IsSmall;
+  using Inline::SetSmall;
+  using Inline::Slot;
+  using Inline::SlotOf;
+
+  static constexpr uint32_t kValueSize =
+      std::is_same_v<T, NoValue> ? 0 : sizeof(T);
+  // A red-black tree of n nodes is at most 2 * log2(n + 1) high.
+  static constexpr int kMaxHeight = 2 * 8 * sizeof(size_type);
+  // With a pooled allocator the slabs are dropped wholesale, so the tree only
+  // has to be walked when the nodes need their destructors run, or when the
+  // pool shares slabs with others and has to count its nodes off.
+  static constexpr bool kWalkToRelease =
+      !allocator_type::kBulkRelease || !std::is_trivially_destructible_v<Node>;
+
+  // Destroys a detached subtree in preorder, in as many steps as needed.
+  // The children of a node are read before it goes, a right subtree waits on
+  // the stack while the left one is done.
+  struct Teardown {
+    NodeBase *node;
+    NodeBase *pending[kMaxHeight];
+    int count = 0;
+
+    explicit Teardown(NodeBase *top) : node(top) {}
+    bool Run(allocator_type &pool, size_t budget);
+  };
+  // A cleared tree on its way to the reclaimer.
+  struct Retired {
+    Teardown teardown;
+    allocator_type pool;
+
+    static bool Run(void *object, size_t budget);
+  };
+  // Node links as RBTreeBalance reaches them. The header holds the root.
+  struct Links {
+    using Link = NodeBase *;
+
+    RBTree *tree;
+
+    static Link Nil() { return nullptr; }
+    static Link Left(Link node) { return node->left; }
+    static Link Right(Link node) { return node->right; }
+    static Link Parent(Link node) { return node->parent(); }
+    static void SetLeft(Link node, Link child) { node->left = child; }
+    static void SetRight(Link node, Link child) { node->right = child; }
+    static void SetParent(Link node, Link parent) { node->SetParent(parent); }
+    static Color GetColor(Link node) { return node->color(); }
+    static void SetColor(Link node, Color color) { node->SetColor(color); }
+    Link Root() const { return tree->root(); }
+    void SetRoot(Link node) const { tree->header()->SetParent(node); }
+    static void Turned(Link node, Link pivot) {
+      if constexpr (R != Ranking::NONE) {
+        Recount(node);
+        Recount(pivot);
+      }
+    }
+    // Every node whose subtree lost an element lies on the path up from
+    // parent, the rotations that follow keep the weights up to date.
+    void Unlinked(Link parent) const {
+      if constexpr (R != Ranking::NONE) tree->RecountPath(parent);
+    }
+    void Count(RBTreeCounter counter) const { tree->Count(counter); }
+  };
+
+  RBTreeBalance<Links> Balance() { return RBTreeBalance<Links>(Links{this}); }
+  NodeBase *header() const { return const_cast<NodeBase *>(&header_); }
+  NodeBase *root() const { return header()->parent(); }
+  template <typename A, typename B>
+  bool Less(const A &a, const B &b) const {
+    Count(RBTreeCounter::COMPARISONS);
+    return compare()(a, b);
+  }
+  static const Key &KeyOf(const NodeBase *node) {
+    return static_cast<const Node *>(node)->data.first;
+  }
 
-  Node *&FindNode(const Key &key);
-  Node *InsertNode(const Key &key, const T &value);
-  Node *CopyTree(const Node *from, const Node *fTNULL);
-  void DeleteTree(Node *node);
-  void Transplant(Node *u, Node *v);
-  Node *grandparent(Node *node) const;
-  Node *uncle(Node *node) const;
-  Node *Minimum(Node *node) const;
-  Node *Maximum(Node *node) const;
-  void TurnLeft(Node *node);
-  void TurnRight(Node *node);
-  void FixInsert(Node *node);
-  void FixDelete(Node *node);
+  void ResetHeader();
+  void SetRoot(NodeBase *node);
+  void Attach(NodeBase *top, NodeBase *first, NodeBase *last);
+  void SwapNodes(RBTree &other);
+  size_type CountNodes() const;
+  void SetSizeUnknown() {
+    _size = kUnknownSize;
+    counted_.store(kUnknownSize, std::memory_order_relaxed);
+  }
+  void AddToSize(int delta);
+  template <typename K>
+  NodeBase *FindNode(const K &key) const {
+    if (IsSmall()) {
+      size_type index;
+      return FindSlot(key, index);
+    }
+    return FindBelow(header()->parent(), key);
+  }
+  template <typename K>
+  NodeBase *FindBelow(NodeBase *current, const K &key) const;
+  template <typename K, typename Visit>
+  void FindBatch(const K *keys, size_type count, Visit visit) const;
+  NodeBase *FindInsertPos(const Key &key, NodeBase *&parent,
+                          bool &left) const;
+  NodeBase *FindInsertPosHint(NodeBase *hint, const Key &key,
+                              NodeBase *&parent, bool &left) const;
+  void LinkNode(NodeBase *node, NodeBase *parent, bool left);
+  template <typename... Args>
+  Node *CreateNode(Args &&...args);
+  void DestroyNode(NodeBase *node);
+  template <typename Source>
+  NodeBase *BuildSorted(size_type count, int depth, int redDepth,
+                        Source &source);
+  NodeBase *CopyTree(const NodeBase *from, NodeBase *parent);
+  NodeBase *CopyTreeParallel(const NodeBase *from, NodeBase *parent,
+                             const ParallelPolicy &policy);
+  NodeBase *CloneNode(const NodeBase *from, NodeBase *parent);
+  void DeleteTree(NodeBase *node);
+  void ReleaseTree();
+  void EraseNode(NodeBase *node);
+  void UnlinkNode(NodeBase *node);
+  static bool IsBlack(const NodeBase *node) {
+    return node == nullptr || node->color() == Color::BLACK;
+  }
+  static int BlackHeight(const NodeBase *node);
+  static size_type Height(const NodeBase *node);
+  static void CollectPivots(NodeBase *node, int depth,
+                            std::vector<iterator> &pivots);
+  NodeBase *JoinNodes(NodeBase *left, int leftHeight, NodeBase *middle,
+                      NodeBase *right, int rightHeight, int &height);
+  void SplitBelow(NodeBase *node, int height, const Key &key,
+                  NodeBase *&lower, int &lowerHeight, NodeBase *&upper,
+                  int &upperHeight);
+  static size_type Weight(const NodeBase *node);
+  static size_type OwnWeight(const NodeBase *node);
+  static void Recount(NodeBase *node);
+  void RecountPath(NodeBase *node);
+
+  // Small trees, see RBTreeInline.
+  template <typename K>
+  NodeBase *FindSlot(const K &key, size_type &index) const;
+  template <typename... Args>
+  NodeBase *InsertSlot(size_type index, Args &&...args);
+  void EraseSlot(size_type index);
+  template <typename Source>
+  void FillSlots(size_type count, Source source);
+  void LinkSlots();
+  template <typename NodeAt>
+  NodeBase *LinkSorted(NodeAt at, size_type first, size_type count, int depth,
+                       int redDepth);
+  void CopyNodes(const RBTree &other, const ParallelPolicy &policy);
+  void TakeNodes(RBTree &other);
+  void Promote();
+  static int RedDepth(size_type count);
 };
 
 template <typename Key, typename T>
 class RBTreeIterator {
  public:
-  using Node = typename RBTree<Key, T>::Node;
+  using Node = RBTreeNode<Key, T>;
   RBTreeIterator() {}
-  RBTreeIterator(const RBTreeIterator &other)
-      : node(other.node), TNULL(other.TNULL), end(other.end) {}
-  RBTreeIterator(RBTreeIterator &&other);
-  RBTreeIterator(Node *start, Node *mainTNULL);
-  RBTreeIterator &operator=(const RBTreeIterator &other);
-  RBTreeIterator &operator=(RBTreeIterator &&other);
-  RBTreeIterator &operator++();
+  explicit RBTreeIterator(RBTreeNodeBase *start) : node(start) {}
+  RBTreeIterator &operator++() {
+    node = RBTreeNodeBase::Next(node);
+    return *this;
+  }
   RBTreeIterator operator++(int);
-  RBTreeIterator &operator--();
+  RBTreeIterator &operator--() {
+    node = RBTreeNodeBase::Prev(node);
+    return *this;
+  }
   RBTreeIterator operator--(int);
-  Node &operator*();
-  Node *operator->();
+  Node &operator*() const { return *GetNode(); }
+  Node *operator->() const { return GetNode(); }
   bool operator==(const RBTreeIterator &other) const {
-    return (node == other.node && end == other.end) ||
-           (end == other.end && end == true);
+    return node == other.node;
   }
   bool operator!=(const RBTreeIterator &other) const {
-    return (node != other.node && end != other.end) || end != other.end;
+    return node != other.node;
   }
 
  protected:
-  Node *node = nullptr;
-  Node *TNULL = nullptr;
-  bool end = true;
+  template <typename, typename, typename, Ranking, template <typename> class,
+            size_t>
+  friend class RBTree;
+
+  Node *GetNode() const { return static_cast<Node *>(node); }
+
+  RBTreeNodeBase *node = nullptr;
 };
 
-template <typename Key, typename T>
-RBTree<Key, T>::RBTree() {
-  TNULL = new Node;
-  TNULL->color = Color::BLACK;
-  root = TNULL;
+// Owns a node taken out of a tree until it is inserted into a tree of the
+// same type. The handle shares the slabs of the pool the node came from, so
+// it stays valid after that tree is gone.
+template <typename Node, typename Allocator>
+class RBTreeNodeHandle {
+ public:
+  using key_type = typename decltype(Node::data)::first_type;
+  using mapped_type = typename decltype(Node::data)::second_type;
+
+  RBTreeNodeHandle() {}
+  RBTreeNodeHandle(const RBTreeNodeHandle &other) = delete;
+  RBTreeNodeHandle(RBTreeNodeHandle &&other) noexcept
+      : node_(std::exchange(other.node_, nullptr)),
+        pool_(std::move(other.pool_)) {}
+  ~RBTreeNodeHandle() { Reset(); }
+  RBTreeNodeHandle &operator=(const RBTreeNodeHandle &other) = delete;
+  RBTreeNodeHandle &operator=(RBTreeNodeHandle &&other) noexcept {
+    if (this != &other) {
+      Reset();
+      node_ = std::exchange(other.node_, nullptr);
+      pool_ = std::move(other.pool_);
+    }
+    return *this;
+  }
+
+  bool empty() const { return node_ == nullptr; }
+  explicit operator bool() const { return node_ != nullptr; }
+  key_type &key() const { return node_->data.first; }
+  mapped_type &mapped() const { return node_->data.second; }
+  // Sets keep their elements in the key.
+  key_type &value() const { return node_->data.first; }
+
+ private:
+  template <typename, typename, typename, Ranking, template <typename> class,
+            size_t>
+  friend class RBTree;
+
+  void Reset() {
+    if (node_ == nullptr) return;
+    node_->~Node();
+    pool_.Deallocate(node_);
+    node_ = nullptr;
+  }
+
+  Node *node_ = nullptr;
+  Allocator pool_;
+};
+
+template <typename Iterator, typename NodeType>
+struct RBTreeInsertReturn {
+  Iterator position;
+  bool inserted;
+  NodeType node;
+};
+
+inline RBTreeNodeBase *RBTreeNodeBase::Minimum(RBTreeNodeBase *node) {
+  while (node->left != nullptr) node = node->left;
+  return node;
 }
 
-template <typename Key, typename T>
-RBTree<Key, T>::RBTree(const RBTree<Key, T> &other) {
-  TNULL = new Node;
-  TNULL->color = Color::BLACK;
-  root = CopyTree(other.root, other.TNULL);
-  _size = other._size;
+inline RBTreeNodeBase *RBTreeNodeBase::Maximum(RBTreeNodeBase *node) {
+  while (node->right != nullptr) node = node->right;
+  return node;
 }
 
-template <typename Key, typename T>
-RBTree<Key, T>::RBTree(RBTree<Key, T> &&other) {
-  root = other.root;
-  TNULL = other.TNULL;
-  _size = other._size;
-  other.root = nullptr;
-  other.TNULL = nullptr;
-  other._size = 0;
+inline RBTreeNodeBase *RBTreeNodeBase::Next(RBTreeNodeBase *node) {
+  if (node->right != nullptr) return Minimum(node->right);
+  RBTreeNodeBase *parent = node->parent();
+  while (node == parent->right) {
+    node = parent;
+    parent = parent->parent();
+  }
+  // Climbing out of the maximum ends on the header: when the root has no
+  // right subtree the loop already stopped there.
+  if (node->right != parent) node = parent;
+  return node;
 }
 
-template <typename Key, typename T>
-RBTree<Key, T>::~RBTree() {
-  DeleteTree(root);
-  delete TNULL;
-  _size = 0;
+inline RBTreeNodeBase *RBTreeNodeBase::Prev(RBTreeNodeBase *node) {
+  if (node->IsHeader()) return node->right;
+  if (node->left != nullptr) return Maximum(node->left);
+  RBTreeNodeBase *parent = node->parent();
+  while (node == parent->left) {
+    node = parent;
+    parent = parent->parent();
+  }
+  return parent;
 }
 
-template <typename Key, typename T>
-RBTree<Key, T> &RBTree<Key, T>::operator=(const RBTree<Key, T> &other) {
-  if (root == other.root) return *this;
-  DeleteTree(root);
-  delete TNULL;
-  TNULL = new Node;
-  TNULL->color = Color::BLACK;
-  root = CopyTree(other.root, other.TNULL);
-  _size = other._size;
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+RBTree<Key, T, Compare, R, Allocator, N>::RBTree(const Compare &comp)
+    : RBTreeCompare<Compare>(comp) {
+  ResetHeader();
+}
+
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+RBTree<Key, T, Compare, R, Allocator, N>::RBTree(const RBTree &other)
+    : RBTree(other, ParallelCopyPolicy()) {}
+
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+RBTree<Key, T, Compare, R, Allocator, N>::RBTree(const RBTree &other,
+                                                 const ParallelPolicy &policy)
+    : RBTree(other.compare()) {
+  CopyNodes(other, policy);
+}
+
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+RBTree<Key, T, Compare, R, Allocator, N>::RBTree(RBTree &&other) noexcept(
+    kNothrowMove)
+    : RBTreeCompare<Compare>(other.compare()), pool_(std::move(other.pool_)) {
+  ResetHeader();
+  TakeNodes(other);
+}
+
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+RBTree<Key, T, Compare, R, Allocator, N>::~RBTree() {
+  ReleaseTree();
+}
+
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+RBTree<Key, T, Compare, R, Allocator, N> &
+RBTree<Key, T, Compare, R, Allocator, N>::operator=(const RBTree &other) {
+  if (this == &other) return *this;
+  clear();
+  compare() = other.compare();
+  CopyNodes(other, ParallelCopyPolicy());
   return *this;
 }
 
-template <typename Key, typename T>
-RBTree<Key, T> &RBTree<Key, T>::operator=(RBTree<Key, T> &&other) {
-  if (root == other.root) return *this;
-  DeleteTree(root);
-  delete TNULL;
-  root = other.root;
-  TNULL = other.TNULL;
-  _size = other._size;
-  other.root = nullptr;
-  other.TNULL = nullptr;
-  other._size = 0;
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+RBTree<Key, T, Compare, R, Allocator, N> &
+RBTree<Key, T, Compare, R, Allocator, N>::operator=(RBTree &&other) noexcept(
+    kNothrowMove) {
+  if (this == &other) return *this;
+  clear();
+  using std::swap;
+  swap(compare(), other.compare());
+  pool_ = std::move(other.pool_);
+  TakeNodes(other);
   return *this;
 }
 
-template <typename Key, typename T>
-typename RBTree<Key, T>::iterator RBTree<Key, T>::Insert(const Key &key,
-                                                         const T &value) {
-  Node *newNode = InsertNode(key, value);
-  FixInsert(newNode);
-  ++_size;
-  return iterator(newNode, TNULL);
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+void RBTree<Key, T, Compare, R, Allocator, N>::Swap(RBTree &other) noexcept(
+    kNothrowMove) {
+  // The elements of a small tree cannot change places with nodes by relinking.
+  if (IsSmall() || other.IsSmall()) {
+    RBTree moved(std::move(other));
+    other = std::move(*this);
+    *this = std::move(moved);
+    return;
+  }
+  using std::swap;
+  swap(compare(), other.compare());
+  swap(pool_, other.pool_);
+  SwapNodes(other);
 }
 
-template <typename Key, typename T>
-void RBTree<Key, T>::Delete(const Key &key) {
-  Node *nodeToDelete = FindNode(key);
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+typename RBTree<Key, T, Compare, R, Allocator, N>::iterator
+RBTree<Key, T, Compare, R, Allocator, N>::Insert(const Key &key,
+                                                 const T &value) {
+  std::pair<iterator, bool> result = InsertUnique(key, value);
+  if (!result.second) {
+    throw std::logic_error("Key already exists");
+  }
+  return result.first;
+}
+
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+template <typename K, typename V>
+std::pair<typename RBTree<Key, T, Compare, R, Allocator, N>::iterator, bool>
+RBTree<Key, T, Compare, R, Allocator, N>::InsertUnique(K &&key, V &&value) {
+  return TryEmplace(std::forward<K>(key), std::forward<V>(value));
+}
+
+// The node is built first because the key is only known once the pair is
+// constructed; it is thrown away again if the key is already present.
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+template <typename... Args>
+std::pair<typename RBTree<Key, T, Compare, R, Allocator, N>::iterator, bool>
+RBTree<Key, T, Compare, R, Allocator, N>::EmplaceUnique(Args &&...args) {
+  if (IsSmall()) {
+    RBTreeValue<Key, T> value(std::forward<Args>(args)...);
+    return TryEmplace(std::move(value.first), std::move(value.second));
+  }
+  Node *newNode = CreateNode(std::forward<Args>(args)...);
+  NodeBase *parent;
+  bool left;
+  NodeBase *existing = FindInsertPos(newNode->data.first, parent, left);
+  if (existing != nullptr) {
+    DestroyNode(newNode);
+    return std::make_pair(iterator(existing), false);
+  }
+  LinkNode(newNode, parent, left);
+  return std::make_pair(iterator(newNode), true);
+}
+
+// Looks the key up first and constructs the node in place only on a miss, so
+// neither key nor arguments are touched when the key is already present.
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+template <typename K, typename... Args>
+std::pair<typename RBTree<Key, T, Compare, R, Allocator, N>::iterator, bool>
+RBTree<Key, T, Compare, R, Allocator, N>::TryEmplace(K &&key, Args &&...args) {
+  if (IsSmall()) {
+    size_type index;
+    NodeBase *existing = FindSlot(key, index);
+    if (existing != nullptr) return std::make_pair(iterator(existing), false);
+    if (_size < N) {
+      NodeBase *newNode = InsertSlot(
+          index, std::piecewise_construct,
+          std::forward_as_tuple(std::forward<K>(key)),
+          std::forward_as_tuple(std::forward<Args>(args)...));
+      return std::make_pair(iterator(newNode), true);
+    }
+    Promote();
+  }
+  NodeBase *parent;
+  bool left;
+  NodeBase *existing = FindInsertPos(key, parent, left);
+  if (existing != nullptr) return std::make_pair(iterator(existing), false);
+  NodeBase *newNode = CreateNode(
+      std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)),
+      std::forward_as_tuple(std::forward<Args>(args)...));
+  LinkNode(newNode, parent, left);
+  return std::make_pair(iterator(newNode), true);
+}
+
+// Same as EmplaceUnique, placing the node next to hint without a descent
+// from the root when hint is the right spot.
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+template <typename... Args>
+std::pair<typename RBTree<Key, T, Compare, R, Allocator, N>::iterator, bool>
+RBTree<Key, T, Compare, R, Allocator, N>::EmplaceUniqueHint(iterator hint,
+                                                            Args &&...args) {
+  if (IsSmall()) return EmplaceUnique(std::forward<Args>(args)...);
+  Node *newNode = CreateNode(std::forward<Args>(args)...);
+  NodeBase *parent;
+  bool left;
+  NodeBase *existing =
+      FindInsertPosHint(hint.node, newNode->data.first, parent, left);
+  if (existing != nullptr) {
+    DestroyNode(newNode);
+    return std::make_pair(iterator(existing), false);
+  }
+  LinkNode(newNode, parent, left);
+  return std::make_pair(iterator(newNode), true);
+}
+
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+template <typename K, typename... Args>
+std::pair<typename RBTree<Key, T, Compare, R, Allocator, N>::iterator, bool>
+RBTree<Key, T, Compare, R, Allocator, N>::TryEmplaceHint(iterator hint, K &&key,
+                                                         Args &&...args) {
+  if (IsSmall()) {
+    return TryEmplace(std::forward<K>(key), std::forward<Args>(args)...);
+  }
+  NodeBase *parent;
+  bool left;
+  NodeBase *existing = FindInsertPosHint(hint.node, key, parent, left);
+  if (existing != nullptr) return std::make_pair(iterator(existing), false);
+  NodeBase *newNode = CreateNode(
+      std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)),
+      std::forward_as_tuple(std::forward<Args>(args)...));
+  LinkNode(newNode, parent, left);
+  return std::make_pair(iterator(newNode), true);
+}
+
+// Replaces the contents with count elements produced by source() in strictly
+// increasing key order. The tree is laid out balanced in one pass, with the
+// nodes of the deepest level colored red.
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+template <typename Source>
+void RBTree<Key, T, Compare, R, Allocator, N>::AssignSorted(size_type count,
+                                                            Source source) {
+  clear();
+  if (count == 0) return;
+  if constexpr (N > 0) {
+    if (count <= N) {
+      FillSlots(count, source);
+      return;
+    }
+  }
+  SetSmall(false);
+  pool_.Reserve(count);
+  header()->SetParent(BuildSorted(count, 0, RedDepth(count), source));
+  root()->SetParent(header());
+  header()->left = NodeBase::Minimum(root());
+  header()->right = NodeBase::Maximum(root());
+  _size = count;
+}
 
-  if (!nodeToDelete) {
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+void RBTree<Key, T, Compare, R, Allocator, N>::Delete(const Key &key) {
+  if (EraseUnique(key) == 0) {
     throw std::invalid_argument("Key does not exist.");
   }
+}
 
-  Node *toFix;
-  Color originalColor = nodeToDelete->color;
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+typename RBTree<Key, T, Compare, R, Allocator, N>::size_type
+RBTree<Key, T, Compare, R, Allocator, N>::EraseUnique(const Key &key) {
+  NodeBase *nodeToDelete = FindNode(key);
+  if (nodeToDelete == nullptr) return 0;
+  EraseNode(nodeToDelete);
+  return 1;
+}
 
-  if (nodeToDelete->left == TNULL) {
-    toFix = nodeToDelete->right;
-    Transplant(nodeToDelete, nodeToDelete->right);
-  } else if (nodeToDelete->right == TNULL) {
-    toFix = nodeToDelete->left;
-    Transplant(nodeToDelete, nodeToDelete->left);
-  } else {
-    Node *successor = Minimum(nodeToDelete->right);
-    originalColor = successor->color;
-    toFix = successor->right;
-
-    if (successor->parent != nodeToDelete) {
-      Transplant(successor, toFix);
-      successor->right = nodeToDelete->right;
-      successor->right->parent = successor;
-    } else {
-      toFix->parent = successor;
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+void RBTree<Key, T, Compare, R, Allocator, N>::Erase(iterator pos) {
+  EraseNode(&*pos);
+}
+
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+typename RBTree<Key, T, Compare, R, Allocator, N>::node_type
+RBTree<Key, T, Compare, R, Allocator, N>::Extract(iterator pos) {
+  if (IsSmall()) {
+    size_type index = SlotOf(pos.node);
+    node_type handle = MakeNode(std::move(Slot(index)->data));
+    EraseSlot(index);
+    return handle;
+  }
+  node_type handle;
+  handle.pool_ = pool_.Share(pos.node);
+  UnlinkNode(pos.node);
+  handle.node_ = static_cast<Node *>(pos.node);
+  return handle;
+}
+
+// A node that belongs to no tree yet, for callers that split one element
+// into two.
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+template <typename... Args>
+typename RBTree<Key, T, Compare, R, Allocator, N>::node_type
+RBTree<Key, T, Compare, R, Allocator, N>::MakeNode(Args &&...args) {
+  node_type handle;
+  Node *node = CreateNode(std::forward<Args>(args)...);
+  try {
+    handle.pool_ = pool_.Share(node);
+  } catch (...) {
+    DestroyNode(node);
+    throw;
+  }
+  handle.node_ = node;
+  return handle;
+}
+
+// Links the node of handle unless its key is already present, in which case
+// handle keeps it.
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+std::pair<typename RBTree<Key, T, Compare, R, Allocator, N>::iterator, bool>
+RBTree<Key, T, Compare, R, Allocator, N>::InsertNode(node_type &handle) {
+  if (handle.empty()) return std::make_pair(end(), false);
+  if (IsSmall()) {
+    size_type index;
+    NodeBase *existing = FindSlot(handle.key(), index);
+    if (existing != nullptr) return std::make_pair(iterator(existing), false);
+    if (_size < N) {
+      NodeBase *node = InsertSlot(index, std::move(handle.node_->data));
+      handle.Reset();
+      return std::make_pair(iterator(node), true);
     }
+    Promote();
+  }
+  NodeBase *parent;
+  bool left;
+  NodeBase *existing = FindInsertPos(handle.key(), parent, left);
+  if (existing != nullptr) return std::make_pair(iterator(existing), false);
+  pool_.Adopt(handle.pool_);
+  NodeBase *node = std::exchange(handle.node_, nullptr);
+  LinkNode(node, parent, left);
+  return std::make_pair(iterator(node), true);
+}
 
-    Transplant(nodeToDelete, successor);
-    successor->left = nodeToDelete->left;
-    successor->left->parent = successor;
-    successor->color = nodeToDelete->color;
+// Moves the nodes of other whose keys are missing here by relinking them,
+// nothing is allocated or copied. For a key present in both trees
+// absorb(ours, theirs) is called, and theirs is erased from other when it
+// returns true.
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+template <typename Absorb>
+void RBTree<Key, T, Compare, R, Allocator, N>::Merge(RBTree &other,
+                                                     Absorb absorb) {
+  if (this == &other || other.empty()) return;
+  Promote();
+  other.Promote();
+  pool_.Adopt(other.pool_);
+  NodeBase *node = other.header()->left;
+  while (node != other.header()) {
+    // Unlinking never moves the successor to another node, so it stays the
+    // next one to visit.
+    NodeBase *next = NodeBase::Next(node);
+    NodeBase *parent;
+    bool left;
+    NodeBase *existing = FindInsertPos(KeyOf(node), parent, left);
+    if (existing == nullptr) {
+      other.UnlinkNode(node);
+      LinkNode(node, parent, left);
+    } else if (absorb(iterator(existing), iterator(node))) {
+      other.EraseNode(node);
+    }
+    node = next;
   }
+}
 
-  delete nodeToDelete;
+// Moves the elements with keys not less than key into upper, replacing its
+// contents. Both halves are assembled from the subtrees hanging off the search
+// path, so the tree is cut in O(log n) without touching the elements. Sizes
+// come from the weights of a ranked tree. Otherwise both become unknown, and
+// the first size() of a half counts it in linear time.
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+void RBTree<Key, T, Compare, R, Allocator, N>::Split(const Key &key,
+                                                     RBTree &upper) {
+  if (this == &upper) return;
+  upper.clear();
+  upper.compare() = compare();
+  if (empty()) return;
+  if (IsSmall()) {
+    size_type index;
+    FindSlot(key, index);
+    size_type next = index;
+    upper.AssignSorted(_size - index, [this, &next]() {
+      return std::move(Slot(next++)->data);
+    });
+    while (_size > index) Slot(--_size)->~Node();
+    LinkSlots();
+    return;
+  }
+  upper.Promote();
+  upper.pool_.Adopt(pool_);
+  NodeBase *lowerRoot;
+  NodeBase *upperRoot;
+  int lowerHeight;
+  int upperHeight;
+  SplitBelow(root(), BlackHeight(root()), key, lowerRoot, lowerHeight,
+             upperRoot, upperHeight);
+  SetRoot(lowerRoot);
+  upper.SetRoot(upperRoot);
+  if constexpr (R == Ranking::NODES) {
+    size_type total = _size;
+    _size = Weight(lowerRoot);
+    upper._size = total - _size;
+  } else if (lowerRoot == nullptr) {
+    upper._size = _size;
+    upper.counted_.store(counted_.load(std::memory_order_relaxed),
+                         std::memory_order_relaxed);
+    _size = 0;
+  } else if (upperRoot != nullptr) {
+    SetSizeUnknown();
+    upper.SetSizeUnknown();
+  }
+}
 
-  if (originalColor == Color::BLACK) {
-    FixDelete(toFix);
+// Moves all elements of other here in O(log n). The keys of other must all be
+// less or all be greater than ours.
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+void RBTree<Key, T, Compare, R, Allocator, N>::Join(RBTree &other) {
+  if (this == &other || other.empty()) return;
+  bool append =
+      empty() || Less(KeyOf(header()->right), KeyOf(other.header()->left));
+  if (!append && !Less(KeyOf(other.header()->right), KeyOf(header()->left))) {
+    throw std::invalid_argument("Key ranges overlap");
+  }
+  Promote();
+  other.Promote();
+  pool_.Adopt(other.pool_);
+  if (empty()) {
+    SwapNodes(other);
+    return;
+  }
+  // The element next to the seam ties both trees together.
+  NodeBase *outer = append ? other.header()->right : other.header()->left;
+  NodeBase *middle = append ? other.header()->left : other.header()->right;
+  if (outer == middle) outer = nullptr;
+  other.UnlinkNode(middle);
+  NodeBase *ours = root();
+  NodeBase *theirs = other.root();
+  bool known = _size != kUnknownSize && other._size != kUnknownSize;
+  size_type total = known ? _size + other._size + 1 : kUnknownSize;
+  other.ResetHeader();
+  other._size = 0;
+  int height;
+  NodeBase *joined =
+      append ? JoinNodes(ours, BlackHeight(ours), middle, theirs,
+                         BlackHeight(theirs), height)
+             : JoinNodes(theirs, BlackHeight(theirs), middle, ours,
+                         BlackHeight(ours), height);
+  header()->SetParent(joined);
+  joined->SetParent(header());
+  if (append) {
+    header()->right = outer != nullptr ? outer : middle;
+  } else {
+    header()->left = outer != nullptr ? outer : middle;
+  }
+  if (known) {
+    _size = total;
+  } else {
+    SetSizeUnknown();
   }
-  --_size;
 }
 
-template <typename Key, typename T>
-T *RBTree<Key, T>::at(const Key &key) {
-  Node *result = FindNode(key);
-  if (result != TNULL) return &result->data.second;
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+template <typename K>
+T *RBTree<Key, T, Compare, R, Allocator, N>::at(const K &key) {
+  NodeBase *result = FindNode(key);
+  if (result) return &static_cast<Node *>(result)->data.second;
   return nullptr;
 }
 
-template <typename Key, typename T>
-typename RBTree<Key, T>::iterator RBTree<Key, T>::find(const Key &key) {
-  Node *result = FindNode(key);
-  if (result != TNULL) return iterator(result, TNULL);
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+template <typename K>
+typename RBTree<Key, T, Compare, R, Allocator, N>::iterator
+RBTree<Key, T, Compare, R, Allocator, N>::find(const K &key) {
+  NodeBase *result = FindNode(key);
+  if (result) return iterator(result);
   return end();
 }
 
-template <typename Key, typename T>
-void RBTree<Key, T>::clear() {
-  DeleteTree(root);
-  root = TNULL;
+// Finger search: climbs from hint only as far as needed to reach a subtree
+// that brackets key, so keys close to hint are found in O(log distance).
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+template <typename K>
+typename RBTree<Key, T, Compare, R, Allocator, N>::iterator
+RBTree<Key, T, Compare, R, Allocator, N>::FindHint(iterator hint,
+                                                   const K &key) const {
+  if (header()->parent() == nullptr) return iterator(header());
+  NodeBase *node = hint.node->IsHeader() ? header()->right : hint.node;
+  while (true) {
+    bool toLeft = Less(key, KeyOf(node));
+    if (!toLeft && !Less(KeyOf(node), key)) return iterator(node);
+    // The keys between node and key sit in node's subtree on that side,
+    // up to the first ancestor found on the other side of it.
+    NodeBase *up = node;
+    while (up->parent() != header() &&
+           up == (toLeft ? up->parent()->left : up->parent()->right)) {
+      up = up->parent();
+    }
+    NodeBase *bound = up->parent();
+    if (bound == header() ||
+        (toLeft ? Less(KeyOf(bound), key) : Less(key, KeyOf(bound)))) {
+      NodeBase *found = FindBelow(toLeft ? node->left : node->right, key);
+      return iterator(found != nullptr ? found : header());
+    }
+    node = bound;
+  }
+}
+
+// First node whose key is not less than key, or end().
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+template <typename K>
+typename RBTree<Key, T, Compare, R, Allocator, N>::iterator
+RBTree<Key, T, Compare, R, Allocator, N>::LowerBound(const K &key) const {
+  NodeBase *result = header();
+  NodeBase *current = header()->parent();
+  while (current != nullptr) {
+    if (Less(KeyOf(current), key)) {
+      current = current->right;
+    } else {
+      result = current;
+      current = current->left;
+    }
+  }
+  return iterator(result);
+}
+
+// First node whose key is greater than key, or end().
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+template <typename K>
+typename RBTree<Key, T, Compare, R, Allocator, N>::iterator
+RBTree<Key, T, Compare, R, Allocator, N>::UpperBound(const K &key) const {
+  NodeBase *result = header();
+  NodeBase *current = header()->parent();
+  while (current != nullptr) {
+    if (Less(key, KeyOf(current))) {
+      result = current;
+      current = current->left;
+    } else {
+      current = current->right;
+    }
+  }
+  return iterator(result);
+}
+
+// Looks up keys[0, count) and stores the iterator for keys[i], or end(), in
+// out[i].
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+template <typename K, typename Out>
+void RBTree<Key, T, Compare, R, Allocator, N>::FindMany(const K *keys,
+                                                        size_type count,
+                                                        Out *out) const {
+  FindBatch(keys, count, [this, out](size_type index, NodeBase *node) {
+    out[index] = iterator(node != nullptr ? node : header());
+  });
+}
+
+// Sets bit i % 64 of bits[i / 64] when keys[i] is present and clears it
+// otherwise. bits must hold (count + 63) / 64 words.
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+template <typename K>
+void RBTree<Key, T, Compare, R, Allocator, N>::ContainsMany(
+    const K *keys, size_type count, uint64_t *bits) const {
+  std::fill(bits, bits + (count + 63) / 64, uint64_t(0));
+  FindBatch(keys, count, [bits](size_type index, NodeBase *node) {
+    if (node != nullptr) bits[index / 64] |= uint64_t(1) << (index % 64);
+  });
+}
+
+// Descends for several keys at once, one level per key in turn, and
+// prefetches each next child. The cache misses of the lanes overlap instead
+// of every lookup waiting for its own chain of loads. A lane that finishes
+// takes the next key, visit(index, node or nullptr) is called once per key
+// but not in index order.
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+template <typename K, typename Visit>
+void RBTree<Key, T, Compare, R, Allocator, N>::FindBatch(const K *keys,
+                                                         size_type count,
+                                                         Visit visit) const {
+  constexpr size_type kLanes = 16;
+  NodeBase *const top = header()->parent();
+  if (top == nullptr) {
+    for (size_type index = 0; index < count; ++index) visit(index, nullptr);
+    return;
+  }
+  NodeBase *nodes[kLanes];
+  size_type indices[kLanes];
+  size_type lanes = std::min(kLanes, count);
+  size_type next = 0;
+  for (size_type lane = 0; lane < lanes; ++lane) {
+    nodes[lane] = top;
+    indices[lane] = next++;
+  }
+  for (size_type active = lanes; active > 0;) {
+    for (size_type lane = 0; lane < lanes; ++lane) {
+      NodeBase *node = nodes[lane];
+      if (node == nullptr) continue;
+      const K &key = keys[indices[lane]];
+      NodeBase *child = nullptr;
+      bool found = false;
+      if (Less(key, KeyOf(node))) {
+        child = node->left;
+      } else if (Less(KeyOf(node), key)) {
+        child = node->right;
+      } else {
+        found = true;
+      }
+      if (child == nullptr) {
+        visit(indices[lane], found ? node : nullptr);
+        if (next == count) {
+          nodes[lane] = nullptr;
+          --active;
+          continue;
+        }
+        child = top;
+        indices[lane] = next++;
+      }
+      NodeBase::Prefetch(child);
+      nodes[lane] = child;
+    }
+  }
+}
+
+// The nodes of the top depth levels in key order. Those levels of a red-black
+// tree are complete up to its black height, so the pivots cut the keys into
+// parts of comparable size.
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+std::vector<typename RBTree<Key, T, Compare, R, Allocator, N>::iterator>
+RBTree<Key, T, Compare, R, Allocator, N>::Pivots(int depth) const {
+  std::vector<iterator> pivots;
+  CollectPivots(header()->parent(), depth, pivots);
+  return pivots;
+}
+
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+void RBTree<Key, T, Compare, R, Allocator, N>::clear() {
+  ReleaseTree();
+  ResetHeader();
   _size = 0;
+  SetSmall(true);
 }
 
-template <typename Key, typename T>
-typename RBTree<Key, T>::iterator RBTree<Key, T>::begin() {
-  return iterator(Minimum(root), TNULL);
+// Detaches the nodes and their pool in O(1) and leaves destroying them to the
+// thread of reclaimer. Small trees are cleared in place. If the job cannot be
+// handed over, the nodes are destroyed right here.
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+void RBTree<Key, T, Compare, R, Allocator, N>::ClearAsync(
+    Reclaimer &reclaimer) {
+  if (empty() || IsSmall()) {
+    clear();
+    return;
+  }
+  Retired *retired = new Retired{
+      Teardown(kWalkToRelease || pool_.Shared() ? root() : nullptr),
+      std::move(pool_)};
+  pool_ = allocator_type();
+  ResetHeader();
+  _size = 0;
+  SetSmall(true);
+  try {
+    reclaimer.Retire(retired, &Retired::Run);
+  } catch (...) {
+    Retired::Run(retired, std::numeric_limits<size_t>::max());
+  }
 }
 
-template <typename Key, typename T>
-typename RBTree<Key, T>::iterator RBTree<Key, T>::end() {
-  return ++iterator(Maximum(root), TNULL);
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+std::pair<typename RBTree<Key, T, Compare, R, Allocator, N>::iterator,
+          typename RBTree<Key, T, Compare, R, Allocator, N>::size_type>
+RBTree<Key, T, Compare, R, Allocator, N>::Select(size_type index) const {
+  static_assert(R != Ranking::NONE, "Select needs a ranked tree");
+  NodeBase *current = header()->parent();
+  while (current != nullptr) {
+    size_type leftWeight = Weight(current->left);
+    if (index < leftWeight) {
+      current = current->left;
+      continue;
+    }
+    index -= leftWeight;
+    size_type own = OwnWeight(current);
+    if (index < own) return std::make_pair(iterator(current), index);
+    index -= own;
+    current = current->right;
+  }
+  return std::make_pair(iterator(header()), size_type(0));
 }
 
-template <typename Key, typename T>
-typename RBTree<Key, T>::Node *&RBTree<Key, T>::FindNode(const Key &key) {
-  Node **current = &root;
-  while (*current != TNULL) {
-    if (key < (*current)->data.first) {
-      current = &(*current)->left;
-    } else if ((*current)->data.first < key) {
-      current = &(*current)->right;
+// Total weight of the nodes whose keys are less than key.
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+typename RBTree<Key, T, Compare, R, Allocator, N>::size_type
+RBTree<Key, T, Compare, R, Allocator, N>::Rank(const Key &key) const {
+  static_assert(R != Ranking::NONE, "Rank needs a ranked tree");
+  size_type rank = 0;
+  const NodeBase *current = header()->parent();
+  while (current != nullptr) {
+    if (Less(KeyOf(current), key)) {
+      rank += Weight(current->left) + OwnWeight(current);
+      current = current->right;
     } else {
-      return *current;
+      current = current->left;
     }
   }
-  return *current;
+  return rank;
 }
 
-template <typename Key, typename T>
-typename RBTree<Key, T>::Node *RBTree<Key, T>::InsertNode(const Key &key,
-                                                          const T &value) {
-  Node *newNode = new Node;
-  newNode->data = std::make_pair(key, value);
-  newNode->left = TNULL;
-  newNode->right = TNULL;
-  if (root == TNULL) {
-    root = newNode;
-    return newNode;
+// Must be called after the payload of a PAYLOAD-ranked node changed.
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+void RBTree<Key, T, Compare, R, Allocator, N>::UpdateWeight(iterator pos) {
+  if constexpr (R != Ranking::NONE) RecountPath(&*pos);
+}
+
+// Walks the whole tree for its height. bytes is what the allocator holds for
+// the nodes, or their total size if it does not keep track, plus the header.
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+RBTreeStats RBTree<Key, T, Compare, R, Allocator, N>::Stats() const {
+  RBTreeStats stats;
+  stats.height = Height(root());
+  stats.blackHeight = BlackHeight(root());
+  stats.nodes = size();
+  stats.bytes = std::max(pool_.bytes(), stats.nodes * sizeof(Node)) +
+                sizeof(NodeBase);
+#ifdef S21_RBTREE_STATS
+  stats.comparisons = counters_.Get(RBTreeCounter::COMPARISONS);
+  stats.rotations = counters_.Get(RBTreeCounter::ROTATIONS);
+  stats.fixInsertCalls = counters_.Get(RBTreeCounter::FIX_INSERT_CALLS);
+  stats.fixInsertLevels = counters_.Get(RBTreeCounter::FIX_INSERT_LEVELS);
+  stats.fixDeleteCalls = counters_.Get(RBTreeCounter::FIX_DELETE_CALLS);
+  stats.fixDeleteIterations =
+      counters_.Get(RBTreeCounter::FIX_DELETE_ITERATIONS);
+#endif
+  return stats;
+}
+
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+void RBTree<Key, T, Compare, R, Allocator, N>::ResetHeader() {
+  header()->SetParent(nullptr);
+  header()->left = header();
+  header()->right = header();
+  header()->SetColor(Color::RED);
+}
+
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+void RBTree<Key, T, Compare, R, Allocator, N>::SetRoot(NodeBase *node) {
+  if (node == nullptr) {
+    ResetHeader();
+    return;
+  }
+  header()->SetParent(node);
+  node->SetParent(header());
+  header()->left = NodeBase::Minimum(node);
+  header()->right = NodeBase::Maximum(node);
+}
+
+// Hangs a tree whose extreme nodes are already known under the header.
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+void RBTree<Key, T, Compare, R, Allocator, N>::Attach(NodeBase *top,
+                                                      NodeBase *first,
+                                                      NodeBase *last) {
+  if (top == nullptr) {
+    ResetHeader();
+    return;
+  }
+  header()->SetParent(top);
+  top->SetParent(header());
+  header()->left = first;
+  header()->right = last;
+}
+
+// Exchanges the nodes and sizes of the trees in O(1). The headers stay where
+// they are, end() iterators keep pointing at their own tree.
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+void RBTree<Key, T, Compare, R, Allocator, N>::SwapNodes(RBTree &other) {
+  NodeBase *top = root();
+  NodeBase *first = header()->left;
+  NodeBase *last = header()->right;
+  Attach(other.root(), other.header()->left, other.header()->right);
+  other.Attach(top, first, last);
+  std::swap(_size, other._size);
+  size_type counted = counted_.load(std::memory_order_relaxed);
+  counted_.store(other.counted_.load(std::memory_order_relaxed),
+                 std::memory_order_relaxed);
+  other.counted_.store(counted, std::memory_order_relaxed);
+}
+
+// Concurrent readers may both count, they store the same result.
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+typename RBTree<Key, T, Compare, R, Allocator, N>::size_type
+RBTree<Key, T, Compare, R, Allocator, N>::CountNodes() const {
+  size_type count = counted_.load(std::memory_order_relaxed);
+  if (count != kUnknownSize) return count;
+  count = 0;
+  for (NodeBase *node = header()->left; node != header();
+       node = NodeBase::Next(node)) {
+    ++count;
   }
+  counted_.store(count, std::memory_order_relaxed);
+  return count;
+}
 
-  Node *current = root;
-  Node *parent;
+// An unknown size stays unknown, unless it has been counted meanwhile or the
+// tree is left empty.
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+void RBTree<Key, T, Compare, R, Allocator, N>::AddToSize(int delta) {
+  if (_size == kUnknownSize) {
+    size_type counted = counted_.load(std::memory_order_relaxed);
+    if (counted != kUnknownSize) {
+      _size = counted;
+    } else {
+      if (root() == nullptr) _size = 0;
+      return;
+    }
+  }
+  _size += delta;
+}
 
-  while (current != TNULL) {
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+template <typename K>
+typename RBTree<Key, T, Compare, R, Allocator, N>::NodeBase *
+RBTree<Key, T, Compare, R, Allocator, N>::FindBelow(NodeBase *current,
+                                                    const K &key) const {
+  while (current != nullptr) {
+    if (Less(key, KeyOf(current))) {
+      current = current->left;
+    } else if (Less(KeyOf(current), key)) {
+      current = current->right;
+    } else {
+      return current;
+    }
+  }
+  return nullptr;
+}
+
+// Returns the node holding key, or nullptr together with the place where a
+// node for key has to be attached.
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+typename RBTree<Key, T, Compare, R, Allocator, N>::NodeBase *
+RBTree<Key, T, Compare, R, Allocator, N>::FindInsertPos(const Key &key,
+                                                        NodeBase *&parent,
+                                                        bool &left) const {
+  NodeBase *current = header()->parent();
+  parent = header();
+  left = true;
+
+  while (current != nullptr) {
     parent = current;
-    if (key < current->data.first) {
+    if (Less(key, KeyOf(current))) {
       current = current->left;
-    } else if (current->data.first < key) {
+      left = true;
+    } else if (Less(KeyOf(current), key)) {
       current = current->right;
+      left = false;
     } else {
-      delete newNode;
-      throw std::logic_error("Key already exists");
+      return current;
     }
   }
+  return nullptr;
+}
 
-  if (key < parent->data.first) {
-    parent->left = newNode;
+// Like FindInsertPos, but first checks whether the new node belongs right
+// before or after hint. Appending with hint == end() is O(1) that way.
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+typename RBTree<Key, T, Compare, R, Allocator, N>::NodeBase *
+RBTree<Key, T, Compare, R, Allocator, N>::FindInsertPosHint(NodeBase *hint,
+                                                            const Key &key,
+                                                            NodeBase *&parent,
+                                                            bool &left) const {
+  if (hint->IsHeader()) {
+    if (_size > 0 && Less(KeyOf(header()->right), key)) {
+      parent = header()->right;
+      left = false;
+      return nullptr;
+    }
+  } else if (Less(key, KeyOf(hint))) {
+    NodeBase *before = hint == header()->left ? nullptr : NodeBase::Prev(hint);
+    if (before == nullptr || Less(KeyOf(before), key)) {
+      left = hint->left == nullptr;
+      parent = left ? hint : before;
+      return nullptr;
+    }
+  } else if (Less(KeyOf(hint), key)) {
+    NodeBase *after = hint == header()->right ? nullptr : NodeBase::Next(hint);
+    if (after == nullptr || Less(key, KeyOf(after))) {
+      left = hint->right != nullptr;
+      parent = left ? after : hint;
+      return nullptr;
+    }
   } else {
-    parent->right = newNode;
+    return hint;
   }
-  newNode->parent = parent;
-
-  return newNode;
+  return FindInsertPos(key, parent, left);
 }
 
-template <typename Key, typename T>
-typename RBTree<Key, T>::Node *RBTree<Key, T>::CopyTree(const Node *from,
-                                                        const Node *fTNULL) {
-  if (from == fTNULL) return TNULL;
-  Node *to = new Node;
-  to->color = from->color;
-  to->data = from->data;
-  if (from->left != fTNULL) {
-    to->left = CopyTree(from->left, fTNULL);
-    to->left->parent = to;
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+void RBTree<Key, T, Compare, R, Allocator, N>::LinkNode(NodeBase *node,
+                                                        NodeBase *parent,
+                                                        bool left) {
+  node->SetParent(parent);
+  if (parent == header()) {
+    header()->SetParent(node);
+    header()->left = node;
+    header()->right = node;
+  } else if (left) {
+    parent->left = node;
+    if (parent == header()->left) header()->left = node;
   } else {
-    to->left = TNULL;
+    parent->right = node;
+    if (parent == header()->right) header()->right = node;
   }
-  if (from->right != fTNULL) {
-    to->right = CopyTree(from->right, fTNULL);
-    to->right->parent = to;
-  } else {
-    to->right = TNULL;
+  if constexpr (R != Ranking::NONE) {
+    size_type own = OwnWeight(node);
+    static_cast<Node *>(node)->weight = own;
+    for (NodeBase *up = parent; up != header(); up = up->parent()) {
+      static_cast<Node *>(up)->weight += own;
+    }
   }
-  return to;
+  Count(RBTreeCounter::FIX_INSERT_CALLS);
+  Balance().FixInsert(node);
+  AddToSize(1);
 }
 
-template <typename Key, typename T>
-void RBTree<Key, T>::DeleteTree(Node *node) {
-  if (node == TNULL) return;
-  DeleteTree(node->left);
-  DeleteTree(node->right);
-  delete node;
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+template <typename... Args>
+typename RBTree<Key, T, Compare, R, Allocator, N>::Node *
+RBTree<Key, T, Compare, R, Allocator, N>::CreateNode(Args &&...args) {
+  void *place = pool_.Allocate();
+  try {
+    return new (place) Node(std::forward<Args>(args)...);
+  } catch (...) {
+    pool_.Deallocate(place);
+    throw;
+  }
 }
 
-template <typename Key, typename T>
-void RBTree<Key, T>::Transplant(Node *u, Node *v) {
-  if (u->parent == nullptr) {
-    root = v;
-  } else if (u == u->parent->left) {
-    u->parent->left = v;
-  } else {
-    u->parent->right = v;
-  }
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+void RBTree<Key, T, Compare, R, Allocator, N>::DestroyNode(NodeBase *node) {
+  Node *full = static_cast<Node *>(node);
+  full->~Node();
+  pool_.Deallocate(full);
+}
 
-  v->parent = u->parent;
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+template <typename Source>
+typename RBTree<Key, T, Compare, R, Allocator, N>::NodeBase *
+RBTree<Key, T, Compare, R, Allocator, N>::BuildSorted(size_type count,
+                                                      int depth, int redDepth,
+                                                      Source &source) {
+  if (count == 0) return nullptr;
+  size_type leftCount = (count - 1) / 2;
+  NodeBase *left = BuildSorted(leftCount, depth + 1, redDepth, source);
+  NodeBase *node = nullptr;
+  try {
+    node = CreateNode(source());
+    node->right = BuildSorted(count - 1 - leftCount, depth + 1, redDepth,
+                              source);
+  } catch (...) {
+    DeleteTree(left);
+    if (node != nullptr) DestroyNode(node);
+    throw;
+  }
+  node->left = left;
+  if (left != nullptr) left->SetParent(node);
+  if (node->right != nullptr) node->right->SetParent(node);
+  if constexpr (R != Ranking::NONE) Recount(node);
+  node->SetColor(depth == redDepth && depth > 0 ? Color::RED : Color::BLACK);
+  return node;
 }
 
-template <typename Key, typename T>
-typename RBTree<Key, T>::Node *RBTree<Key, T>::grandparent(Node *node) const {
-  if (node != nullptr && node->parent != nullptr)
-    return node->parent->parent;
-  else
-    return nullptr;
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+typename RBTree<Key, T, Compare, R, Allocator, N>::NodeBase *
+RBTree<Key, T, Compare, R, Allocator, N>::CopyTree(const NodeBase *from,
+                                                   NodeBase *parent) {
+  NodeBase *top = CloneNode(from, parent);
+  // Copies in preorder. Nodes whose right subtree is still to be copied wait
+  // on a stack, which is bounded by the height of the tree.
+  std::pair<const NodeBase *, NodeBase *> pending[kMaxHeight];
+  int count = 0;
+  NodeBase *to = top;
+  try {
+    while (true) {
+      if (from->right != nullptr) pending[count++] = {from, to};
+      if (from->left != nullptr) {
+        to->left = CloneNode(from->left, to);
+        from = from->left;
+        to = to->left;
+      } else if (count > 0) {
+        --count;
+        to = pending[count].second;
+        from = pending[count].first->right;
+        to->right = CloneNode(from, to);
+        to = to->right;
+      } else {
+        return top;
+      }
+    }
+  } catch (...) {
+    DeleteTree(top);
+    throw;
+  }
 }
 
-template <typename Key, typename T>
-typename RBTree<Key, T>::Node *RBTree<Key, T>::uncle(Node *node) const {
-  Node *g = grandparent(node);
+// The top levels are copied here. The subtrees below them are handed out to
+// the threads, each of which copies into a pool of its own, and are then
+// hooked to their parents. Our pool adopts the slabs of the others.
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+typename RBTree<Key, T, Compare, R, Allocator, N>::NodeBase *
+RBTree<Key, T, Compare, R, Allocator, N>::CopyTreeParallel(
+    const NodeBase *from, NodeBase *parent, const ParallelPolicy &policy) {
+  struct Cut {
+    const NodeBase *from;
+    NodeBase *parent;
+    bool left;
+    NodeBase *copy = nullptr;
+  };
+  // Some subtrees are larger than others, so there are several per thread.
+  int depth = 0;
+  while ((size_t(1) << depth) < 8 * size_t(policy.threads)) ++depth;
+  NodeBase *top = CloneNode(from, parent);
+  std::vector<Cut> cuts;
+  std::vector<RBTree> pieces;
+  std::vector<std::exception_ptr> errors(policy.threads);
+  try {
+    auto cut = [&cuts](const NodeBase *node, NodeBase *copy) {
+      if (node->left != nullptr) cuts.push_back({node->left, copy, true});
+      if (node->right != nullptr) cuts.push_back({node->right, copy, false});
+    };
+    cut(from, top);
+    for (int level = 1; level < depth; ++level) {
+      std::vector<Cut> above;
+      above.swap(cuts);
+      for (Cut &node : above) {
+        NodeBase *copy = CloneNode(node.from, node.parent);
+        (node.left ? node.parent->left : node.parent->right) = copy;
+        cut(node.from, copy);
+      }
+    }
+    pieces.reserve(policy.threads);
+    for (unsigned worker = 0; worker < policy.threads; ++worker) {
+      pieces.emplace_back(compare());
+    }
+  } catch (...) {
+    DeleteTree(top);
+    throw;
+  }
 
-  if (g == nullptr) return nullptr;
+  std::atomic<size_t> next{0};
+  auto run = [&](unsigned worker) {
+    try {
+      for (size_t part = next++; part < cuts.size(); part = next++) {
+        cuts[part].copy =
+            pieces[worker].CopyTree(cuts[part].from, cuts[part].parent);
+      }
+    } catch (...) {
+      errors[worker] = std::current_exception();
+    }
+  };
+  std::vector<std::thread> workers;
+  for (unsigned worker = 1; worker < policy.threads; ++worker) {
+    try {
+      workers.emplace_back(run, worker);
+    } catch (...) {
+      break;
+    }
+  }
+  run(0);
+  for (std::thread &worker : workers) worker.join();
 
-  if (node->parent == g->left)
-    return g->right;
-  else
-    return g->left;
+  for (Cut &node : cuts) {
+    (node.left ? node.parent->left : node.parent->right) = node.copy;
+  }
+  for (RBTree &piece : pieces) pool_.Adopt(piece.pool_);
+  for (std::exception_ptr &error : errors) {
+    if (error) {
+      DeleteTree(top);
+      std::rethrow_exception(error);
+    }
+  }
+  return top;
 }
 
-template <typename Key, typename T>
-typename RBTree<Key, T>::Node *RBTree<Key, T>::Minimum(Node *node) const {
-  if (node == TNULL) return node;
-  while (node->left != TNULL) {
-    node = node->left;
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+typename RBTree<Key, T, Compare, R, Allocator, N>::NodeBase *
+RBTree<Key, T, Compare, R, Allocator, N>::CloneNode(const NodeBase *from,
+                                                    NodeBase *parent) {
+  const Node *source = static_cast<const Node *>(from);
+  NodeBase *to = CreateNode(source->data.first, source->data.second);
+  to->SetColor(from->color());
+  to->SetParent(parent);
+  if constexpr (R != Ranking::NONE) {
+    static_cast<Node *>(to)->weight = source->weight;
   }
-  return node;
+  return to;
 }
 
-template <typename Key, typename T>
-typename RBTree<Key, T>::Node *RBTree<Key, T>::Maximum(Node *node) const {
-  if (node == TNULL) return node;
-  while (node->right != TNULL) {
-    node = node->right;
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+void RBTree<Key, T, Compare, R, Allocator, N>::DeleteTree(NodeBase *node) {
+  Teardown(node).Run(pool_, std::numeric_limits<size_t>::max());
+}
+
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+bool RBTree<Key, T, Compare, R, Allocator, N>::Teardown::Run(
+    allocator_type &pool, size_t budget) {
+  for (; node != nullptr && budget > 0; --budget) {
+    NodeBase *left = node->left;
+    NodeBase *right = node->right;
+    Node *full = static_cast<Node *>(node);
+    full->~Node();
+    pool.Deallocate(full);
+    if (left != nullptr) {
+      if (right != nullptr) pending[count++] = right;
+      node = left;
+    } else if (right != nullptr) {
+      node = right;
+    } else {
+      node = count > 0 ? pending[--count] : nullptr;
+    }
   }
-  return node;
+  return node == nullptr;
 }
 
-template <typename Key, typename T>
-void RBTree<Key, T>::TurnLeft(Node *node) {
-  Node *pivot = node->right;
-  pivot->parent = node->parent;
+// The slabs are released with the pool once the last node is destroyed.
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+bool RBTree<Key, T, Compare, R, Allocator, N>::Retired::Run(void *object,
+                                                             size_t budget) {
+  Retired *retired = static_cast<Retired *>(object);
+  if (!retired->teardown.Run(retired->pool, budget)) return false;
+  delete retired;
+  return true;
+}
 
-  if (node == this->root) this->root = pivot;
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+void RBTree<Key, T, Compare, R, Allocator, N>::ReleaseTree() {
+  if (IsSmall()) {
+    for (size_type slot = 0; slot < _size; ++slot) Slot(slot)->~Node();
+  } else if (kWalkToRelease || pool_.Shared()) {
+    DeleteTree(header()->parent());
+  }
+  pool_.Release();
+}
 
-  if (node->parent != nullptr) {
-    if (node->parent->left == node)
-      node->parent->left = pivot;
-    else
-      node->parent->right = pivot;
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+void RBTree<Key, T, Compare, R, Allocator, N>::EraseNode(NodeBase *node) {
+  if (IsSmall()) {
+    EraseSlot(SlotOf(node));
+    return;
   }
-  node->right = pivot->left;
+  UnlinkNode(node);
+  DestroyNode(node);
+}
 
-  if (pivot->left != TNULL) pivot->left->parent = node;
+// Takes the node out of the tree and rebalances, leaving it detached and
+// still alive.
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+void RBTree<Key, T, Compare, R, Allocator, N>::UnlinkNode(
+    NodeBase *nodeToDelete) {
+  if (nodeToDelete == header()->left) {
+    header()->left = nodeToDelete->right != nullptr
+                       ? NodeBase::Minimum(nodeToDelete->right)
+                       : nodeToDelete->parent();
+  }
+  if (nodeToDelete == header()->right) {
+    header()->right = nodeToDelete->left != nullptr
+                        ? NodeBase::Maximum(nodeToDelete->left)
+                        : nodeToDelete->parent();
+  }
 
-  node->parent = pivot;
-  pivot->left = node;
+  Balance().Erase(nodeToDelete);
+  nodeToDelete->SetParent(nullptr);
+  nodeToDelete->left = nullptr;
+  nodeToDelete->right = nullptr;
+  nodeToDelete->SetColor(Color::RED);
+  AddToSize(-1);
 }
 
-template <typename Key, typename T>
-void RBTree<Key, T>::TurnRight(Node *node) {
-  Node *pivot = node->left;
-  pivot->parent = node->parent;
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+void RBTree<Key, T, Compare, R, Allocator, N>::CollectPivots(
+    NodeBase *node, int depth, std::vector<iterator> &pivots) {
+  if (node == nullptr || depth == 0) return;
+  CollectPivots(node->left, depth - 1, pivots);
+  pivots.push_back(iterator(node));
+  CollectPivots(node->right, depth - 1, pivots);
+}
 
-  if (node == this->root) this->root = pivot;
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+typename RBTree<Key, T, Compare, R, Allocator, N>::size_type
+RBTree<Key, T, Compare, R, Allocator, N>::Height(const NodeBase *node) {
+  if (node == nullptr) return 0;
+  return 1 + std::max(Height(node->left), Height(node->right));
+}
 
-  if (node->parent != nullptr) {
-    if (node->parent->left == node)
-      node->parent->left = pivot;
-    else
-      node->parent->right = pivot;
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+int RBTree<Key, T, Compare, R, Allocator, N>::BlackHeight(
+    const NodeBase *node) {
+  int height = 0;
+  for (; node != nullptr; node = node->left) {
+    if (node->color() == Color::BLACK) ++height;
   }
+  return height;
+}
 
-  node->left = pivot->right;
-  if (pivot->right != TNULL) pivot->right->parent = node;
-
-  node->parent = pivot;
-  pivot->right = node;
+// Joins two subtrees and a node whose key lies between them into one valid
+// subtree, with the given black heights of the subtrees. The node is hung at
+// the spot of the taller subtree with the black height of the shorter one, so
+// the work is proportional to the difference in height. The header serves as
+// scratch parent meanwhile, as a ready tree is needed by FixInsert.
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+typename RBTree<Key, T, Compare, R, Allocator, N>::NodeBase *
+RBTree<Key, T, Compare, R, Allocator, N>::JoinNodes(
+    NodeBase *left, int leftHeight, NodeBase *middle, NodeBase *right,
+    int rightHeight, int &height) {
+  if (!IsBlack(left)) {
+    left->SetColor(Color::BLACK);
+    ++leftHeight;
+  }
+  if (!IsBlack(right)) {
+    right->SetColor(Color::BLACK);
+    ++rightHeight;
+  }
+  middle->left = nullptr;
+  middle->right = nullptr;
+  middle->SetColor(Color::RED);
+  if (leftHeight == rightHeight) {
+    middle->left = left;
+    middle->right = right;
+    if (left != nullptr) left->SetParent(middle);
+    if (right != nullptr) right->SetParent(middle);
+    middle->SetColor(Color::BLACK);
+    if constexpr (R != Ranking::NONE) Recount(middle);
+    height = leftHeight + 1;
+    return middle;
+  }
+  bool intoLeft = leftHeight > rightHeight;
+  NodeBase *taller = intoLeft ? left : right;
+  int shorterHeight = intoLeft ? rightHeight : leftHeight;
+  header()->SetParent(taller);
+  taller->SetParent(header());
+  NodeBase *parent = header();
+  NodeBase *current = taller;
+  for (int level = intoLeft ? leftHeight : rightHeight;
+       !IsBlack(current) || level != shorterHeight;) {
+    if (IsBlack(current)) --level;
+    parent = current;
+    current = intoLeft ? current->right : current->left;
+  }
+  NodeBase *shorter = intoLeft ? right : left;
+  (intoLeft ? middle->left : middle->right) = current;
+  (intoLeft ? middle->right : middle->left) = shorter;
+  if (current != nullptr) current->SetParent(middle);
+  if (shorter != nullptr) shorter->SetParent(middle);
+  middle->SetParent(parent);
+  (intoLeft ? parent->right : parent->left) = middle;
+  if constexpr (R != Ranking::NONE) {
+    Recount(middle);
+    RecountPath(parent);
+  }
+  Count(RBTreeCounter::FIX_INSERT_CALLS);
+  height = (intoLeft ? leftHeight : rightHeight) +
+           Balance().FixInsert(middle);
+  return root();
 }
 
-template <typename Key, typename T>
-void RBTree<Key, T>::FixInsert(Node *node) {
-  if (node->parent == nullptr) {
-    node->color = Color::BLACK;
-  } else if (node->parent->color == Color::RED) {
-    Node *g = grandparent(node);
-    Node *u = uncle(node);
-
-    if (u != nullptr && u->color == Color::RED) {
-      node->parent->color = Color::BLACK;
-      u->color = Color::BLACK;
-      g->color = Color::RED;
-      FixInsert(g);
-    } else {
-      if (node == node->parent->right && node->parent == g->left) {
-        TurnLeft(node->parent);
-        node = node->left;
-      } else if (node == node->parent->left && node->parent == g->right) {
-        TurnRight(node->parent);
-        node = node->right;
-      }
-      node->parent->color = Color::BLACK;
-      g->color = Color::RED;
-      if (node == node->parent->left && node->parent == g->left) {
-        TurnRight(g);
-      } else {
-        TurnLeft(g);
-      }
-    }
+// Cuts the subtree of node, whose black height is height, into the nodes with
+// keys less than key and the rest, rejoining the pieces on the way back up.
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+void RBTree<Key, T, Compare, R, Allocator, N>::SplitBelow(
+    NodeBase *node, int height, const Key &key, NodeBase *&lower,
+    int &lowerHeight, NodeBase *&upper, int &upperHeight) {
+  if (node == nullptr) {
+    lower = upper = nullptr;
+    lowerHeight = upperHeight = 0;
+    return;
+  }
+  int childHeight = height - (node->color() == Color::BLACK ? 1 : 0);
+  NodeBase *left = node->left;
+  NodeBase *right = node->right;
+  if (Less(KeyOf(node), key)) {
+    SplitBelow(right, childHeight, key, lower, lowerHeight, upper,
+               upperHeight);
+    lower = JoinNodes(left, childHeight, node, lower, lowerHeight,
+                      lowerHeight);
+  } else {
+    SplitBelow(left, childHeight, key, lower, lowerHeight, upper,
+               upperHeight);
+    upper = JoinNodes(upper, upperHeight, node, right, childHeight,
+                      upperHeight);
   }
 }
 
-template <typename Key, typename T>
-void RBTree<Key, T>::FixDelete(Node *node) {
-  while (node != root && node->color == Color::BLACK) {
-    if (node == node->parent->left) {
-      Node *sibling = node->parent->right;
-
-      if (sibling->color == Color::RED) {
-        sibling->color = Color::BLACK;
-        node->parent->color = Color::RED;
-        TurnLeft(node->parent);
-        sibling = node->parent->right;
-      }
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+typename RBTree<Key, T, Compare, R, Allocator, N>::size_type
+RBTree<Key, T, Compare, R, Allocator, N>::Weight(const NodeBase *node) {
+  if (node == nullptr) return 0;
+  return static_cast<const Node *>(node)->weight;
+}
 
-      if (sibling->left->color == Color::BLACK &&
-          sibling->right->color == Color::BLACK) {
-        sibling->color = Color::RED;
-        node = node->parent;
-      } else {
-        if (sibling->right->color == Color::BLACK) {
-          sibling->left->color = Color::BLACK;
-          sibling->color = Color::RED;
-          TurnRight(sibling);
-          sibling = node->parent->right;
-        }
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+typename RBTree<Key, T, Compare, R, Allocator, N>::size_type
+RBTree<Key, T, Compare, R, Allocator, N>::OwnWeight(const NodeBase *node) {
+  if constexpr (R == Ranking::PAYLOAD) {
+    return static_cast<size_type>(static_cast<const Node *>(node)->data.second);
+  } else {
+    return 1;
+  }
+}
 
-        sibling->color = node->parent->color;
-        node->parent->color = Color::BLACK;
-        sibling->right->color = Color::BLACK;
-        TurnLeft(node->parent);
-        node = root;
-      }
-    } else {
-      Node *sibling = node->parent->left;
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+void RBTree<Key, T, Compare, R, Allocator, N>::Recount(NodeBase *node) {
+  static_cast<Node *>(node)->weight =
+      Weight(node->left) + OwnWeight(node) + Weight(node->right);
+}
 
-      if (sibling->color == Color::RED) {
-        sibling->color = Color::BLACK;
-        node->parent->color = Color::RED;
-        TurnRight(node->parent);
-        sibling = node->parent->left;
-      }
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+void RBTree<Key, T, Compare, R, Allocator, N>::RecountPath(NodeBase *node) {
+  for (; node != header(); node = node->parent()) Recount(node);
+}
 
-      if (sibling->right->color == Color::BLACK &&
-          sibling->left->color == Color::BLACK) {
-        sibling->color = Color::RED;
-        node = node->parent;
-      } else {
-        if (sibling->left->color == Color::BLACK) {
-          sibling->right->color = Color::BLACK;
-          sibling->color = Color::RED;
-          TurnLeft(sibling);
-          sibling = node->parent->left;
-        }
+// Scans the slots for the first key not less than key, which beats a descent
+// on a few elements, and leaves its position in index. Returns its node if
+// it holds key.
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+template <typename K>
+typename RBTree<Key, T, Compare, R, Allocator, N>::NodeBase *
+RBTree<Key, T, Compare, R, Allocator, N>::FindSlot(const K &key,
+                                                   size_type &index) const {
+  for (index = 0; index < _size; ++index) {
+    if (!Less(KeyOf(Slot(index)), key)) {
+      return Less(key, KeyOf(Slot(index))) ? nullptr : Slot(index);
+    }
+  }
+  return nullptr;
+}
 
-        sibling->color = node->parent->color;
-        node->parent->color = Color::BLACK;
-        sibling->left->color = Color::BLACK;
-        TurnRight(node->parent);
-        node = root;
-      }
+// Moves the elements from index on up by one slot and constructs the new
+// one in the gap. There must be a free slot.
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+template <typename... Args>
+typename RBTree<Key, T, Compare, R, Allocator, N>::NodeBase *
+RBTree<Key, T, Compare, R, Allocator, N>::InsertSlot(size_type index,
+                                                     Args &&...args) {
+  for (size_type slot = _size; slot > index; --slot) {
+    new (Slot(slot)) Node(std::move(Slot(slot - 1)->data));
+    Slot(slot - 1)->~Node();
+  }
+  try {
+    new (Slot(index)) Node(std::forward<Args>(args)...);
+  } catch (...) {
+    for (size_type slot = index; slot < _size; ++slot) {
+      new (Slot(slot)) Node(std::move(Slot(slot + 1)->data));
+      Slot(slot + 1)->~Node();
     }
+    LinkSlots();
+    throw;
   }
-  TNULL->left = nullptr;
-  TNULL->right = nullptr;
+  ++_size;
+  LinkSlots();
+  return Slot(index);
+}
 
-  node->color = Color::BLACK;
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+void RBTree<Key, T, Compare, R, Allocator, N>::EraseSlot(size_type index) {
+  Slot(index)->~Node();
+  for (size_type slot = index + 1; slot < _size; ++slot) {
+    new (Slot(slot - 1)) Node(std::move(Slot(slot)->data));
+    Slot(slot)->~Node();
+  }
+  --_size;
+  LinkSlots();
 }
 
-template <typename Key, typename T>
-RBTreeIterator<Key, T>::RBTreeIterator(RBTreeIterator<Key, T> &&other)
-    : node(other.node), TNULL(other.TNULL), end(other.end) {
-  other.node = other.TNULL;
+// Constructs count elements produced by source() in increasing key order in
+// the slots of an empty small tree.
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+template <typename Source>
+void RBTree<Key, T, Compare, R, Allocator, N>::FillSlots(size_type count,
+                                                         Source source) {
+  try {
+    for (; _size < count; ++_size) new (Slot(_size)) Node(source());
+  } catch (...) {
+    clear();
+    throw;
+  }
+  LinkSlots();
 }
 
-template <typename Key, typename T>
-RBTreeIterator<Key, T>::RBTreeIterator(Node *start, Node *mainTNULL)
-    : node(start), TNULL(mainTNULL) {
-  if (start != mainTNULL) {
-    end = false;
+// Links the elements in the slots as a balanced tree, colored the same way
+// as by AssignSorted.
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+void RBTree<Key, T, Compare, R, Allocator, N>::LinkSlots() {
+  if (_size == 0) {
+    ResetHeader();
+    return;
   }
+  auto slot = [this](size_type index) { return Slot(index); };
+  Attach(LinkSorted(slot, 0, _size, 0, RedDepth(_size)), Slot(0),
+         Slot(_size - 1));
 }
 
-template <typename Key, typename T>
-RBTreeIterator<Key, T> &RBTreeIterator<Key, T>::operator=(
-    const RBTreeIterator<Key, T> &other) {
-  node = other.node;
-  TNULL = other.TNULL;
-  end = other.end;
-  return *this;
+// Links the nodes at(first) to at(first + count - 1), in key order.
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+template <typename NodeAt>
+typename RBTree<Key, T, Compare, R, Allocator, N>::NodeBase *
+RBTree<Key, T, Compare, R, Allocator, N>::LinkSorted(NodeAt at,
+                                                     size_type first,
+                                                     size_type count,
+                                                     int depth, int redDepth) {
+  if (count == 0) return nullptr;
+  size_type leftCount = (count - 1) / 2;
+  NodeBase *node = at(first + leftCount);
+  node->left = LinkSorted(at, first, leftCount, depth + 1, redDepth);
+  node->right = LinkSorted(at, first + leftCount + 1, count - 1 - leftCount,
+                           depth + 1, redDepth);
+  if (node->left != nullptr) node->left->SetParent(node);
+  if (node->right != nullptr) node->right->SetParent(node);
+  if constexpr (R != Ranking::NONE) Recount(node);
+  node->SetColor(depth == redDepth && depth > 0 ? Color::RED : Color::BLACK);
+  return node;
 }
 
-template <typename Key, typename T>
-RBTreeIterator<Key, T> &RBTreeIterator<Key, T>::operator=(
-    RBTreeIterator<Key, T> &&other) {
-  node = other.node;
-  TNULL = other.TNULL;
-  end = other.end;
-  other.node = other.TNULL;
-  return *this;
+// Copies the elements of other into this empty tree, into the slots if they
+// fit there.
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+void RBTree<Key, T, Compare, R, Allocator, N>::CopyNodes(
+    const RBTree &other, const ParallelPolicy &policy) {
+  if (other.empty()) return;
+  size_type count = other.size();
+  if constexpr (N > 0) {
+    if (count <= N) {
+      NodeBase *node = other.header()->left;
+      FillSlots(count, [&node]() -> const RBTreeValue<Key, T> & {
+        const Node *source = static_cast<const Node *>(node);
+        node = NodeBase::Next(node);
+        return source->data;
+      });
+      return;
+    }
+  }
+  SetSmall(false);
+  if (policy.threads > 1 && count >= policy.threshold) {
+    header()->SetParent(CopyTreeParallel(other.root(), header(), policy));
+  } else {
+    header()->SetParent(CopyTree(other.root(), header()));
+  }
+  header()->left = NodeBase::Minimum(root());
+  header()->right = NodeBase::Maximum(root());
+  _size = count;
 }
 
-template <typename Key, typename T>
-RBTreeIterator<Key, T> &RBTreeIterator<Key, T>::operator++() {
-  if (node == TNULL || node == nullptr) return *this;
-  if (end) {
-    while (node->parent != nullptr) node = node->parent;
-    while (node->right != TNULL) node = node->right;
-    return *this;
+// Takes the elements of other over into this empty tree and leaves other
+// empty. Nodes are relinked in O(1), the elements of a small tree are moved.
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+void RBTree<Key, T, Compare, R, Allocator, N>::TakeNodes(RBTree &other) {
+  if (other.IsSmall()) {
+    size_type next = 0;
+    FillSlots(other._size, [&other, &next]() {
+      return std::move(other.Slot(next++)->data);
+    });
+    other.clear();
+    return;
   }
-  if (node->right == TNULL) {
-    Node *parent = node->parent;
-    while (parent && parent->right == node) {
-      node = parent;
-      parent = node->parent;
+  SetSmall(false);
+  SwapNodes(other);
+  other.SetSmall(true);
+}
+
+// Moves the elements out of the slots into nodes from the allocator. The tree
+// keeps using nodes from then on, however small it gets, until it is cleared.
+// All nodes are allocated before the first element moves, and moves do not
+// throw, so a failure leaves the slots as they were.
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+void RBTree<Key, T, Compare, R, Allocator, N>::Promote() {
+  if constexpr (N > 0) {
+    if (!IsSmall()) return;
+    void *places[N];
+    size_type count = 0;
+    try {
+      pool_.Reserve(_size);
+      for (; count < _size; ++count) places[count] = pool_.Allocate();
+    } catch (...) {
+      while (count > 0) pool_.Deallocate(places[--count]);
+      throw;
     }
-    if (parent == nullptr) {
-      while (node->right != TNULL) node = node->right;
-      end = true;
-      return *this;
+    for (size_type slot = 0; slot < _size; ++slot) {
+      places[slot] = new (places[slot]) Node(std::move(Slot(slot)->data));
+      Slot(slot)->~Node();
     }
-    node = parent;
-  } else {
-    node = node->right;
-    while (node->left != TNULL) node = node->left;
+    auto node = [&places](size_type index) {
+      return static_cast<Node *>(places[index]);
+    };
+    NodeBase *top = LinkSorted(node, 0, _size, 0, RedDepth(_size));
+    SetSmall(false);
+    SetRoot(top);
   }
-  return *this;
+}
+
+// Depth of the lowest level of a balanced tree of count nodes, the level that
+// the sorted builds color red.
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+int RBTree<Key, T, Compare, R, Allocator, N>::RedDepth(size_type count) {
+  int depth = 0;
+  for (; count > 1; count >>= 1) ++depth;
+  return depth;
 }
 
 template <typename Key, typename T>
@@ -579,32 +2198,6 @@ RBTreeIterator<Key, T> RBTreeIterator<Key, T>::operator++(int) {
   return result;
 }
 
-template <typename Key, typename T>
-RBTreeIterator<Key, T> &RBTreeIterator<Key, T>::operator--() {
-  if (node == TNULL || node == nullptr) return *this;
-  if (end) {
-    while (node->parent != nullptr) node = node->parent;
-    while (node->right != TNULL) node = node->right;
-    end = false;
-  } else if (node->left == TNULL) {
-    Node *parent = node->parent;
-    while (parent && parent->left == node) {
-      node = parent;
-      parent = node->parent;
-    }
-    if (parent == nullptr) {
-      while (node->right != TNULL) node = node->right;
-      end = true;
-      return *this;
-    }
-    node = parent;
-  } else {
-    node = node->left;
-    while (node->right != TNULL) node = node->right;
-  }
-  return *this;
-}
-
 template <typename Key, typename T>
 RBTreeIterator<Key, T> RBTreeIterator<Key, T>::operator--(int) {
   RBTreeIterator result(*this);
@@ -612,24 +2205,6 @@ RBTreeIterator<Key, T> RBTreeIterator<Key, T>::operator--(int) {
   return result;
 }
 
-template <typename Key, typename T>
-typename RBTreeIterator<Key, T>::Node &RBTreeIterator<Key, T>::operator*() {
-  if (end) {
-    while (node->parent != nullptr) node = node->parent;
-    while (node->right != TNULL) node = node->right;
-  }
-  return *node;
-}
-
-template <typename Key, typename T>
-typename RBTreeIterator<Key, T>::Node *RBTreeIterator<Key, T>::operator->() {
-  if (end) {
-    while (node->parent != nullptr) node = node->parent;
-    while (node->right != TNULL) node = node->right;
-  }
-  return node;
-}
-
 }  // namespace s21
 
 #endif  // CPP2_S21_CONTAINERS_1_SRC_RBTREE_RBTREE_H_
@@ -0,0 +1,95 @@
+#ifndef CPP2_S21_CONTAINERS_1_SRC_RBTREE_RBTREEARCHIVE_H_
+#define CPP2_S21_CONTAINERS_1_SRC_RBTREE_RBTREEARCHIVE_H_
+
+#include <cstring>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "RBTree.h"
+#include "TreeArchive.h"
+
+namespace s21 {
+
+// Save and load of trees, and so of maps, sets and multisets. Only code that
+// calls them includes this header, which brings in the POSIX file API.
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+class RBTreeArchive<RBTree<Key, T, Compare, R, Allocator, N>> {
+ public:
+  using Tree = RBTree<Key, T, Compare, R, Allocator, N>;
+
+  static void Save(const Tree &tree, const std::string &path,
+                   ArchiveKind kind);
+  template <typename Visit>
+  static void Load(Tree &tree, const std::string &path, ArchiveKind kind,
+                   Visit visit);
+
+ private:
+  using NodeBase = typename Tree::NodeBase;
+  using Node = typename Tree::Node;
+};
+
+// Writes the nodes in key order into an archive, see TreeArchive.h. Keys
+// and mapped values are written as they are in memory.
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+void RBTreeArchive<RBTree<Key, T, Compare, R, Allocator, N>>::Save(
+    const Tree &tree, const std::string &path, ArchiveKind kind) {
+  static_assert(std::is_trivially_copyable_v<Key> &&
+                    std::is_trivially_copyable_v<T>,
+                "Only trees of trivially copyable types can be saved");
+  TreeArchiveWriter out(path, static_cast<uint32_t>(kind), sizeof(Key),
+                        Tree::kValueSize, tree.size());
+  for (NodeBase *node = tree.header()->left; node != tree.header();
+       node = NodeBase::Next(node)) {
+    const auto &data = static_cast<const Node *>(node)->data;
+    if constexpr (Tree::kValueSize == 0) {
+      out.Append(data.first);
+    } else {
+      out.Append(data.first, data.second);
+    }
+  }
+  out.Commit();
+}
+
+// Replaces the contents with an archive written by Save() with the same kind
+// and types. visit(data) is called for every element read and returns false
+// for a record the container cannot hold. The nodes are laid out with the
+// sorted build straight from the mapped file. If the file cannot be read,
+// does not match or is damaged, the tree is left unchanged.
+template <typename Key, typename T, typename Compare, Ranking R,
+          template <typename> class Allocator, size_t N>
+template <typename Visit>
+void RBTreeArchive<RBTree<Key, T, Compare, R, Allocator, N>>::Load(
+    Tree &tree, const std::string &path, ArchiveKind kind, Visit visit) {
+  static_assert(std::is_trivially_copyable_v<Key> &&
+                    std::is_trivially_copyable_v<T>,
+                "Only trees of trivially copyable types can be loaded");
+  TreeArchiveReader in(path, static_cast<uint32_t>(kind), sizeof(Key),
+                       Tree::kValueSize);
+  const Compare &compare = tree.compare();
+  Tree loaded(compare);
+  std::optional<Key> previous;
+  loaded.AssignSorted(in.count(), [&]() {
+    const unsigned char *record = in.Next();
+    Key key;
+    std::memcpy(&key, record, sizeof(Key));
+    if (previous.has_value() && !compare(*previous, key)) {
+      in.Invalid("keys out of order");
+    }
+    previous = key;
+    RBTreeValue<Key, T> data(key, T());
+    if constexpr (Tree::kValueSize != 0) {
+      std::memcpy(&data.second, record + sizeof(Key), sizeof(T));
+    }
+    if (!visit(std::as_const(data))) in.Invalid("invalid record");
+    return data;
+  });
+  tree = std::move(loaded);
+}
+
+}  // namespace s21
+
+#endif  // CPP2_S21_CONTAINERS_1_SRC_RBTREE_RBTREEARCHIVE_H_
@@ -0,0 +1,254 @@
+#ifndef CPP2_S21_CONTAINERS_1_SRC_RBTREE_RBTREEBALANCE_H_
+#define CPP2_S21_CONTAINERS_1_SRC_RBTREE_RBTREEBALANCE_H_
+
+namespace s21 {
+
+enum class Color { RED, BLACK };
+
+enum class RBTreeCounter {
+  COMPARISONS,
+  ROTATIONS,
+  FIX_INSERT_CALLS,
+  FIX_INSERT_LEVELS,
+  FIX_DELETE_CALLS,
+  FIX_DELETE_ITERATIONS,
+  COUNT
+};
+
+// Red-black rebalancing for any node layout. Links reaches the links of a
+// node, which may be pointers as in RBTree or indices as in mapped_map:
+//
+//   using Link = ...;              a node, Nil() for a leaf
+//   Link Nil() const;
+//   Link Left(Link), Right(Link), Parent(Link) const;
+//   void SetLeft(Link, Link), SetRight(Link, Link), SetParent(Link, Link);
+//   Color GetColor(Link) const;    never asked for Nil()
+//   void SetColor(Link, Color);
+//   Link Root() const;
+//   void SetRoot(Link);
+//   void Turned(Link node, Link pivot);   after pivot took the place of node
+//   void Unlinked(Link parent);   after Erase took a node from under parent
+//   void Count(RBTreeCounter) const;
+//
+// The parent of the root is whatever the layout keeps there, a header or
+// Nil(), it is only passed along.
+template <typename Links>
+class RBTreeBalance {
+ public:
+  using Link = typename Links::Link;
+
+  explicit RBTreeBalance(Links links) : links_(links) {}
+
+  Link Minimum(Link node) const;
+  Link Maximum(Link node) const;
+  // In order neighbours for layouts where the root has Nil() for a parent,
+  // which also ends the walk.
+  Link Next(Link node) const;
+  Link Prev(Link node) const;
+
+  // Puts v in the place of u under u's parent.
+  void Transplant(Link u, Link v);
+  void TurnLeft(Link node);
+  void TurnRight(Link node);
+  // Rebalances after node was linked in red. Returns true when the root had
+  // to be recolored, which adds one to the black height of the tree.
+  bool FixInsert(Link node);
+  // Takes node out of the tree and rebalances. Its own links are left as
+  // they were.
+  void Erase(Link node);
+
+ private:
+  bool IsBlack(Link node) const {
+    return node == links_.Nil() || links_.GetColor(node) == Color::BLACK;
+  }
+  void FixDelete(Link node, Link parent);
+
+  Links links_;
+};
+
+template <typename Links>
+typename RBTreeBalance<Links>::Link RBTreeBalance<Links>::Minimum(
+    Link node) const {
+  while (links_.Left(node) != links_.Nil()) node = links_.Left(node);
+  return node;
+}
+
+template <typename Links>
+typename RBTreeBalance<Links>::Link RBTreeBalance<Links>::Maximum(
+    Link node) const {
+  while (links_.Right(node) != links_.Nil()) node = links_.Right(node);
+  return node;
+}
+
+template <typename Links>
+typename RBTreeBalance<Links>::Link RBTreeBalance<Links>::Next(
+    Link node) const {
+  if (links_.Right(node) != links_.Nil()) return Minimum(links_.Right(node));
+  Link parent = links_.Parent(node);
+  while (parent != links_.Nil() && node == links_.Right(parent)) {
+    node = parent;
+    parent = links_.Parent(parent);
+  }
+  return parent;
+}
+
+template <typename Links>
+typename RBTreeBalance<Links>::Link RBTreeBalance<Links>::Prev(
+    Link node) const {
+  if (links_.Left(node) != links_.Nil()) return Maximum(links_.Left(node));
+  Link parent = links_.Parent(node);
+  while (parent != links_.Nil() && node == links_.Left(parent)) {
+    node = parent;
+    parent = links_.Parent(parent);
+  }
+  return parent;
+}
+
+template <typename Links>
+void RBTreeBalance<Links>::Transplant(Link u, Link v) {
+  Link parent = links_.Parent(u);
+  if (u == links_.Root()) {
+    links_.SetRoot(v);
+  } else if (u == links_.Left(parent)) {
+    links_.SetLeft(parent, v);
+  } else {
+    links_.SetRight(parent, v);
+  }
+  if (v != links_.Nil()) links_.SetParent(v, parent);
+}
+
+template <typename Links>
+void RBTreeBalance<Links>::TurnLeft(Link node) {
+  links_.Count(RBTreeCounter::ROTATIONS);
+  Link pivot = links_.Right(node);
+  Link inner = links_.Left(pivot);
+  Transplant(node, pivot);
+  links_.SetRight(node, inner);
+  if (inner != links_.Nil()) links_.SetParent(inner, node);
+  links_.SetLeft(pivot, node);
+  links_.SetParent(node, pivot);
+  links_.Turned(node, pivot);
+}
+
+template <typename Links>
+void RBTreeBalance<Links>::TurnRight(Link node) {
+  links_.Count(RBTreeCounter::ROTATIONS);
+  Link pivot = links_.Left(node);
+  Link inner = links_.Right(pivot);
+  Transplant(node, pivot);
+  links_.SetLeft(node, inner);
+  if (inner != links_.Nil()) links_.SetParent(inner, node);
+  links_.SetRight(pivot, node);
+  links_.SetParent(node, pivot);
+  links_.Turned(node, pivot);
+}
+
+template <typename Links>
+bool RBTreeBalance<Links>::FixInsert(Link node) {
+  while (true) {
+    links_.Count(RBTreeCounter::FIX_INSERT_LEVELS);
+    if (node == links_.Root()) {
+      bool grew = links_.GetColor(node) == Color::RED;
+      links_.SetColor(node, Color::BLACK);
+      return grew;
+    }
+    Link parent = links_.Parent(node);
+    if (links_.GetColor(parent) != Color::RED) return false;
+    // A red parent is not the root, so the grandparent is a node.
+    Link grand = links_.Parent(parent);
+    bool leftSide = parent == links_.Left(grand);
+    Link uncle = leftSide ? links_.Right(grand) : links_.Left(grand);
+    if (!IsBlack(uncle)) {
+      // Recoloring moves the red violation two levels up.
+      links_.SetColor(parent, Color::BLACK);
+      links_.SetColor(uncle, Color::BLACK);
+      links_.SetColor(grand, Color::RED);
+      node = grand;
+      continue;
+    }
+    if (node == (leftSide ? links_.Right(parent) : links_.Left(parent))) {
+      leftSide ? TurnLeft(parent) : TurnRight(parent);
+      parent = node;
+    }
+    links_.SetColor(parent, Color::BLACK);
+    links_.SetColor(grand, Color::RED);
+    leftSide ? TurnRight(grand) : TurnLeft(grand);
+    return false;
+  }
+}
+
+template <typename Links>
+void RBTreeBalance<Links>::Erase(Link node) {
+  Color removed = links_.GetColor(node);
+  Link child;
+  Link parent;
+  if (links_.Left(node) == links_.Nil()) {
+    child = links_.Right(node);
+    parent = links_.Parent(node);
+    Transplant(node, child);
+  } else if (links_.Right(node) == links_.Nil()) {
+    child = links_.Left(node);
+    parent = links_.Parent(node);
+    Transplant(node, child);
+  } else {
+    Link next = Minimum(links_.Right(node));
+    removed = links_.GetColor(next);
+    child = links_.Right(next);
+    parent = next;
+    if (links_.Parent(next) != node) {
+      parent = links_.Parent(next);
+      Transplant(next, child);
+      links_.SetRight(next, links_.Right(node));
+      links_.SetParent(links_.Right(next), next);
+    }
+    Transplant(node, next);
+    links_.SetLeft(next, links_.Left(node));
+    links_.SetParent(links_.Left(next), next);
+    links_.SetColor(next, links_.GetColor(node));
+  }
+  links_.Unlinked(parent);
+  if (removed == Color::BLACK) FixDelete(child, parent);
+}
+
+// node took the place of a removed black node and is short of one black. It
+// may be a leaf, so its parent is passed along.
+template <typename Links>
+void RBTreeBalance<Links>::FixDelete(Link node, Link parent) {
+  links_.Count(RBTreeCounter::FIX_DELETE_CALLS);
+  while (node != links_.Root() && IsBlack(node)) {
+    links_.Count(RBTreeCounter::FIX_DELETE_ITERATIONS);
+    bool leftSide = node == links_.Left(parent);
+    Link sibling = leftSide ? links_.Right(parent) : links_.Left(parent);
+    if (links_.GetColor(sibling) == Color::RED) {
+      links_.SetColor(sibling, Color::BLACK);
+      links_.SetColor(parent, Color::RED);
+      leftSide ? TurnLeft(parent) : TurnRight(parent);
+      sibling = leftSide ? links_.Right(parent) : links_.Left(parent);
+    }
+    Link near = leftSide ? links_.Left(sibling) : links_.Right(sibling);
+    Link far = leftSide ? links_.Right(sibling) : links_.Left(sibling);
+    if (IsBlack(near) && IsBlack(far)) {
+      links_.SetColor(sibling, Color::RED);
+      node = parent;
+      parent = links_.Parent(node);
+      continue;
+    }
+    if (IsBlack(far)) {
+      links_.SetColor(near, Color::BLACK);
+      links_.SetColor(sibling, Color::RED);
+      leftSide ? TurnRight(sibling) : TurnLeft(sibling);
+      far = sibling;
+      sibling = near;
+    }
+    links_.SetColor(sibling, links_.GetColor(parent));
+    links_.SetColor(parent, Color::BLACK);
+    links_.SetColor(far, Color::BLACK);
+    leftSide ? TurnLeft(parent) : TurnRight(parent);
+    node = links_.Root();
+  }
+  if (node != links_.Nil()) links_.SetColor(node, Color::BLACK);
+}
+
+}  // namespace s21
+
+#endif  // CPP2_S21_CONTAINERS_1_SRC_RBTREE_RBTREEBALANCE_H_
@@ -0,0 +1,132 @@
+#ifndef CPP2_S21_CONTAINERS_1_SRC_RBTREE_RECLAIMER_H_
+#define CPP2_S21_CONTAINERS_1_SRC_RBTREE_RECLAIMER_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+namespace s21 {
+
+// Frees memory on a background thread. A container hands over a detached
+// part of itself, which the thread then takes apart, one job after the other.
+// The thread starts with the first job and runs until the reclaimer is
+// destroyed, which finishes all jobs first.
+class Reclaimer {
+ public:
+  // Jobs are run in steps of at most batch units of work, nodes for the
+  // trees, with a pause after every step that left the job unfinished.
+  struct Throttle {
+    size_t batch = std::numeric_limits<size_t>::max();
+    std::chrono::microseconds pause{0};
+  };
+
+  Reclaimer() {}
+  explicit Reclaimer(Throttle throttle) : throttle_(throttle) {}
+  Reclaimer(const Reclaimer &other) = delete;
+  Reclaimer &operator=(const Reclaimer &other) = delete;
+  ~Reclaimer();
+
+  // The reclaimer of containers that are not given one of their own.
+  static Reclaimer &Global();
+
+  // run does at most budget units of work on object per call and returns
+  // true once object is gone.
+  void Retire(void *object, bool (*run)(void *object, size_t budget));
+  // Blocks until every job retired so far is done.
+  void Wait();
+  size_t Pending() const;
+  void SetThrottle(Throttle throttle);
+
+ private:
+  struct Job {
+    void *object;
+    bool (*run)(void *object, size_t budget);
+  };
+
+  void Work();
+
+  mutable std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable idle_;
+  std::deque<Job> jobs_;
+  Throttle throttle_;
+  bool stop_ = false;
+  std::thread thread_;
+};
+
+inline Reclaimer::~Reclaimer() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  wake_.notify_one();
+  if (thread_.joinable()) thread_.join();
+}
+
+inline Reclaimer &Reclaimer::Global() {
+  static Reclaimer reclaimer;
+  return reclaimer;
+}
+
+inline void Reclaimer::Retire(void *object,
+                              bool (*run)(void *object, size_t budget)) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    jobs_.push_back({object, run});
+    if (!thread_.joinable()) {
+      try {
+        thread_ = std::thread(&Reclaimer::Work, this);
+      } catch (...) {
+        jobs_.pop_back();
+        throw;
+      }
+    }
+  }
+  wake_.notify_one();
+}
+
+inline void Reclaimer::Wait() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  idle_.wait(lock, [this]() { return jobs_.empty(); });
+}
+
+inline size_t Reclaimer::Pending() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return jobs_.size();
+}
+
+inline void Reclaimer::SetThrottle(Throttle throttle) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  throttle_ = throttle;
+}
+
+// The job in progress stays at the front of the queue, so that Wait() and
+// Pending() see it. Once the reclaimer is being destroyed the throttle no
+// longer applies.
+inline void Reclaimer::Work() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    wake_.wait(lock, [this]() { return stop_ || !jobs_.empty(); });
+    if (jobs_.empty()) return;
+    Job job = jobs_.front();
+    Throttle throttle = stop_ ? Throttle() : throttle_;
+    lock.unlock();
+    bool done = job.run(job.object, throttle.batch);
+    if (!done && throttle.pause.count() > 0) {
+      std::this_thread::sleep_for(throttle.pause);
+    }
+    lock.lock();
+    if (done) {
+      jobs_.pop_front();
+      if (jobs_.empty()) idle_.notify_all();
+    }
+  }
+}
+
+}  // namespace s21
+
+#endif  // CPP2_S21_CONTAINERS_1_SRC_RBTREE_RECLAIMER_H_
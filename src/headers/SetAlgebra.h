@@ -0,0 +1,129 @@
+#ifndef CPP2_S21_CONTAINERS_1_SRC_RBTREE_SETALGEBRA_H_
+#define CPP2_S21_CONTAINERS_1_SRC_RBTREE_SETALGEBRA_H_
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <vector>
+
+#include "RBTree.h"
+
+namespace s21 {
+
+enum class SetOperation { UNION, INTERSECTION, DIFFERENCE, SYMMETRIC };
+
+// Walks two sorted ranges side by side and yields the elements of the result
+// of op in order. On equal keys the element of the first range is taken.
+template <typename Iterator, typename Compare>
+class SetOperationCursor {
+ public:
+  using value_type = decltype(std::declval<Iterator>()->data);
+
+  SetOperationCursor(Iterator a, Iterator aEnd, Iterator b, Iterator bEnd,
+                     const Compare &comp, SetOperation op)
+      : a_(a), aEnd_(aEnd), b_(b), bEnd_(bEnd), comp_(comp), op_(op) {}
+
+  // Next element of the result, or nullptr at the end.
+  const value_type *Next() {
+    while (true) {
+      bool hasA = a_ != aEnd_;
+      bool hasB = b_ != bEnd_;
+      if (!hasA && !hasB) return nullptr;
+      if (!hasB || (hasA && comp_(a_->data.first, b_->data.first))) {
+        const value_type *value = &(a_++)->data;
+        if (op_ != SetOperation::INTERSECTION) return value;
+      } else if (!hasA || comp_(b_->data.first, a_->data.first)) {
+        const value_type *value = &(b_++)->data;
+        if (op_ == SetOperation::UNION || op_ == SetOperation::SYMMETRIC) {
+          return value;
+        }
+      } else {
+        const value_type *value = &(a_++)->data;
+        ++b_;
+        if (op_ == SetOperation::UNION || op_ == SetOperation::INTERSECTION) {
+          return value;
+        }
+      }
+    }
+  }
+
+ private:
+  Iterator a_;
+  Iterator aEnd_;
+  Iterator b_;
+  Iterator bEnd_;
+  const Compare &comp_;
+  SetOperation op_;
+};
+
+// Builds the result of op on a and b as a new tree. The key space is cut at
+// the top nodes of the larger tree into one part per thread, every part is
+// merged into a tree of its own, laid out balanced in one pass, and the parts
+// are joined in O(log n) each. Each part allocates from its own pool, so the
+// threads do not share anything but the inputs, which are only read.
+template <typename Tree>
+Tree CombineTrees(Tree &a, Tree &b, SetOperation op,
+                  const ParallelPolicy &policy) {
+  using iterator = typename Tree::iterator;
+  typename Tree::key_compare comp = a.key_comp();
+  int depth = 0;
+  if (a.size() + b.size() >= policy.threshold) {
+    while ((1u << depth) < policy.threads) ++depth;
+  }
+  std::vector<iterator> pivots = (a.size() >= b.size() ? a : b).Pivots(depth);
+  size_t parts = pivots.size() + 1;
+  std::vector<Tree> pieces;
+  pieces.reserve(parts);
+  for (size_t part = 0; part < parts; ++part) pieces.emplace_back(comp);
+
+  auto build = [&](size_t part) {
+    iterator aFirst = part == 0 ? a.begin()
+                                : a.LowerBound(pivots[part - 1]->data.first);
+    iterator bFirst = part == 0 ? b.begin()
+                                : b.LowerBound(pivots[part - 1]->data.first);
+    iterator aLast =
+        part == parts - 1 ? a.end() : a.LowerBound(pivots[part]->data.first);
+    iterator bLast =
+        part == parts - 1 ? b.end() : b.LowerBound(pivots[part]->data.first);
+    SetOperationCursor<iterator, typename Tree::key_compare> cursor(
+        aFirst, aLast, bFirst, bLast, comp, op);
+    size_t count = 0;
+    for (auto counter = cursor; counter.Next() != nullptr;) ++count;
+    pieces[part].AssignSorted(count, [&cursor]() { return *cursor.Next(); });
+  };
+
+  size_t threads = std::min<size_t>(std::max(policy.threads, 1u), parts);
+  std::vector<std::exception_ptr> errors(threads);
+  // Parts are taken in turn, so the threads that did start cover the parts
+  // of those that could not be created.
+  std::atomic<size_t> next{0};
+  auto run = [&](size_t worker) {
+    try {
+      for (size_t part = next++; part < parts; part = next++) build(part);
+    } catch (...) {
+      errors[worker] = std::current_exception();
+    }
+  };
+  std::vector<std::thread> workers;
+  for (size_t worker = 1; worker < threads; ++worker) {
+    try {
+      workers.emplace_back(run, worker);
+    } catch (...) {
+      break;
+    }
+  }
+  run(0);
+  for (std::thread &worker : workers) worker.join();
+  for (std::exception_ptr &error : errors) {
+    if (error) std::rethrow_exception(error);
+  }
+
+  Tree result(std::move(pieces[0]));
+  for (size_t part = 1; part < parts; ++part) result.Join(pieces[part]);
+  return result;
+}
+
+}  // namespace s21
+
+#endif  // CPP2_S21_CONTAINERS_1_SRC_RBTREE_SETALGEBRA_H_
@@ -0,0 +1,250 @@
+#ifndef CPP2_S21_CONTAINERS_1_SRC_RBTREE_TREEARCHIVE_H_
+#define CPP2_S21_CONTAINERS_1_SRC_RBTREE_TREEARCHIVE_H_
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace s21 {
+
+// An archive is this header followed by count records in key order. A record
+// is the key followed by the mapped value, if there is one, without padding.
+// Numbers are in the byte order of the machine that wrote the file, a file
+// of the other byte order fails the version check. The kind tells which
+// container wrote the file, see ArchiveKind in RBTree.h.
+struct TreeArchiveHeader {
+  static constexpr char kMagic[8] = {'s', '2', '1', 't', 'r', 'e', 'e', '\0'};
+  static constexpr uint32_t kVersion = 1;
+
+  char magic[8];
+  uint32_t version;
+  uint32_t kind;
+  uint32_t keySize;
+  uint32_t valueSize;
+  uint64_t count;
+  uint64_t checksum;
+};
+
+// Checksum over the records, fed one record at a time. It reads words rather
+// than bytes, so that verifying it keeps up with reading the file.
+class TreeArchiveChecksum {
+ public:
+  void Update(const unsigned char *data, size_t size) {
+    uint64_t word;
+    for (; size >= sizeof(word); data += sizeof(word), size -= sizeof(word)) {
+      std::memcpy(&word, data, sizeof(word));
+      Mix(word);
+    }
+    if (size == 0) return;
+    word = 0;
+    std::memcpy(&word, data, size);
+    Mix(word);
+  }
+  uint64_t value() const { return value_; }
+
+ private:
+  void Mix(uint64_t word) {
+    value_ = (value_ ^ word) * 0x100000001b3ull;
+    value_ ^= value_ >> 32;
+  }
+
+  uint64_t value_ = 0xcbf29ce484222325ull;
+};
+
+// Writes an archive into a temporary file next to path and renames it over
+// path once it is complete and synced, so that a failed save leaves the
+// previous archive in place.
+class TreeArchiveWriter {
+ public:
+  TreeArchiveWriter(const std::string &path, uint32_t kind, uint32_t keySize,
+                    uint32_t valueSize, uint64_t count)
+      : path_(path), temp_(path + ".tmp"), recordSize_(keySize + valueSize) {
+    header_ = TreeArchiveHeader{};
+    std::memcpy(header_.magic, TreeArchiveHeader::kMagic, sizeof(header_.magic));
+    header_.version = TreeArchiveHeader::kVersion;
+    header_.kind = kind;
+    header_.keySize = keySize;
+    header_.valueSize = valueSize;
+    header_.count = count;
+    fd_ = ::open(temp_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0) Fail();
+    buffer_.reserve(kBufferSize);
+    buffer_.resize(sizeof(header_));
+  }
+  TreeArchiveWriter(const TreeArchiveWriter &) = delete;
+  TreeArchiveWriter &operator=(const TreeArchiveWriter &) = delete;
+  ~TreeArchiveWriter() {
+    if (fd_ < 0) return;
+    ::close(fd_);
+    ::unlink(temp_.c_str());
+  }
+
+  // Appends one record made of the bytes of fields.
+  template <typename... Fields>
+  void Append(const Fields &...fields) {
+    if (buffer_.size() + recordSize_ > kBufferSize) Flush();
+    size_t start = buffer_.size();
+    (Put(fields), ...);
+    checksum_.Update(buffer_.data() + start, recordSize_);
+  }
+
+  void Commit() {
+    Flush();
+    header_.checksum = checksum_.value();
+    if (::pwrite(fd_, &header_, sizeof(header_), 0) !=
+            static_cast<ssize_t>(sizeof(header_)) ||
+        ::fsync(fd_) != 0) {
+      Fail();
+    }
+    int fd = fd_;
+    fd_ = -1;
+    if (::close(fd) != 0 || ::rename(temp_.c_str(), path_.c_str()) != 0) {
+      int error = errno;
+      ::unlink(temp_.c_str());
+      errno = error;
+      Fail();
+    }
+  }
+
+ private:
+  static constexpr size_t kBufferSize = 1 << 20;
+
+  template <typename Field>
+  void Put(const Field &field) {
+    const auto *bytes = reinterpret_cast<const unsigned char *>(&field);
+    buffer_.insert(buffer_.end(), bytes, bytes + sizeof(field));
+  }
+  void Flush() {
+    const unsigned char *data = buffer_.data();
+    size_t left = buffer_.size();
+    while (left > 0) {
+      ssize_t done = ::write(fd_, data, left);
+      if (done < 0 && errno == EINTR) continue;
+      if (done < 0) Fail();
+      data += done;
+      left -= done;
+    }
+    buffer_.clear();
+  }
+  [[noreturn]] void Fail() const {
+    throw std::system_error(errno, std::generic_category(),
+                            "s21: cannot write " + path_);
+  }
+
+  std::string path_;
+  std::string temp_;
+  size_t recordSize_;
+  int fd_ = -1;
+  TreeArchiveHeader header_;
+  TreeArchiveChecksum checksum_;
+  std::vector<unsigned char> buffer_;
+};
+
+// A whole file mapped read-only.
+class MappedFile {
+ public:
+  MappedFile(const std::string &path, int advice) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat info;
+    if (fd < 0 || ::fstat(fd, &info) != 0) Fail(fd, path);
+    size_ = info.st_size;
+    if (size_ > 0) {
+      void *data = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data == MAP_FAILED) Fail(fd, path);
+      data_ = static_cast<const unsigned char *>(data);
+      ::madvise(data, size_, advice);
+    }
+    ::close(fd);
+  }
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  ~MappedFile() {
+    if (data_ != nullptr) ::munmap(const_cast<unsigned char *>(data_), size_);
+  }
+
+  const unsigned char *data() const { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+  [[noreturn]] static void Fail(int fd, const std::string &path) {
+    int error = errno;
+    if (fd >= 0) ::close(fd);
+    throw std::system_error(error, std::generic_category(),
+                            "s21: cannot read " + path);
+  }
+
+  const unsigned char *data_ = nullptr;
+  size_t size_ = 0;
+};
+
+// Checks an archive against the container that loads it and hands out its
+// records in order. The file is mapped and advised as read sequentially, so
+// the kernel reads ahead of the sorted build and drops the pages behind it.
+class TreeArchiveReader {
+ public:
+  TreeArchiveReader(const std::string &path, uint32_t kind, uint32_t keySize,
+                    uint32_t valueSize)
+      : path_(path),
+        file_(path, MADV_SEQUENTIAL),
+        recordSize_(keySize + valueSize) {
+    if (file_.size() < sizeof(TreeArchiveHeader)) Invalid("truncated");
+    std::memcpy(&header_, file_.data(), sizeof(header_));
+    if (std::memcmp(header_.magic, TreeArchiveHeader::kMagic,
+                    sizeof(header_.magic)) != 0) {
+      Invalid("not an archive");
+    }
+    if (header_.version != TreeArchiveHeader::kVersion) {
+      Invalid("unsupported version");
+    }
+    if (header_.kind != kind ||
+        header_.keySize != keySize || header_.valueSize != valueSize) {
+      Invalid("written by another container type");
+    }
+    size_t payload = file_.size() - sizeof(header_);
+    if (payload % recordSize_ != 0 || payload / recordSize_ != header_.count) {
+      Invalid("size does not match the header");
+    }
+    next_ = file_.data() + sizeof(header_);
+    if (header_.count == 0) Verify();
+  }
+
+  uint64_t count() const { return header_.count; }
+  // The next record. Reading the last one verifies the checksum.
+  const unsigned char *Next() {
+    const unsigned char *record = next_;
+    checksum_.Update(record, recordSize_);
+    next_ += recordSize_;
+    if (++read_ == header_.count) Verify();
+    return record;
+  }
+
+  [[noreturn]] void Invalid(const std::string &what) const {
+    throw std::runtime_error("s21: " + path_ + ": " + what);
+  }
+
+ private:
+  void Verify() const {
+    if (checksum_.value() != header_.checksum) Invalid("checksum mismatch");
+  }
+
+  std::string path_;
+  MappedFile file_;
+  size_t recordSize_;
+  TreeArchiveHeader header_;
+  const unsigned char *next_ = nullptr;
+  uint64_t read_ = 0;
+  TreeArchiveChecksum checksum_;
+};
+
+}  // namespace s21
+
+#endif  // CPP2_S21_CONTAINERS_1_SRC_RBTREE_TREEARCHIVE_H_
@@ -0,0 +1,383 @@
+#ifndef CPP2_S21_CONTAINERS_1_SRC_MAP_S21_CONCURRENT_MAP_H_
+#define CPP2_S21_CONTAINERS_1_SRC_MAP_S21_CONCURRENT_MAP_H_
+
+#include <atomic>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <utility>
+
+#include "EpochDomain.h"
+#include "RBTree.h"
+
+namespace s21 {
+
+// Skip list node. Its links to the next node on each of its levels follow
+// the node in the same allocation, the lowest bit of a link marks the node
+// as removed from that level.
+template <typename Key, typename T>
+struct alignas(std::atomic<uintptr_t>) ConcurrentMapNode {
+  using Link = std::atomic<uintptr_t>;
+
+  template <typename... Args>
+  explicit ConcurrentMapNode(int levels, Args&&... args)
+      : data(std::forward<Args>(args)...), height(levels) {}
+
+  Link* links() { return reinterpret_cast<Link*>(this + 1); }
+
+  std::pair<const Key, T> data;
+  int height;
+  // The inserting and the removing thread each hold one claim, the one that
+  // drops the last claim unlinks the node for good and retires it.
+  std::atomic<int> claims{2};
+};
+
+template <typename Key, typename T, typename Compare>
+class concurrent_map;
+
+// Iterators see the elements present when they reach them and skip the ones
+// removed meanwhile. An iterator keeps its thread inside a read section, so
+// nodes are not freed under it; it must stay on the thread that created it.
+template <typename Key, typename T, typename Compare>
+class ConcurrentMapIterator {
+  using Node = ConcurrentMapNode<Key, T>;
+
+ public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = std::pair<const Key, T>;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const value_type*;
+  using reference = const value_type&;
+
+  ConcurrentMapIterator() {}
+  ConcurrentMapIterator(const ConcurrentMapIterator& other)
+      : ConcurrentMapIterator(other.domain_, other.node_) {}
+  ConcurrentMapIterator& operator=(const ConcurrentMapIterator& other) {
+    ConcurrentMapIterator copy(other);
+    std::swap(domain_, copy.domain_);
+    std::swap(slot_, copy.slot_);
+    std::swap(node_, copy.node_);
+    return *this;
+  }
+  ~ConcurrentMapIterator() {
+    if (slot_ != nullptr) domain_->Leave(slot_);
+  }
+
+  reference operator*() const { return node_->data; }
+  pointer operator->() const { return &node_->data; }
+  ConcurrentMapIterator& operator++() {
+    node_ = concurrent_map<Key, T, Compare>::NextLive(node_);
+    return *this;
+  }
+  ConcurrentMapIterator operator++(int) {
+    ConcurrentMapIterator result(*this);
+    ++*this;
+    return result;
+  }
+  bool operator==(const ConcurrentMapIterator& other) const {
+    return node_ == other.node_;
+  }
+  bool operator!=(const ConcurrentMapIterator& other) const {
+    return node_ != other.node_;
+  }
+
+ private:
+  friend class concurrent_map<Key, T, Compare>;
+
+  ConcurrentMapIterator(EpochDomain* domain, Node* node)
+      : domain_(domain), node_(node) {
+    if (node_ != nullptr) {
+      slot_ = domain_->LocalSlot();
+      domain_->Enter(slot_);
+    }
+  }
+
+  EpochDomain* domain_ = nullptr;
+  EpochDomain::Slot* slot_ = nullptr;
+  Node* node_ = nullptr;
+};
+
+// Ordered map for many threads at once, a lock-free skip list after Herlihy
+// and Shavit, "The Art of Multiprocessor Programming", ch. 14. Removed nodes
+// are freed through epoch based reclamation. Values are not changed in place,
+// so elements are reachable as const only.
+template <typename Key, typename T, typename Compare = std::less<Key>>
+class concurrent_map : private RBTreeCompare<Compare> {
+  using Node = ConcurrentMapNode<Key, T>;
+  using Link = typename Node::Link;
+
+ public:
+  using key_type = Key;
+  using mapped_type = T;
+  using value_type = std::pair<const Key, T>;
+  using reference = const value_type&;
+  using const_reference = const value_type&;
+  using iterator = ConcurrentMapIterator<Key, T, Compare>;
+  using const_iterator = iterator;
+  using size_type = size_t;
+  using key_compare = Compare;
+
+  concurrent_map() {}
+  explicit concurrent_map(const Compare& comp)
+      : RBTreeCompare<Compare>(comp) {}
+  concurrent_map(std::initializer_list<value_type> const& items) {
+    for (const value_type& item : items) insert(item);
+  }
+  concurrent_map(const concurrent_map&) = delete;
+  concurrent_map& operator=(const concurrent_map&) = delete;
+  // No other thread may use the map any more.
+  ~concurrent_map() {
+    Node* node = Ptr(head_[0].load(std::memory_order_relaxed));
+    while (node != nullptr) {
+      Node* next = Ptr(node->links()[0].load(std::memory_order_relaxed));
+      Destroy(node);
+      node = next;
+    }
+  }
+
+  iterator begin() {
+    EpochDomain::Guard guard(domain_);
+    Node* first = Ptr(head_[0].load(std::memory_order_acquire));
+    if (first != nullptr && IsMarked(first->links()[0].load())) {
+      first = NextLive(first);
+    }
+    return iterator(&domain_, first);
+  }
+  iterator end() { return iterator(); }
+
+  // Counts the inserts and erases that have completed, so it is exact only
+  // while no other thread writes.
+  size_type size() const { return size_.load(std::memory_order_relaxed); }
+  bool empty() const { return size() == 0; }
+
+  std::pair<iterator, bool> insert(const value_type& value) {
+    return insert(value.first, value.second);
+  }
+  std::pair<iterator, bool> insert(const Key& key, const T& obj) {
+    EpochDomain::Guard guard(domain_);
+    Link* preds[kMaxHeight];
+    Node* succs[kMaxHeight];
+    Node* node = nullptr;
+    while (true) {
+      if (Find(key, preds, succs)) {
+        if (node != nullptr) Destroy(node);
+        return {iterator(&domain_, succs[0]), false};
+      }
+      if (node == nullptr) node = Create(RandomHeight(), key, obj);
+      for (int level = 0; level < node->height; ++level) {
+        node->links()[level].store(Word(succs[level]),
+                                   std::memory_order_relaxed);
+      }
+      uintptr_t expected = Word(succs[0]);
+      if (preds[0][0].compare_exchange_strong(expected, Word(node),
+                                              std::memory_order_release,
+                                              std::memory_order_relaxed)) {
+        break;
+      }
+    }
+    size_.fetch_add(1, std::memory_order_relaxed);
+    iterator result(&domain_, node);
+    LinkUpperLevels(node, preds, succs);
+    DropClaim(node, guard.slot());
+    return {result, true};
+  }
+
+  size_type erase(const Key& key) {
+    EpochDomain::Guard guard(domain_);
+    Link* preds[kMaxHeight];
+    Node* succs[kMaxHeight];
+    if (!Find(key, preds, succs)) return 0;
+    Node* victim = succs[0];
+    for (int level = victim->height - 1; level > 0; --level) {
+      victim->links()[level].fetch_or(kMarked, std::memory_order_acq_rel);
+    }
+    // Marking the lowest level removes the element, only one thread can.
+    uintptr_t next = victim->links()[0].load(std::memory_order_acquire);
+    do {
+      if (IsMarked(next)) return 0;
+    } while (!victim->links()[0].compare_exchange_weak(
+        next, next | kMarked, std::memory_order_acq_rel));
+    size_.fetch_sub(1, std::memory_order_relaxed);
+    DropClaim(victim, guard.slot());
+    return 1;
+  }
+  // Erases the elements one by one, concurrent inserts may survive it.
+  void clear() {
+    for (iterator it = begin(); it != end(); ++it) erase(it->first);
+  }
+
+  iterator find(const Key& key) {
+    EpochDomain::Guard guard(domain_);
+    Node* node = LowerBoundNode(key);
+    if (node == nullptr || Less(key, node->data.first)) return end();
+    return iterator(&domain_, node);
+  }
+  bool contains(const Key& key) {
+    EpochDomain::Guard guard(domain_);
+    Node* node = LowerBoundNode(key);
+    return node != nullptr && !Less(key, node->data.first);
+  }
+  size_type count(const Key& key) { return contains(key); }
+  iterator lower_bound(const Key& key) {
+    EpochDomain::Guard guard(domain_);
+    return iterator(&domain_, LowerBoundNode(key));
+  }
+
+  key_compare key_comp() const { return this->compare(); }
+
+ private:
+  friend class ConcurrentMapIterator<Key, T, Compare>;
+
+  // With one level in four promoted, 20 levels keep searches logarithmic
+  // far beyond the number of nodes that fit in memory.
+  static constexpr int kMaxHeight = 20;
+  static constexpr uintptr_t kMarked = 1;
+
+  Link head_[kMaxHeight] = {};
+  std::atomic<size_type> size_{0};
+  EpochDomain domain_;
+
+  using RBTreeCompare<Compare>::compare;
+
+  bool Less(const Key& a, const Key& b) const { return compare()(a, b); }
+
+  static Node* Ptr(uintptr_t word) {
+    return reinterpret_cast<Node*>(word & ~kMarked);
+  }
+  static uintptr_t Word(Node* node) { return reinterpret_cast<uintptr_t>(node); }
+  static bool IsMarked(uintptr_t word) { return word & kMarked; }
+
+  static int RandomHeight() {
+    thread_local uint64_t state = reinterpret_cast<uintptr_t>(&state) | 1;
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    int height = 1;
+    for (uint64_t bits = state; (bits & 3) == 0 && height < kMaxHeight;
+         bits >>= 2) {
+      ++height;
+    }
+    return height;
+  }
+
+  static Node* Create(int height, const Key& key, const T& obj) {
+    void* memory = ::operator new(sizeof(Node) + height * sizeof(Link));
+    Node* node;
+    try {
+      node = new (memory) Node(height, key, obj);
+    } catch (...) {
+      ::operator delete(memory);
+      throw;
+    }
+    for (int level = 0; level < height; ++level) {
+      new (&node->links()[level]) Link(0);
+    }
+    return node;
+  }
+  static void Destroy(void* object) {
+    Node* node = static_cast<Node*>(object);
+    node->~Node();
+    ::operator delete(node);
+  }
+
+  // Next node on the lowest level that is not being removed.
+  static Node* NextLive(Node* node) {
+    do {
+      node = Ptr(node->links()[0].load(std::memory_order_acquire));
+    } while (node != nullptr &&
+             IsMarked(node->links()[0].load(std::memory_order_acquire)));
+    return node;
+  }
+
+  // Fills preds and succs with the links before and the nodes after key on
+  // every level, and unlinks the marked nodes met on the way. Returns
+  // whether succs[0] holds key. With passEqual the search goes on past the
+  // nodes of key, so that a removed one behind them is unlinked too.
+  bool Find(const Key& key, Link** preds, Node** succs,
+            bool passEqual = false) {
+  retry:
+    Link* pred = head_;
+    for (int level = kMaxHeight - 1; level >= 0; --level) {
+      Node* curr = Ptr(pred[level].load(std::memory_order_acquire));
+      while (curr != nullptr) {
+        uintptr_t next = curr->links()[level].load(std::memory_order_acquire);
+        if (IsMarked(next)) {
+          uintptr_t expected = Word(curr);
+          if (!pred[level].compare_exchange_strong(
+                  expected, next & ~kMarked, std::memory_order_acq_rel)) {
+            goto retry;
+          }
+          curr = Ptr(next);
+        } else if (Less(curr->data.first, key) ||
+                   (passEqual && !Less(key, curr->data.first))) {
+          pred = curr->links();
+          curr = Ptr(next);
+        } else {
+          break;
+        }
+      }
+      preds[level] = pred;
+      succs[level] = curr;
+    }
+    return succs[0] != nullptr && !Less(key, succs[0]->data.first);
+  }
+
+  // First node not less than key and not being removed, read only.
+  Node* LowerBoundNode(const Key& key) const {
+    const Link* pred = head_;
+    Node* curr = nullptr;
+    for (int level = kMaxHeight - 1; level >= 0; --level) {
+      curr = Ptr(pred[level].load(std::memory_order_acquire));
+      while (curr != nullptr) {
+        uintptr_t next = curr->links()[level].load(std::memory_order_acquire);
+        if (!IsMarked(next) && !Less(curr->data.first, key)) break;
+        if (!IsMarked(next)) pred = curr->links();
+        curr = Ptr(next);
+      }
+    }
+    return curr;
+  }
+
+  // Links node above the lowest level, unless a remover got to it first:
+  // then the remover has marked the link of that level and the node is left
+  // as it is.
+  void LinkUpperLevels(Node* node, Link** preds, Node** succs) {
+    for (int level = 1; level < node->height; ++level) {
+      while (true) {
+        uintptr_t own = node->links()[level].load(std::memory_order_acquire);
+        if (IsMarked(own)) return;
+        if (own != Word(succs[level]) &&
+            !node->links()[level].compare_exchange_strong(
+                own, Word(succs[level]), std::memory_order_acq_rel)) {
+          return;
+        }
+        uintptr_t expected = Word(succs[level]);
+        if (preds[level][level].compare_exchange_strong(
+                expected, Word(node), std::memory_order_release,
+                std::memory_order_relaxed)) {
+          break;
+        }
+        Find(node->data.first, preds, succs);
+        if (succs[0] != node) return;
+      }
+    }
+  }
+
+  // Once both the inserter and the remover are done with the node, it is
+  // marked on every level it was ever linked on, and one more search
+  // unlinks it from all of them before it is retired. An insert of the same
+  // key that saw the node before it was marked may have linked its own node
+  // in front of it on an upper level, so the search does not stop there.
+  void DropClaim(Node* node, EpochDomain::Slot* slot) {
+    if (node->claims.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+    Link* preds[kMaxHeight];
+    Node* succs[kMaxHeight];
+    Find(node->data.first, preds, succs, true);
+    domain_.Retire(slot, node, &Destroy);
+  }
+};
+
+}  // namespace s21
+
+#endif  // CPP2_S21_CONTAINERS_1_SRC_MAP_S21_CONCURRENT_MAP_H_
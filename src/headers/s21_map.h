@@ -1,10 +1,14 @@
 #ifndef CPP2_S21_CONTAINERS_1_SRC_MAP_S21_MAP_H_
 #define CPP2_S21_CONTAINERS_1_SRC_MAP_S21_MAP_H_
 
+#include <algorithm>
 #include <iostream>
+#include <iterator>
 #include <limits>
+#include <string>
 
 #include "RBTree.h"
+#include "SetAlgebra.h"
 
 namespace s21 {
 
@@ -13,8 +17,19 @@ class MapIterator;
 template <typename Key, typename T>
 class MapConstIterator;
 
-template <typename Key, typename T>
+// With Ranked set the tree keeps subtree sizes, which enables nth(), rank()
+// and count_range() at the cost of one counter per node.
+// With N > 0 a map of up to N elements keeps them sorted inside the object
+// and allocates nothing until it grows past N. Meanwhile every insertion and
+// erasure, as well as a move or swap, invalidates its iterators and
+// references to its elements.
+template <typename Key, typename T, typename Compare = std::less<Key>,
+          bool Ranked = false, size_t N = 0>
 class map {
+  using tree_type =
+      RBTree<Key, T, Compare, Ranked ? Ranking::NODES : Ranking::NONE,
+             NodePool, N>;
+
  public:
   using key_type = Key;
   using mapped_type = T;
@@ -24,33 +39,50 @@ class map {
   using iterator = MapIterator<Key, T>;
   using const_iterator = const MapIterator<Key, T>;
   using size_type = size_t;
+  using key_compare = Compare;
+  using node_type = typename tree_type::node_type;
+  using insert_return_type = RBTreeInsertReturn<iterator, node_type>;
 
   map() {}
-  map(std::initializer_list<value_type> const& items) {
-    for (auto item : items) {
-      tree_.Insert(item.first, item.second);
-    }
+  explicit map(const Compare& comp) : tree_(comp) {}
+  map(std::initializer_list<value_type> const& items)
+      : map(items.begin(), items.end()) {}
+  template <typename InputIt, typename = typename std::iterator_traits<
+                                  InputIt>::iterator_category>
+  map(InputIt first, InputIt last) {
+    assign_range(first, last);
   }
   map(const map& other) : tree_(other.tree_) {}
-  map(map&& other) : tree_(std::move(other.tree_)) {}
+  // Copies with the given threads instead of those of ParallelCopyPolicy().
+  map(const map& other, const ParallelPolicy& policy)
+      : tree_(other.tree_, policy) {}
+  map(map&& other) noexcept(tree_type::kNothrowMove)
+      : tree_(std::move(other.tree_)) {}
 
-  map& operator=(map&& other) { tree_ = std::move(other.tree_); }
-  map& operator=(const map& other) { tree_ = other.tree_; }
+  map& operator=(map&& other) noexcept(tree_type::kNothrowMove) {
+    tree_ = std::move(other.tree_);
+    return *this;
+  }
+  map& operator=(const map& other) {
+    tree_ = other.tree_;
+    return *this;
+  }
 
   ~map() {}
 
   T& at(const Key& key) {
-    if (tree_.at(key) == nullptr) {
+    T* value = tree_.at(key);
+    if (value == nullptr) {
       throw std::out_of_range("Key does not exist.");
     }
-    return *(tree_.at(key));
+    return *value;
   }
 
   T& operator[](const Key& key) {
-    if (tree_.at(key) == nullptr) {
-      tree_.Insert(key, mapped_type());
-    }
-    return *(tree_.at(key));
+    return tree_.TryEmplace(key).first->data.second;
+  }
+  T& operator[](Key&& key) {
+    return tree_.TryEmplace(std::move(key)).first->data.second;
   }
 
   iterator begin() { return iterator(tree_.begin()); }
@@ -63,47 +95,116 @@ class map {
   }
 
   void clear() { tree_.clear(); }
+  // Empties the map in O(1), the elements are destroyed and their memory is
+  // freed on the thread of reclaimer.
+  void clear_async(Reclaimer& reclaimer = Reclaimer::Global()) {
+    tree_.ClearAsync(reclaimer);
+  }
+
+  // [first, last) must be sorted by key without duplicates, the tree is then
+  // built in linear time instead of inserting element by element.
+  template <typename ForwardIt>
+  void assign_sorted(ForwardIt first, ForwardIt last) {
+    tree_.AssignSorted(std::distance(first, last),
+                       [&first]() -> value_type { return *first++; });
+  }
+  // Writes the elements to path in a binary format that load() reads back in
+  // linear time. Keys and values must be trivially copyable. Both need
+  // RBTreeArchive.h.
+  void save(const std::string& path) const {
+    tree_.Save(path, ArchiveKind::MAP);
+  }
+  // Replaces the contents with a map saved to path. Throws std::system_error
+  // if the file cannot be read and std::runtime_error if it was not saved by
+  // a map of the same types or is damaged, the map is then left unchanged.
+  void load(const std::string& path) {
+    tree_.Load(path, ArchiveKind::MAP, [](const auto&) { return true; });
+  }
   std::pair<iterator, bool> insert(const value_type& value) {
-    try {
-      iterator place = tree_.Insert(value.first, value.second);
-      return std::make_pair(place, true);
-    } catch (std::logic_error const&) {
-      return std::make_pair(tree_.end(), false);
-    }
+    return tree_.InsertUnique(value.first, value.second);
+  }
+  std::pair<iterator, bool> insert(value_type&& value) {
+    return tree_.InsertUnique(std::move(value.first), std::move(value.second));
   }
   std::pair<iterator, bool> insert(const Key& key, const T& obj) {
-    try {
-      iterator place = tree_.Insert(key, obj);
-      return std::make_pair(place, true);
-    } catch (std::logic_error const&) {
-      return std::make_pair(tree_.end(), false);
-    }
+    return tree_.InsertUnique(key, obj);
   }
-  std::pair<iterator, bool> insert_or_assign(const Key& key, const T& obj) {
-    auto smpl = tree_.find(key);
-    if (smpl != tree_.end()) {
-      erase(smpl);
-    }
-    tree_.Insert(key, obj);
-    return std::make_pair(tree_.find(key), true);
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args&&... args) {
+    return tree_.EmplaceUnique(std::forward<Args>(args)...);
+  }
+  // A hint at the element after the new one, e.g. end() for ascending keys,
+  // places it without descending from the root.
+  iterator insert(iterator hint, const value_type& value) {
+    return tree_.TryEmplaceHint(hint, value.first, value.second).first;
+  }
+  iterator insert(iterator hint, value_type&& value) {
+    return tree_
+        .TryEmplaceHint(hint, std::move(value.first), std::move(value.second))
+        .first;
+  }
+  template <typename... Args>
+  iterator emplace_hint(iterator hint, Args&&... args) {
+    return tree_.EmplaceUniqueHint(hint, std::forward<Args>(args)...).first;
+  }
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args) {
+    return tree_.TryEmplace(key, std::forward<Args>(args)...);
+  }
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(Key&& key, Args&&... args) {
+    return tree_.TryEmplace(std::move(key), std::forward<Args>(args)...);
+  }
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(const Key& key, M&& obj) {
+    auto result = tree_.TryEmplace(key, std::forward<M>(obj));
+    if (!result.second) result.first->data.second = std::forward<M>(obj);
+    return result;
+  }
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(Key&& key, M&& obj) {
+    auto result = tree_.TryEmplace(std::move(key), std::forward<M>(obj));
+    if (!result.second) result.first->data.second = std::forward<M>(obj);
+    return result;
   }
   void erase(iterator pos) {
     if (pos != end()) {
-      typename RBTree<Key, T>::iterator& tree_pos = pos;
-      tree_.Delete(tree_pos->data.first);
+      tree_.Erase(pos);
     }
   }
-  void swap(map& other) { std::swap(tree_, other.tree_); }
+  size_type erase(const Key& key) { return tree_.EraseUnique(key); }
+  void swap(map& other) noexcept(tree_type::kNothrowMove) {
+    tree_.Swap(other.tree_);
+  }
+
+  // Node handles move elements between maps without copying them.
+  node_type extract(iterator pos) { return tree_.Extract(pos); }
+  node_type extract(const Key& key) {
+    iterator pos = find(key);
+    if (pos == end()) return node_type();
+    return extract(pos);
+  }
+  insert_return_type insert(node_type&& node) {
+    auto [pos, inserted] = tree_.InsertNode(node);
+    return {iterator(pos), inserted, std::move(node)};
+  }
 
+  // Relinks the nodes whose keys are missing here, the rest stays in other.
   void merge(map& other) {
-    if (tree_ == other.tree_) return;
-    for (auto& item : other.tree_) {
-      try {
-        tree_.Insert(item.data.first, item.data.second);
-      } catch (std::logic_error const&) {
-      }
-    }
+    tree_.Merge(other.tree_, [](auto, auto) { return false; });
+  }
+  // Moves the elements with keys not less than key into the returned map.
+  // The tree is cut in O(log n), elements are neither copied nor reallocated.
+  // Unless the map is Ranked, the sizes of both maps are then unknown, and
+  // the first size() of each counts its elements in linear time.
+  map split_at(const Key& key) {
+    map upper(key_comp());
+    tree_.Split(key, upper.tree_);
+    return upper;
   }
+  // Takes over all elements of other in O(log n). Its keys must all be less
+  // or all be greater than ours, otherwise std::invalid_argument is thrown.
+  void join(map& other) { tree_.Join(other.tree_); }
 
   bool contains(const Key& key) {
     bool ans = true;
@@ -112,11 +213,151 @@ class map {
     }
     return ans;
   }
+  template <typename K, typename = RequireTransparent<Compare, K>>
+  bool contains(const K& key) {
+    return tree_.find(key) != tree_.end();
+  }
+  iterator find(const Key& key) { return iterator(tree_.find(key)); }
+  // Searches outward from hint, which is cheap when key is close to it.
+  iterator find(iterator hint, const Key& key) {
+    return iterator(tree_.FindHint(hint, key));
+  }
+  template <typename K, typename = RequireTransparent<Compare, K>>
+  iterator find(const K& key) {
+    return iterator(tree_.find(key));
+  }
+  // Looks up keys[0, count) with their descents interleaved, so that the
+  // cache misses overlap, and stores the result for keys[i] in out[i].
+  void find_many(const Key* keys, size_type count, iterator* out) {
+    tree_.FindMany(keys, count, out);
+  }
+  // Bit i % 64 of bits[i / 64] tells whether keys[i] is present. bits must
+  // hold (count + 63) / 64 words.
+  void contains_many(const Key* keys, size_type count, uint64_t* bits) {
+    tree_.ContainsMany(keys, count, bits);
+  }
+  size_type count(const Key& key) { return tree_.at(key) != nullptr; }
+  template <typename K, typename = RequireTransparent<Compare, K>>
+  size_type count(const K& key) {
+    return tree_.at(key) != nullptr;
+  }
+
+  iterator lower_bound(const Key& key) {
+    return iterator(tree_.LowerBound(key));
+  }
+  template <typename K, typename = RequireTransparent<Compare, K>>
+  iterator lower_bound(const K& key) {
+    return iterator(tree_.LowerBound(key));
+  }
+  iterator upper_bound(const Key& key) {
+    return iterator(tree_.UpperBound(key));
+  }
+  template <typename K, typename = RequireTransparent<Compare, K>>
+  iterator upper_bound(const K& key) {
+    return iterator(tree_.UpperBound(key));
+  }
+  std::pair<iterator, iterator> equal_range(const Key& key) {
+    return std::make_pair(lower_bound(key), upper_bound(key));
+  }
+  template <typename K, typename = RequireTransparent<Compare, K>>
+  std::pair<iterator, iterator> equal_range(const K& key) {
+    return std::make_pair(lower_bound(key), upper_bound(key));
+  }
+
+  key_compare key_comp() const { return tree_.key_comp(); }
+  // Shape of the tree and, in builds with S21_RBTREE_STATS, counts of the
+  // comparisons and rebalancing work done so far. Takes O(n).
+  RBTreeStats stats() const { return tree_.Stats(); }
+
+  // Element at position index in key order, or end().
+  iterator nth(size_type index) {
+    return iterator(tree_.Select(index).first);
+  }
+  // Number of elements with keys less than key.
+  size_type rank(const Key& key) const { return tree_.Rank(key); }
+  // Number of elements with keys in [lo, hi).
+  size_type count_range(const Key& lo, const Key& hi) const {
+    if (!tree_.key_comp()(lo, hi)) return 0;
+    return tree_.Rank(hi) - tree_.Rank(lo);
+  }
+
+  // Set operations on the keys, built from the trees directly and on several
+  // threads for large inputs. Keys present in both maps keep our value.
+  map set_union(map& other, const ParallelPolicy& policy = ParallelPolicy()) {
+    return combine(other, SetOperation::UNION, policy);
+  }
+  map set_intersection(map& other,
+                       const ParallelPolicy& policy = ParallelPolicy()) {
+    return combine(other, SetOperation::INTERSECTION, policy);
+  }
+  map set_difference(map& other,
+                     const ParallelPolicy& policy = ParallelPolicy()) {
+    return combine(other, SetOperation::DIFFERENCE, policy);
+  }
+  map symmetric_difference(map& other,
+                           const ParallelPolicy& policy = ParallelPolicy()) {
+    return combine(other, SetOperation::SYMMETRIC, policy);
+  }
 
  private:
-  RBTree<Key, T> tree_;
+  tree_type tree_;
+
+  template <typename InputIt>
+  void assign_range(InputIt first, InputIt last) {
+    using category = typename std::iterator_traits<InputIt>::iterator_category;
+    if constexpr (std::is_base_of_v<std::forward_iterator_tag, category>) {
+      Compare comp = key_comp();
+      auto unsorted = std::adjacent_find(
+          first, last, [&comp](const auto& a, const auto& b) {
+            return !comp(a.first, b.first);
+          });
+      if (unsorted == last) {
+        assign_sorted(first, last);
+        return;
+      }
+    }
+    for (; first != last; ++first) insert(end(), *first);
+  }
+
+  map combine(map& other, SetOperation op, const ParallelPolicy& policy) {
+    map result(key_comp());
+    result.tree_ = CombineTrees(tree_, other.tree_, op, policy);
+    return result;
+  }
 };
 
+template <typename Key, typename T, typename Compare, bool Ranked,
+          size_t N>
+map<Key, T, Compare, Ranked, N> set_union(
+    map<Key, T, Compare, Ranked, N>& a, map<Key, T, Compare, Ranked, N>& b,
+    const ParallelPolicy& policy = ParallelPolicy()) {
+  return a.set_union(b, policy);
+}
+
+template <typename Key, typename T, typename Compare, bool Ranked,
+          size_t N>
+map<Key, T, Compare, Ranked, N> set_intersection(
+    map<Key, T, Compare, Ranked, N>& a, map<Key, T, Compare, Ranked, N>& b,
+    const ParallelPolicy& policy = ParallelPolicy()) {
+  return a.set_intersection(b, policy);
+}
+
+template <typename Key, typename T, typename Compare, bool Ranked,
+          size_t N>
+map<Key, T, Compare, Ranked, N> set_difference(
+    map<Key, T, Compare, Ranked, N>& a, map<Key, T, Compare, Ranked, N>& b,
+    const ParallelPolicy& policy = ParallelPolicy()) {
+  return a.set_difference(b, policy);
+}
+
+template <typename Key, typename T, typename Compare, bool Ranked,
+          size_t N>
+map<Key, T, Compare, Ranked, N> symmetric_difference(
+    map<Key, T, Compare, Ranked, N>& a, map<Key, T, Compare, Ranked, N>& b,
+    const ParallelPolicy& policy = ParallelPolicy()) {
+  return a.symmetric_difference(b, policy);
+}
+
 template <typename Key, typename T>
 class MapIterator : public RBTreeIterator<Key, T> {
  public:
@@ -154,8 +395,8 @@ class MapIterator : public RBTreeIterator<Key, T> {
     --*this;
     return result;
   }
-  value_type& operator*() { return this->node->data; }
-  value_type* operator->() { return &(this->node->data); }
+  value_type& operator*() const { return this->GetNode()->data; }
+  value_type* operator->() const { return &(this->GetNode()->data); }
 };
 
 }  //  namespace s21
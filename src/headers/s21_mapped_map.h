@@ -0,0 +1,571 @@
+#ifndef CPP2_S21_CONTAINERS_1_SRC_MAP_S21_MAPPED_MAP_H_
+#define CPP2_S21_CONTAINERS_1_SRC_MAP_S21_MAPPED_MAP_H_
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include "RBTree.h"
+#include "RBTreeBalance.h"
+
+namespace s21 {
+
+// Node of a mapped map. Links are indices into the node array of the file,
+// 0 stands for no node, so the tree means the same at any mapping address.
+template <typename Key, typename T>
+struct MappedMapNode {
+  uint32_t left;
+  uint32_t right;
+  uint32_t parent;
+  Color color;
+  std::pair<const Key, T> data;
+};
+
+// First bytes of a mapped map file. dirty is set by the first change after
+// opening and cleared by checkpoint() and by closing the map, a file opened
+// while it is set was left halfway through a change by a process that died.
+// It tells nothing after a crash of the system, see checkpoint().
+struct MappedMapHeader {
+  static constexpr char kMagic[8] = {'s', '2', '1', 'm', 'm', 'a', 'p', '\0'};
+  static constexpr uint32_t kVersion = 1;
+
+  char magic[8];
+  uint32_t version;
+  uint32_t keySize;
+  uint32_t valueSize;
+  uint32_t nodeSize;
+  uint32_t root;
+  uint32_t freeList;
+  uint32_t used;
+  uint32_t capacity;
+  uint32_t dirty;
+  uint64_t size;
+};
+
+enum class MappedMode { READ_WRITE, READ_ONLY };
+
+template <typename Key, typename T, typename Compare>
+class MappedMapIterator;
+
+// Ordered map whose red-black tree lives in a file mapped with MAP_SHARED.
+// Nodes link to each other by 32 bit index instead of by pointer, so another
+// process that opens the file uses the tree in place, with nothing to
+// rebuild. Opening reads the nodes once to check that their links stay
+// inside the file. The file grows by doubling as nodes are added, erased nodes
+// are reused.
+//
+// Keys and values must be trivially copyable, and Compare must order keys
+// the same way in every process that opens the file. One writer may open a
+// file at a time and no reader alongside it; readers open the file
+// READ_ONLY once it is complete and may share it with each other. Opening
+// takes an flock on the file, exclusive for a writer and shared for a reader,
+// so a map that breaks the rule fails to open. Values are reachable as const,
+// they are changed with insert_or_assign().
+template <typename Key, typename T, typename Compare = std::less<Key>>
+class mapped_map : private RBTreeCompare<Compare> {
+  static_assert(std::is_trivially_copyable_v<Key> &&
+                    std::is_trivially_copyable_v<T>,
+                "mapped_map holds trivially copyable types only");
+
+  using Node = MappedMapNode<Key, T>;
+  using Index = uint32_t;
+
+ public:
+  using key_type = Key;
+  using mapped_type = T;
+  using value_type = std::pair<const Key, T>;
+  using reference = const value_type&;
+  using const_reference = const value_type&;
+  using iterator = MappedMapIterator<Key, T, Compare>;
+  using const_iterator = iterator;
+  using size_type = size_t;
+  using key_compare = Compare;
+
+  // Opens the map stored at path. In READ_WRITE mode a missing file is
+  // created empty. Throws std::system_error if the file cannot be opened,
+  // locked or mapped and std::runtime_error if it does not hold a mapped map
+  // of these types, is corrupt or was not closed after its last change.
+  explicit mapped_map(const std::string& path,
+                      MappedMode mode = MappedMode::READ_WRITE);
+  mapped_map(const mapped_map&) = delete;
+  mapped_map& operator=(const mapped_map&) = delete;
+  ~mapped_map();
+
+  iterator begin() const {
+    return iterator(this, empty() ? 0 : Balance().Minimum(Header().root));
+  }
+  iterator end() const { return iterator(this, 0); }
+  bool empty() const { return Header().size == 0; }
+  size_type size() const { return Header().size; }
+  size_type max_size() const { return std::numeric_limits<Index>::max() - 1; }
+  bool read_only() const { return mode_ == MappedMode::READ_ONLY; }
+  key_compare key_comp() const { return compare(); }
+
+  const T& at(const Key& key) const;
+  iterator find(const Key& key) const { return iterator(this, FindNode(key)); }
+  bool contains(const Key& key) const { return FindNode(key) != 0; }
+  size_type count(const Key& key) const { return FindNode(key) != 0; }
+  iterator lower_bound(const Key& key) const;
+  iterator upper_bound(const Key& key) const;
+
+  // Changes throw std::logic_error on a map opened READ_ONLY. Iterators stay
+  // valid when the file grows, only erasing an element invalidates its own.
+  std::pair<iterator, bool> insert(const value_type& value) {
+    return insert(value.first, value.second);
+  }
+  std::pair<iterator, bool> insert(const Key& key, const T& obj);
+  std::pair<iterator, bool> insert_or_assign(const Key& key, const T& obj);
+  void erase(iterator pos);
+  size_type erase(const Key& key);
+  void clear();
+  // Makes room for count elements without growing the file again.
+  void reserve(size_type count);
+
+  // Writes the changes made so far to the file, waits for them to reach the
+  // disk and marks the file clean. Only a process that dies is covered: the
+  // file opens again in the state of its last checkpoint if no change came
+  // after it, and is refused otherwise. After a crash of the system the pages
+  // may have reached the disk in any order, the header included, so a file
+  // that was open for writing then must be rebuilt rather than opened.
+  void checkpoint();
+
+ private:
+  friend class MappedMapIterator<Key, T, Compare>;
+
+  // Node 1 starts here, the header takes the bytes before it.
+  static constexpr size_t kNodesOffset = 64;
+  static constexpr Index kInitialCapacity = 64;
+  static_assert(sizeof(MappedMapHeader) <= kNodesOffset &&
+                    alignof(Node) <= kNodesOffset,
+                "nodes must fit behind the header");
+
+  using RBTreeCompare<Compare>::compare;
+
+  MappedMapHeader& Header() const {
+    return *reinterpret_cast<MappedMapHeader*>(base_);
+  }
+  Node& At(Index index) const {
+    return *reinterpret_cast<Node*>(base_ + kNodesOffset +
+                                    size_t(index - 1) * sizeof(Node));
+  }
+  static size_t FileSize(Index capacity) {
+    return kNodesOffset + size_t(capacity) * sizeof(Node);
+  }
+
+  // Node links as RBTreeBalance reaches them, 0 is the leaf and the parent of
+  // the root.
+  struct Links {
+    using Link = Index;
+
+    const mapped_map* map;
+
+    static Link Nil() { return 0; }
+    Link Left(Link node) const { return map->At(node).left; }
+    Link Right(Link node) const { return map->At(node).right; }
+    Link Parent(Link node) const { return map->At(node).parent; }
+    void SetLeft(Link node, Link child) const { map->At(node).left = child; }
+    void SetRight(Link node, Link child) const { map->At(node).right = child; }
+    void SetParent(Link node, Link parent) const {
+      map->At(node).parent = parent;
+    }
+    Color GetColor(Link node) const { return map->At(node).color; }
+    void SetColor(Link node, Color color) const {
+      map->At(node).color = color;
+    }
+    Link Root() const { return map->Header().root; }
+    void SetRoot(Link node) const { map->Header().root = node; }
+    static void Turned(Link, Link) {}
+    static void Unlinked(Link) {}
+    static void Count(RBTreeCounter) {}
+  };
+
+  RBTreeBalance<Links> Balance() const {
+    return RBTreeBalance<Links>(Links{this});
+  }
+
+  void Create();
+  void Validate() const;
+  void Map(size_t bytes);
+  void Grow(Index capacity);
+  void PrepareChange();
+  [[noreturn]] void Fail(const std::string& what) const;
+  [[noreturn]] void Invalid(const std::string& what) const;
+
+  Index FindNode(const Key& key) const;
+  Index AllocateNode();
+  void FreeNode(Index index);
+  void EraseNode(Index node);
+
+  std::string path_;
+  MappedMode mode_;
+  int fd_ = -1;
+  char* base_ = nullptr;
+  size_t bytes_ = 0;
+};
+
+template <typename Key, typename T, typename Compare>
+class MappedMapIterator {
+ public:
+  using iterator_category = std::bidirectional_iterator_tag;
+  using value_type = std::pair<const Key, T>;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const value_type*;
+  using reference = const value_type&;
+
+  MappedMapIterator() {}
+
+  reference operator*() const { return map_->At(index_).data; }
+  pointer operator->() const { return &map_->At(index_).data; }
+  MappedMapIterator& operator++() {
+    index_ = map_->Balance().Next(index_);
+    return *this;
+  }
+  MappedMapIterator operator++(int) {
+    MappedMapIterator result(*this);
+    ++*this;
+    return result;
+  }
+  // end() steps back to the largest element.
+  MappedMapIterator& operator--() {
+    index_ = index_ == 0 ? map_->Balance().Maximum(map_->Header().root)
+                         : map_->Balance().Prev(index_);
+    return *this;
+  }
+  MappedMapIterator operator--(int) {
+    MappedMapIterator result(*this);
+    --*this;
+    return result;
+  }
+  bool operator==(const MappedMapIterator& other) const {
+    return index_ == other.index_;
+  }
+  bool operator!=(const MappedMapIterator& other) const {
+    return index_ != other.index_;
+  }
+
+ private:
+  friend class mapped_map<Key, T, Compare>;
+
+  MappedMapIterator(const mapped_map<Key, T, Compare>* map, uint32_t index)
+      : map_(map), index_(index) {}
+
+  const mapped_map<Key, T, Compare>* map_ = nullptr;
+  uint32_t index_ = 0;
+};
+
+template <typename Key, typename T, typename Compare>
+mapped_map<Key, T, Compare>::mapped_map(const std::string& path,
+                                        MappedMode mode)
+    : path_(path), mode_(mode) {
+  bool writable = mode == MappedMode::READ_WRITE;
+  fd_ = ::open(path.c_str(), writable ? O_RDWR | O_CREAT | O_CLOEXEC
+                                      : O_RDONLY | O_CLOEXEC,
+               0644);
+  if (fd_ < 0) Fail("cannot open");
+  try {
+    if (::flock(fd_, (writable ? LOCK_EX : LOCK_SH) | LOCK_NB) != 0) {
+      Fail("cannot lock");
+    }
+    struct stat info;
+    if (::fstat(fd_, &info) != 0) Fail("cannot open");
+    if (info.st_size == 0 && writable) {
+      Create();
+    } else {
+      if (size_t(info.st_size) < kNodesOffset) Invalid("truncated");
+      Map(info.st_size);
+      Validate();
+    }
+  } catch (...) {
+    if (base_ != nullptr) ::munmap(base_, bytes_);
+    ::close(fd_);
+    throw;
+  }
+}
+
+// A clean close clears the dirty flag. The pages reach the file through the
+// page cache, also when the process dies later on.
+template <typename Key, typename T, typename Compare>
+mapped_map<Key, T, Compare>::~mapped_map() {
+  if (!read_only() && Header().dirty != 0) Header().dirty = 0;
+  ::munmap(base_, bytes_);
+  ::close(fd_);
+}
+
+template <typename Key, typename T, typename Compare>
+const T& mapped_map<Key, T, Compare>::at(const Key& key) const {
+  Index node = FindNode(key);
+  if (node == 0) throw std::out_of_range("Key does not exist.");
+  return At(node).data.second;
+}
+
+template <typename Key, typename T, typename Compare>
+typename mapped_map<Key, T, Compare>::iterator
+mapped_map<Key, T, Compare>::lower_bound(const Key& key) const {
+  Index result = 0;
+  for (Index node = Header().root; node != 0;) {
+    if (compare()(At(node).data.first, key)) {
+      node = At(node).right;
+    } else {
+      result = node;
+      node = At(node).left;
+    }
+  }
+  return iterator(this, result);
+}
+
+template <typename Key, typename T, typename Compare>
+typename mapped_map<Key, T, Compare>::iterator
+mapped_map<Key, T, Compare>::upper_bound(const Key& key) const {
+  Index result = 0;
+  for (Index node = Header().root; node != 0;) {
+    if (compare()(key, At(node).data.first)) {
+      result = node;
+      node = At(node).left;
+    } else {
+      node = At(node).right;
+    }
+  }
+  return iterator(this, result);
+}
+
+template <typename Key, typename T, typename Compare>
+std::pair<typename mapped_map<Key, T, Compare>::iterator, bool>
+mapped_map<Key, T, Compare>::insert(const Key& key, const T& obj) {
+  Index parent = 0;
+  bool left = false;
+  for (Index node = Header().root; node != 0;) {
+    parent = node;
+    if (compare()(key, At(node).data.first)) {
+      node = At(node).left;
+      left = true;
+    } else if (compare()(At(node).data.first, key)) {
+      node = At(node).right;
+      left = false;
+    } else {
+      return std::make_pair(iterator(this, node), false);
+    }
+  }
+  PrepareChange();
+  // Allocating may move the mapping, no reference into it is held across.
+  Index fresh = AllocateNode();
+  Node& node = At(fresh);
+  node.left = node.right = 0;
+  node.parent = parent;
+  node.color = Color::RED;
+  new (&node.data) value_type(key, obj);
+  if (parent == 0) {
+    Header().root = fresh;
+  } else if (left) {
+    At(parent).left = fresh;
+  } else {
+    At(parent).right = fresh;
+  }
+  Balance().FixInsert(fresh);
+  ++Header().size;
+  return std::make_pair(iterator(this, fresh), true);
+}
+
+template <typename Key, typename T, typename Compare>
+std::pair<typename mapped_map<Key, T, Compare>::iterator, bool>
+mapped_map<Key, T, Compare>::insert_or_assign(const Key& key, const T& obj) {
+  auto result = insert(key, obj);
+  if (!result.second) {
+    PrepareChange();
+    At(result.first.index_).data.second = obj;
+  }
+  return result;
+}
+
+template <typename Key, typename T, typename Compare>
+void mapped_map<Key, T, Compare>::erase(iterator pos) {
+  if (pos.index_ == 0) return;
+  PrepareChange();
+  EraseNode(pos.index_);
+}
+
+template <typename Key, typename T, typename Compare>
+typename mapped_map<Key, T, Compare>::size_type
+mapped_map<Key, T, Compare>::erase(const Key& key) {
+  Index node = FindNode(key);
+  if (node == 0) return 0;
+  PrepareChange();
+  EraseNode(node);
+  return 1;
+}
+
+// Keeps the file at its size, the nodes are handed out again from the start.
+template <typename Key, typename T, typename Compare>
+void mapped_map<Key, T, Compare>::clear() {
+  PrepareChange();
+  MappedMapHeader& header = Header();
+  header.root = 0;
+  header.freeList = 0;
+  header.used = 0;
+  header.size = 0;
+}
+
+template <typename Key, typename T, typename Compare>
+void mapped_map<Key, T, Compare>::reserve(size_type count) {
+  PrepareChange();
+  if (count > max_size()) throw std::length_error("mapped_map is too large");
+  if (count > Header().capacity) Grow(static_cast<Index>(count));
+}
+
+template <typename Key, typename T, typename Compare>
+void mapped_map<Key, T, Compare>::checkpoint() {
+  if (read_only()) return;
+  Header().dirty = 0;
+  if (::msync(base_, bytes_, MS_SYNC) != 0) Fail("cannot sync");
+}
+
+template <typename Key, typename T, typename Compare>
+void mapped_map<Key, T, Compare>::Create() {
+  if (::ftruncate(fd_, FileSize(kInitialCapacity)) != 0) Fail("cannot grow");
+  Map(FileSize(kInitialCapacity));
+  MappedMapHeader& header = Header();
+  std::memcpy(header.magic, MappedMapHeader::kMagic, sizeof(header.magic));
+  header.version = MappedMapHeader::kVersion;
+  header.keySize = sizeof(Key);
+  header.valueSize = sizeof(T);
+  header.nodeSize = sizeof(Node);
+  header.capacity = kInitialCapacity;
+}
+
+template <typename Key, typename T, typename Compare>
+void mapped_map<Key, T, Compare>::Validate() const {
+  const MappedMapHeader& header = Header();
+  if (std::memcmp(header.magic, MappedMapHeader::kMagic,
+                  sizeof(header.magic)) != 0) {
+    Invalid("not a mapped map");
+  }
+  if (header.version != MappedMapHeader::kVersion) {
+    Invalid("unsupported version");
+  }
+  if (header.keySize != sizeof(Key) || header.valueSize != sizeof(T) ||
+      header.nodeSize != sizeof(Node)) {
+    Invalid("written for other types");
+  }
+  if (bytes_ < FileSize(header.capacity) || header.used > header.capacity) {
+    Invalid("truncated");
+  }
+  if (header.dirty != 0) Invalid("not closed after its last change");
+  if (header.root > header.used || header.freeList > header.used ||
+      header.size > header.used) {
+    Invalid("corrupt header");
+  }
+  // Erased nodes keep links from before, which stay below used until clear()
+  // resets it, and their nodes are rewritten before being linked again.
+  for (Index index = 1; index <= header.used; ++index) {
+    const Node& node = At(index);
+    if (node.left > header.used || node.right > header.used ||
+        node.parent > header.used) {
+      Invalid("corrupt links");
+    }
+  }
+}
+
+template <typename Key, typename T, typename Compare>
+void mapped_map<Key, T, Compare>::Map(size_t bytes) {
+  int protection = read_only() ? PROT_READ : PROT_READ | PROT_WRITE;
+  void* base = ::mmap(nullptr, bytes, protection, MAP_SHARED, fd_, 0);
+  if (base == MAP_FAILED) Fail("cannot map");
+  base_ = static_cast<char*>(base);
+  bytes_ = bytes;
+}
+
+template <typename Key, typename T, typename Compare>
+void mapped_map<Key, T, Compare>::Grow(Index capacity) {
+  size_t bytes = FileSize(capacity);
+  if (::ftruncate(fd_, bytes) != 0) Fail("cannot grow");
+  char* previous = base_;
+  size_t previousBytes = bytes_;
+  Map(bytes);
+  ::munmap(previous, previousBytes);
+  Header().capacity = capacity;
+}
+
+template <typename Key, typename T, typename Compare>
+void mapped_map<Key, T, Compare>::PrepareChange() {
+  if (read_only()) throw std::logic_error("mapped_map is open read-only");
+  Header().dirty = 1;
+}
+
+template <typename Key, typename T, typename Compare>
+void mapped_map<Key, T, Compare>::Fail(const std::string& what) const {
+  throw std::system_error(errno, std::generic_category(),
+                          "s21: " + what + " " + path_);
+}
+
+template <typename Key, typename T, typename Compare>
+void mapped_map<Key, T, Compare>::Invalid(const std::string& what) const {
+  throw std::runtime_error("s21: " + path_ + ": " + what);
+}
+
+template <typename Key, typename T, typename Compare>
+typename mapped_map<Key, T, Compare>::Index
+mapped_map<Key, T, Compare>::FindNode(const Key& key) const {
+  Index node = Header().root;
+  while (node != 0) {
+    if (compare()(key, At(node).data.first)) {
+      node = At(node).left;
+    } else if (compare()(At(node).data.first, key)) {
+      node = At(node).right;
+    } else {
+      break;
+    }
+  }
+  return node;
+}
+
+template <typename Key, typename T, typename Compare>
+typename mapped_map<Key, T, Compare>::Index
+mapped_map<Key, T, Compare>::AllocateNode() {
+  MappedMapHeader* header = &Header();
+  if (header->freeList != 0) {
+    Index index = header->freeList;
+    header->freeList = At(index).left;
+    return index;
+  }
+  if (header->used == header->capacity) {
+    if (header->capacity == max_size()) {
+      throw std::length_error("mapped_map is too large");
+    }
+    Index capacity = header->capacity;
+    Grow(capacity > max_size() / 2 ? static_cast<Index>(max_size())
+                                   : 2 * capacity);
+    header = &Header();
+  }
+  return ++header->used;
+}
+
+// Erased nodes are chained through their left link.
+template <typename Key, typename T, typename Compare>
+void mapped_map<Key, T, Compare>::FreeNode(Index index) {
+  At(index).left = Header().freeList;
+  Header().freeList = index;
+}
+
+template <typename Key, typename T, typename Compare>
+void mapped_map<Key, T, Compare>::EraseNode(Index node) {
+  Balance().Erase(node);
+  FreeNode(node);
+  --Header().size;
+}
+
+}  // namespace s21
+
+#endif  // CPP2_S21_CONTAINERS_1_SRC_MAP_S21_MAPPED_MAP_H_
@@ -1,7 +1,10 @@
 #ifndef CPP2_S21_CONTAINERS_1_SRC_MULTISET_S21_MULTISET_H_
 #define CPP2_S21_CONTAINERS_1_SRC_MULTISET_S21_MULTISET_H_
 
+#include <algorithm>
+#include <iterator>
 #include <limits>
+#include <string>
 
 #include "RBTree.h"
 
@@ -10,8 +13,20 @@ namespace s21 {
 template <typename Key>
 class MultisetIterator;
 
-template <typename Key>
+// With Ranked set the tree keeps the number of elements below every node,
+// counting each key with its multiplicity. This enables nth(), rank() and
+// count_range() at the cost of one counter per node.
+// With N > 0 up to N distinct keys are kept sorted inside the object and
+// nothing is allocated until there are more. Meanwhile every insertion and
+// erasure, as well as a move or swap, invalidates the iterators and the
+// references to the elements.
+template <typename Key, typename Compare = std::less<Key>,
+          bool Ranked = false, size_t N = 0>
 class multiset {
+  using tree_type =
+      RBTree<Key, size_t, Compare, Ranked ? Ranking::PAYLOAD : Ranking::NONE,
+             NodePool, N>;
+
  public:
   using key_type = Key;
   using value_type = Key;
@@ -20,14 +35,22 @@ class multiset {
   using iterator = MultisetIterator<Key>;
   using const_iterator = MultisetIterator<Key>;
   using size_type = size_t;
+  using key_compare = Compare;
+  // The node of a multiset holds a key together with its count, mapped().
+  using node_type = typename tree_type::node_type;
 
   multiset() {}
+  explicit multiset(const Compare& comp);
   multiset(std::initializer_list<value_type> const& items);
+  template <typename InputIt, typename = typename std::iterator_traits<
+                                  InputIt>::iterator_category>
+  multiset(InputIt first, InputIt last);
   multiset(const multiset& s);
-  multiset(multiset&& s);
+  multiset(const multiset& s, const ParallelPolicy& policy);
+  multiset(multiset&& s) noexcept(tree_type::kNothrowMove);
   ~multiset() {}
   multiset& operator=(const multiset& s);
-  multiset& operator=(multiset&& s);
+  multiset& operator=(multiset&& s) noexcept(tree_type::kNothrowMove);
   iterator begin();
   iterator end();
   const_iterator cbegin();
@@ -37,21 +60,60 @@ class multiset {
   size_type size();
   size_type max_size();
   void clear();
+  void clear_async(Reclaimer& reclaimer = Reclaimer::Global());
+  template <typename ForwardIt>
+  void assign_sorted(ForwardIt first, ForwardIt last);
+  void save(const std::string& path) const;
+  void load(const std::string& path);
   std::pair<iterator, bool> insert(const value_type& value);
+  std::pair<iterator, bool> insert(value_type&& value);
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args&&... args);
+  iterator insert(iterator hint, const value_type& value);
+  iterator insert(iterator hint, value_type&& value);
+  template <typename... Args>
+  iterator emplace_hint(iterator hint, Args&&... args);
   void erase(iterator pos);
-  void swap(multiset& other);
+  size_type erase(const Key& key);
+  void swap(multiset& other) noexcept(tree_type::kNothrowMove);
+  node_type extract(iterator pos);
+  node_type extract(const Key& key);
+  iterator insert(node_type&& node);
   void merge(multiset& other);
 
   size_type count(const Key& key);
+  template <typename K, typename = RequireTransparent<Compare, K>>
+  size_type count(const K& key);
   iterator find(const Key& key);
+  iterator find(iterator hint, const Key& key);
+  template <typename K, typename = RequireTransparent<Compare, K>>
+  iterator find(const K& key);
   bool contains(const Key& key);
+  template <typename K, typename = RequireTransparent<Compare, K>>
+  bool contains(const K& key);
   std::pair<iterator, iterator> equal_range(const Key& key);
+  template <typename K, typename = RequireTransparent<Compare, K>>
+  std::pair<iterator, iterator> equal_range(const K& key);
   iterator lower_bound(const Key& key);
+  template <typename K, typename = RequireTransparent<Compare, K>>
+  iterator lower_bound(const K& key);
   iterator upper_bound(const Key& key);
+  template <typename K, typename = RequireTransparent<Compare, K>>
+  iterator upper_bound(const K& key);
+  key_compare key_comp() const;
+  RBTreeStats stats() const;
+
+  iterator nth(size_type index);
+  size_type rank(const Key& key) const;
+  size_type count_range(const Key& lo, const Key& hi) const;
 
  private:
-  RBTree<Key, size_t> tree;
+  tree_type tree;
   size_type _size = 0;
+
+  template <typename InputIt>
+  void assign_range(InputIt first, InputIt last);
+  iterator add_one(std::pair<typename tree_type::iterator, bool> result);
 };
 
 template <typename Key>
@@ -74,138 +136,335 @@ class MultisetIterator : public RBTreeIterator<Key, size_t> {
   MultisetIterator operator++(int);
   MultisetIterator& operator--();
   MultisetIterator operator--(int);
-  const value_type& operator*() { return this->node->data.first; }
-  const value_type* operator->() { return this->node->data.first; }
+  const value_type& operator*() const { return this->GetNode()->data.first; }
+  const value_type* operator->() const {
+    return &(this->GetNode()->data.first);
+  }
   bool operator==(const MultisetIterator& other) const;
   bool operator!=(const MultisetIterator& other) const;
 
  private:
   size_t index = 0;
 
-  friend class multiset<Key>;
+  template <typename, typename, bool, size_t>
+  friend class multiset;
 };
 
-template <typename Key>
-multiset<Key>::multiset(std::initializer_list<value_type> const& items) {
-  // iterator end_iter = end();
-  for (auto item : items) {
-    insert(item);
-  }
+template <typename Key, typename Compare, bool Ranked, size_t N>
+multiset<Key, Compare, Ranked, N>::multiset(const Compare& comp) : tree(comp) {}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+multiset<Key, Compare, Ranked, N>::multiset(
+    std::initializer_list<value_type> const& items) {
+  assign_range(items.begin(), items.end());
 }
 
-template <typename Key>
-multiset<Key>::multiset(const multiset& s) : tree(s.tree), _size(s._size) {}
+template <typename Key, typename Compare, bool Ranked, size_t N>
+template <typename InputIt, typename>
+multiset<Key, Compare, Ranked, N>::multiset(InputIt first, InputIt last) {
+  assign_range(first, last);
+}
 
-template <typename Key>
-multiset<Key>::multiset(multiset&& s)
+template <typename Key, typename Compare, bool Ranked, size_t N>
+multiset<Key, Compare, Ranked, N>::multiset(const multiset& s)
+    : tree(s.tree), _size(s._size) {}
+
+// Copies with the given threads instead of those of ParallelCopyPolicy().
+template <typename Key, typename Compare, bool Ranked, size_t N>
+multiset<Key, Compare, Ranked, N>::multiset(const multiset& s,
+                                            const ParallelPolicy& policy)
+    : tree(s.tree, policy), _size(s._size) {}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+multiset<Key, Compare, Ranked, N>::multiset(multiset&& s)
+    noexcept(tree_type::kNothrowMove)
     : tree(std::move(s.tree)), _size(s._size) {
   s._size = 0;
 }
 
-template <typename Key>
-multiset<Key>& multiset<Key>::operator=(const multiset& s) {
+template <typename Key, typename Compare, bool Ranked, size_t N>
+multiset<Key, Compare, Ranked, N>&
+multiset<Key, Compare, Ranked, N>::operator=(const multiset& s) {
   tree = s.tree;
   _size = s._size;
   return *this;
 }
 
-template <typename Key>
-multiset<Key>& multiset<Key>::operator=(multiset&& s) {
+template <typename Key, typename Compare, bool Ranked, size_t N>
+multiset<Key, Compare, Ranked, N>&
+multiset<Key, Compare, Ranked, N>::operator=(multiset&& s) noexcept(
+    tree_type::kNothrowMove) {
   tree = std::move(s.tree);
   _size = s._size;
   s._size = 0;
   return *this;
 }
 
-template <typename Key>
-typename multiset<Key>::iterator multiset<Key>::begin() {
+template <typename Key, typename Compare, bool Ranked, size_t N>
+typename multiset<Key, Compare, Ranked, N>::iterator
+multiset<Key, Compare, Ranked, N>::begin() {
   return iterator(tree.begin());
 }
 
-template <typename Key>
-typename multiset<Key>::iterator multiset<Key>::end() {
+template <typename Key, typename Compare, bool Ranked, size_t N>
+typename multiset<Key, Compare, Ranked, N>::iterator
+multiset<Key, Compare, Ranked, N>::end() {
   return iterator(tree.end());
 }
 
-template <typename Key>
-typename multiset<Key>::const_iterator multiset<Key>::cbegin() {
+template <typename Key, typename Compare, bool Ranked, size_t N>
+typename multiset<Key, Compare, Ranked, N>::const_iterator
+multiset<Key, Compare, Ranked, N>::cbegin() {
   return const_iterator(tree.begin());
 }
 
-template <typename Key>
-typename multiset<Key>::const_iterator multiset<Key>::cend() {
+template <typename Key, typename Compare, bool Ranked, size_t N>
+typename multiset<Key, Compare, Ranked, N>::const_iterator
+multiset<Key, Compare, Ranked, N>::cend() {
   return const_iterator(tree.end());
 }
 
-template <typename Key>
-bool multiset<Key>::empty() {
+template <typename Key, typename Compare, bool Ranked, size_t N>
+bool multiset<Key, Compare, Ranked, N>::empty() {
   return tree.empty();
 }
 
-template <typename Key>
-typename multiset<Key>::size_type multiset<Key>::size() {
+template <typename Key, typename Compare, bool Ranked, size_t N>
+typename multiset<Key, Compare, Ranked, N>::size_type
+multiset<Key, Compare, Ranked, N>::size() {
   return _size;
 }
 
-template <typename Key>
-typename multiset<Key>::size_type multiset<Key>::max_size() {
+template <typename Key, typename Compare, bool Ranked, size_t N>
+typename multiset<Key, Compare, Ranked, N>::size_type
+multiset<Key, Compare, Ranked, N>::max_size() {
   return std::numeric_limits<size_t>::max() / sizeof(value_type);
 }
 
-template <typename Key>
-void multiset<Key>::clear() {
+template <typename Key, typename Compare, bool Ranked, size_t N>
+void multiset<Key, Compare, Ranked, N>::clear() {
   tree.clear();
   _size = 0;
 }
 
-template <typename Key>
-std::pair<typename multiset<Key>::iterator, bool> multiset<Key>::insert(
-    const value_type& value) {
-  auto iter = tree.find(value);
-  if (iter != tree.end()) {
+// Empties the multiset in O(1), the keys are destroyed and their memory is
+// freed on the thread of reclaimer.
+template <typename Key, typename Compare, bool Ranked, size_t N>
+void multiset<Key, Compare, Ranked, N>::clear_async(Reclaimer& reclaimer) {
+  tree.ClearAsync(reclaimer);
+  _size = 0;
+}
+
+// [first, last) must be sorted, equal keys are folded into one node each and
+// the tree is built in linear time.
+template <typename Key, typename Compare, bool Ranked, size_t N>
+template <typename ForwardIt>
+void multiset<Key, Compare, Ranked, N>::assign_sorted(
+    ForwardIt first, ForwardIt last) {
+  Compare comp = key_comp();
+  size_type total = 0;
+  size_type distinct = 0;
+  for (ForwardIt iter = first; iter != last; ++total) {
+    ForwardIt prev = iter++;
+    if (iter == last || comp(*prev, *iter)) ++distinct;
+  }
+  tree.AssignSorted(distinct, [&first, last, &comp]() {
+    std::pair<Key, size_t> run(*first, 0);
+    for (; first != last && !comp(run.first, *first); ++first) ++run.second;
+    return run;
+  });
+  _size = total;
+}
+
+// Writes every distinct key with its count to path in a binary format that
+// load() reads back in linear time. Keys must be trivially copyable. Both
+// need RBTreeArchive.h.
+template <typename Key, typename Compare, bool Ranked, size_t N>
+void multiset<Key, Compare, Ranked, N>::save(const std::string& path) const {
+  tree.Save(path, ArchiveKind::MULTISET);
+}
+
+// Replaces the contents with a multiset saved to path. Throws
+// std::system_error if the file cannot be read and std::runtime_error if it
+// was not saved by a multiset of the same key type or is damaged, the
+// multiset is then left unchanged.
+template <typename Key, typename Compare, bool Ranked, size_t N>
+void multiset<Key, Compare, Ranked, N>::load(const std::string& path) {
+  size_type total = 0;
+  tree.Load(path, ArchiveKind::MULTISET, [&total](const auto& data) {
+    total += data.second;
+    return data.second != 0;
+  });
+  _size = total;
+}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+template <typename InputIt>
+void multiset<Key, Compare, Ranked, N>::assign_range(InputIt first,
+                                                     InputIt last) {
+  using category = typename std::iterator_traits<InputIt>::iterator_category;
+  if constexpr (std::is_base_of_v<std::forward_iterator_tag, category>) {
+    Compare comp = key_comp();
+    auto unsorted =
+        std::adjacent_find(first, last, [&comp](const Key& a, const Key& b) {
+          return comp(b, a);
+        });
+    if (unsorted == last) {
+      assign_sorted(first, last);
+      return;
+    }
+  }
+  for (; first != last; ++first) insert(end(), *first);
+}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+std::pair<typename multiset<Key, Compare, Ranked, N>::iterator, bool>
+multiset<Key, Compare, Ranked, N>::insert(const value_type& value) {
+  return std::make_pair(add_one(tree.InsertUnique(value, 1)), true);
+}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+std::pair<typename multiset<Key, Compare, Ranked, N>::iterator, bool>
+multiset<Key, Compare, Ranked, N>::insert(value_type&& value) {
+  return std::make_pair(add_one(tree.InsertUnique(std::move(value), 1)),
+                        true);
+}
+
+// Equal keys share one node, so the key is built once to be looked up and
+// is only moved into the tree when it is new.
+template <typename Key, typename Compare, bool Ranked, size_t N>
+template <typename... Args>
+std::pair<typename multiset<Key, Compare, Ranked, N>::iterator, bool>
+multiset<Key, Compare, Ranked, N>::emplace(Args&&... args) {
+  return insert(Key(std::forward<Args>(args)...));
+}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+typename multiset<Key, Compare, Ranked, N>::iterator
+multiset<Key, Compare, Ranked, N>::insert(iterator hint,
+                                          const value_type& value) {
+  return add_one(tree.TryEmplaceHint(hint, value, 1));
+}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+typename multiset<Key, Compare, Ranked, N>::iterator
+multiset<Key, Compare, Ranked, N>::insert(iterator hint, value_type&& value) {
+  return add_one(tree.TryEmplaceHint(hint, std::move(value), 1));
+}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+template <typename... Args>
+typename multiset<Key, Compare, Ranked, N>::iterator
+multiset<Key, Compare, Ranked, N>::emplace_hint(iterator hint, Args&&... args) {
+  return insert(hint, Key(std::forward<Args>(args)...));
+}
+
+// Counts one more element for the node that an insertion found or created.
+template <typename Key, typename Compare, bool Ranked, size_t N>
+typename multiset<Key, Compare, Ranked, N>::iterator
+multiset<Key, Compare, Ranked, N>::add_one(
+    std::pair<typename tree_type::iterator, bool> result) {
+  auto [iter, inserted] = result;
+  if (!inserted) {
     iter->data.second++;
-  } else {
-    iter = tree.Insert(value, 1);
+    tree.UpdateWeight(iter);
   }
-  iterator place = iterator(iter, iter->data.second);
   ++_size;
-
-  return std::make_pair(place, true);
+  return iterator(iter, iter->data.second - 1);
 }
 
-template <typename Key>
-void multiset<Key>::erase(iterator pos) {
+template <typename Key, typename Compare, bool Ranked, size_t N>
+void multiset<Key, Compare, Ranked, N>::erase(iterator pos) {
   if (pos != end()) {
-    typename RBTree<Key, size_t>::iterator& tree_pos = pos;
+    typename tree_type::iterator& tree_pos = pos;
     if (tree_pos->data.second > 1) {
       tree_pos->data.second--;
+      tree.UpdateWeight(tree_pos);
     } else {
-      tree.Delete(tree_pos->data.first);
+      tree.Erase(tree_pos);
     }
     --_size;
   }
 }
 
-template <typename Key>
-void multiset<Key>::swap(multiset& other) {
-  std::swap(tree, other.tree);
+template <typename Key, typename Compare, bool Ranked, size_t N>
+typename multiset<Key, Compare, Ranked, N>::size_type
+multiset<Key, Compare, Ranked, N>::erase(const Key& key) {
+  auto iter = tree.find(key);
+  if (iter == tree.end()) return 0;
+  size_type removed = iter->data.second;
+  tree.Erase(iter);
+  _size -= removed;
+  return removed;
+}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+void multiset<Key, Compare, Ranked, N>::swap(multiset& other)
+    noexcept(tree_type::kNothrowMove) {
+  tree.Swap(other.tree);
   std::swap(_size, other._size);
 }
 
-template <typename Key>
-void multiset<Key>::merge(multiset& other) {
-  if (tree == other.tree) return;
-  auto iter = other.begin();
-  while (iter != other.end()) {
-    auto prev_iter = iter++;
-    if (insert(*prev_iter).second) {
-      other.erase(prev_iter);
-    }
+// Takes out a single element. Only the last copy of a key can leave with its
+// node, otherwise the count is split off into a new one. The counts change
+// only once the node is there, in case making it throws.
+template <typename Key, typename Compare, bool Ranked, size_t N>
+typename multiset<Key, Compare, Ranked, N>::node_type
+multiset<Key, Compare, Ranked, N>::extract(iterator pos) {
+  typename tree_type::iterator& tree_pos = pos;
+  if (tree_pos->data.second == 1) {
+    node_type node = tree.Extract(tree_pos);
+    --_size;
+    return node;
   }
+  node_type node = tree.MakeNode(tree_pos->data.first, 1);
+  tree_pos->data.second--;
+  tree.UpdateWeight(tree_pos);
+  --_size;
+  return node;
 }
 
-template <typename Key>
-typename multiset<Key>::size_type multiset<Key>::count(const Key& key) {
+template <typename Key, typename Compare, bool Ranked, size_t N>
+typename multiset<Key, Compare, Ranked, N>::node_type
+multiset<Key, Compare, Ranked, N>::extract(const Key& key) {
+  iterator pos = find(key);
+  if (pos == end()) return node_type();
+  return extract(pos);
+}
+
+// A key that is already present takes over the count of the node, which is
+// then released. Returns the first of the inserted elements.
+template <typename Key, typename Compare, bool Ranked, size_t N>
+typename multiset<Key, Compare, Ranked, N>::iterator
+multiset<Key, Compare, Ranked, N>::insert(node_type&& node) {
+  if (node.empty()) return end();
+  size_type added = node.mapped();
+  auto [pos, inserted] = tree.InsertNode(node);
+  _size += added;
+  if (inserted) return iterator(pos);
+  pos->data.second += added;
+  tree.UpdateWeight(pos);
+  node = node_type();
+  return iterator(pos, pos->data.second - added);
+}
+
+// Every element moves: new keys by relinking their nodes, known keys by
+// adding up the counts.
+template <typename Key, typename Compare, bool Ranked, size_t N>
+void multiset<Key, Compare, Ranked, N>::merge(multiset& other) {
+  if (this == &other) return;
+  tree.Merge(other.tree, [this](auto ours, auto theirs) {
+    ours->data.second += theirs->data.second;
+    tree.UpdateWeight(ours);
+    return true;
+  });
+  _size += other._size;
+  other._size = 0;
+}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+typename multiset<Key, Compare, Ranked, N>::size_type
+multiset<Key, Compare, Ranked, N>::count(const Key& key) {
   size_type* ptr = tree.at(key);
   if (ptr) {
     return *ptr;
@@ -214,38 +473,122 @@ typename multiset<Key>::size_type multiset<Key>::count(const Key& key) {
   }
 }
 
-template <typename Key>
-typename multiset<Key>::iterator multiset<Key>::find(const Key& key) {
+template <typename Key, typename Compare, bool Ranked, size_t N>
+template <typename K, typename>
+typename multiset<Key, Compare, Ranked, N>::size_type
+multiset<Key, Compare, Ranked, N>::count(const K& key) {
+  size_type* ptr = tree.at(key);
+  return ptr != nullptr ? *ptr : 0;
+}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+typename multiset<Key, Compare, Ranked, N>::iterator
+multiset<Key, Compare, Ranked, N>::find(const Key& key) {
   return iterator(tree.find(key));
 }
 
-template <typename Key>
-bool multiset<Key>::contains(const Key& key) {
+// Searches outward from hint, which is cheap when key is close to it.
+template <typename Key, typename Compare, bool Ranked, size_t N>
+typename multiset<Key, Compare, Ranked, N>::iterator
+multiset<Key, Compare, Ranked, N>::find(iterator hint, const Key& key) {
+  return iterator(tree.FindHint(hint, key));
+}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+template <typename K, typename>
+typename multiset<Key, Compare, Ranked, N>::iterator
+multiset<Key, Compare, Ranked, N>::find(const K& key) {
+  return iterator(tree.find(key));
+}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+bool multiset<Key, Compare, Ranked, N>::contains(const Key& key) {
   return tree.at(key);
 }
 
-template <typename Key>
-std::pair<typename multiset<Key>::iterator, typename multiset<Key>::iterator>
-multiset<Key>::equal_range(const Key& key) {
+template <typename Key, typename Compare, bool Ranked, size_t N>
+template <typename K, typename>
+bool multiset<Key, Compare, Ranked, N>::contains(const K& key) {
+  return tree.at(key);
+}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+std::pair<typename multiset<Key, Compare, Ranked, N>::iterator,
+          typename multiset<Key, Compare, Ranked, N>::iterator>
+multiset<Key, Compare, Ranked, N>::equal_range(const Key& key) {
   return std::make_pair(lower_bound(key), upper_bound(key));
 }
 
-template <typename Key>
-typename multiset<Key>::iterator multiset<Key>::lower_bound(const Key& key) {
-  auto iter = find(key);
-  if (iter != begin() && iter != end()) {
-    --iter;
-  }
-  return iter;
+template <typename Key, typename Compare, bool Ranked, size_t N>
+template <typename K, typename>
+std::pair<typename multiset<Key, Compare, Ranked, N>::iterator,
+          typename multiset<Key, Compare, Ranked, N>::iterator>
+multiset<Key, Compare, Ranked, N>::equal_range(const K& key) {
+  return std::make_pair(lower_bound(key), upper_bound(key));
 }
 
-template <typename Key>
-typename multiset<Key>::iterator multiset<Key>::upper_bound(const Key& key) {
-  auto iter = find(key);
-  if (iter != end()) {
-    iter.RBTreeIterator<Key, size_t>::operator++();
-  }
-  return iter;
+template <typename Key, typename Compare, bool Ranked, size_t N>
+typename multiset<Key, Compare, Ranked, N>::iterator
+multiset<Key, Compare, Ranked, N>::lower_bound(const Key& key) {
+  return iterator(tree.LowerBound(key));
+}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+template <typename K, typename>
+typename multiset<Key, Compare, Ranked, N>::iterator
+multiset<Key, Compare, Ranked, N>::lower_bound(const K& key) {
+  return iterator(tree.LowerBound(key));
+}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+typename multiset<Key, Compare, Ranked, N>::iterator
+multiset<Key, Compare, Ranked, N>::upper_bound(const Key& key) {
+  return iterator(tree.UpperBound(key));
+}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+template <typename K, typename>
+typename multiset<Key, Compare, Ranked, N>::iterator
+multiset<Key, Compare, Ranked, N>::upper_bound(const K& key) {
+  return iterator(tree.UpperBound(key));
+}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+typename multiset<Key, Compare, Ranked, N>::key_compare
+multiset<Key, Compare, Ranked, N>::key_comp() const {
+  return tree.key_comp();
+}
+
+// Shape of the tree and, in builds with S21_RBTREE_STATS, counts of the
+// comparisons and rebalancing work done so far. Takes O(n). Nodes are
+// counted once per distinct key.
+template <typename Key, typename Compare, bool Ranked, size_t N>
+RBTreeStats multiset<Key, Compare, Ranked, N>::stats() const {
+  return tree.Stats();
+}
+
+// Returns the element at position index in sorted order, or end().
+template <typename Key, typename Compare, bool Ranked, size_t N>
+typename multiset<Key, Compare, Ranked, N>::iterator
+multiset<Key, Compare, Ranked, N>::nth(size_type index) {
+  auto [node, offset] = tree.Select(index);
+  return iterator(node, offset);
+}
+
+// Number of elements less than key, duplicates counted.
+template <typename Key, typename Compare, bool Ranked, size_t N>
+typename multiset<Key, Compare, Ranked, N>::size_type
+multiset<Key, Compare, Ranked, N>::rank(const Key& key) const {
+  return tree.Rank(key);
+}
+
+// Number of elements in [lo, hi), duplicates counted.
+template <typename Key, typename Compare, bool Ranked, size_t N>
+typename multiset<Key, Compare, Ranked, N>::size_type
+multiset<Key, Compare, Ranked, N>::count_range(
+    const Key& lo, const Key& hi) const {
+  if (!tree.key_comp()(lo, hi)) return 0;
+  return tree.Rank(hi) - tree.Rank(lo);
 }
 
 template <typename Key>
@@ -267,7 +610,7 @@ MultisetIterator<Key>& MultisetIterator<Key>::operator=(
 
 template <typename Key>
 MultisetIterator<Key>& MultisetIterator<Key>::operator++() {
-  if (!this->end && index + 1 < this->node->data.second) {
+  if (!this->node->IsHeader() && index + 1 < this->GetNode()->data.second) {
     ++index;
   } else {
     this->RBTreeIterator<Key, size_t>::operator++();
@@ -285,11 +628,11 @@ MultisetIterator<Key> MultisetIterator<Key>::operator++(int) {
 
 template <typename Key>
 MultisetIterator<Key>& MultisetIterator<Key>::operator--() {
-  if (!this->end && index > 0) {
+  if (index > 0) {
     --index;
   } else {
     this->RBTreeIterator<Key, size_t>::operator--();
-    index = this->node->data.second - 1;
+    index = this->GetNode()->data.second - 1;
   }
   return *this;
 }
@@ -303,17 +646,12 @@ MultisetIterator<Key> MultisetIterator<Key>::operator--(int) {
 
 template <typename Key>
 bool MultisetIterator<Key>::operator==(const MultisetIterator& other) const {
-  return (this->node == other.node && index == other.index &&
-          this->end == other.end) ||
-         (this->end == other.end && this->end == true);
+  return this->node == other.node && index == other.index;
 }
 
 template <typename Key>
 bool MultisetIterator<Key>::operator!=(const MultisetIterator& other) const {
-  return ((this->node != other.node || index != other.index) &&
-          this->end != other.end) ||
-         this->end != other.end;
-  ;
+  return this->node != other.node || index != other.index;
 }
 
 }  // namespace s21
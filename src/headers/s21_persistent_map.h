@@ -0,0 +1,471 @@
+#ifndef CPP2_S21_CONTAINERS_1_SRC_MAP_S21_PERSISTENT_MAP_H_
+#define CPP2_S21_CONTAINERS_1_SRC_MAP_S21_PERSISTENT_MAP_H_
+
+#include <atomic>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "RBTree.h"
+
+namespace s21 {
+
+// Node of a persistent tree. It has no parent link, so that one node can sit
+// in the trees of many snapshots at once, and counts the links to it.
+template <typename Key, typename T>
+struct PersistentMapNode {
+  template <typename... Args>
+  explicit PersistentMapNode(Color nodeColor, Args&&... args)
+      : data(std::forward<Args>(args)...), color(nodeColor) {}
+
+  std::pair<const Key, T> data;
+  PersistentMapNode* left = nullptr;
+  PersistentMapNode* right = nullptr;
+  Color color;
+  std::atomic<size_t> refs{1};
+};
+
+template <typename Key, typename T>
+class PersistentMapIterator;
+template <typename Key, typename T, typename Compare>
+class rcu_map;
+
+// Red-black map whose copies share their nodes. A copy is O(1); a write
+// copies the O(log n) nodes on the path to the changed key and leaves every
+// other snapshot as it was. Nodes are freed once no snapshot links to them.
+//
+// Values are reachable as const only, since they may be shared. One object
+// is not safe to use from several threads at once, but copies of it are, as
+// they share nodes only through atomic reference counts. A write invalidates
+// the iterators of the map it is made on.
+template <typename Key, typename T, typename Compare = std::less<Key>>
+class persistent_map : private RBTreeCompare<Compare> {
+  using Node = PersistentMapNode<Key, T>;
+
+ public:
+  using key_type = Key;
+  using mapped_type = T;
+  using value_type = std::pair<const Key, T>;
+  using reference = const value_type&;
+  using const_reference = const value_type&;
+  using iterator = PersistentMapIterator<Key, T>;
+  using const_iterator = iterator;
+  using size_type = size_t;
+  using key_compare = Compare;
+
+  persistent_map() {}
+  explicit persistent_map(const Compare& comp)
+      : RBTreeCompare<Compare>(comp) {}
+  persistent_map(std::initializer_list<value_type> const& items)
+      : persistent_map(items.begin(), items.end()) {}
+  template <typename InputIt, typename = typename std::iterator_traits<
+                                  InputIt>::iterator_category>
+  persistent_map(InputIt first, InputIt last) {
+    for (; first != last; ++first) insert(*first);
+  }
+  persistent_map(const persistent_map& other)
+      : RBTreeCompare<Compare>(other.compare()),
+        root_(Retain(other.root_).Release()),
+        size_(other.size_) {}
+  persistent_map(persistent_map&& other) noexcept
+      : RBTreeCompare<Compare>(other.compare()),
+        root_(other.root_),
+        size_(other.size_) {
+    other.root_ = nullptr;
+    other.size_ = 0;
+  }
+  ~persistent_map() { Unlink(root_); }
+
+  persistent_map& operator=(const persistent_map& other) {
+    persistent_map copy(other);
+    swap(copy);
+    return *this;
+  }
+  persistent_map& operator=(persistent_map&& other) noexcept {
+    persistent_map moved(std::move(other));
+    swap(moved);
+    return *this;
+  }
+
+  iterator begin() const { return iterator(root_); }
+  iterator end() const { return iterator(); }
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+
+  bool empty() const { return size_ == 0; }
+  size_type size() const { return size_; }
+  size_type max_size() const {
+    return std::numeric_limits<size_type>::max() / sizeof(Node);
+  }
+
+  void clear() {
+    Unlink(root_);
+    root_ = nullptr;
+    size_ = 0;
+  }
+
+  std::pair<iterator, bool> insert(const value_type& value) {
+    return insert(value.first, value.second);
+  }
+  std::pair<iterator, bool> insert(const Key& key, const T& obj) {
+    if (FindNode(key) != nullptr) return {find(key), false};
+    Assign(key, obj);
+    ++size_;
+    return {find(key), true};
+  }
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(const Key& key, M&& obj) {
+    bool inserted = FindNode(key) == nullptr;
+    Assign(key, std::forward<M>(obj));
+    size_ += inserted;
+    return {find(key), inserted};
+  }
+  size_type erase(const Key& key) {
+    if (FindNode(key) == nullptr) return 0;
+    NodeRef root = Delete(root_, key);
+    if (root) root = Recolor(std::move(root), Color::BLACK);
+    Unlink(root_);
+    root_ = root.Release();
+    --size_;
+    return 1;
+  }
+  void swap(persistent_map& other) noexcept {
+    std::swap(this->compare(), other.compare());
+    std::swap(root_, other.root_);
+    std::swap(size_, other.size_);
+  }
+
+  const T& at(const Key& key) const {
+    const Node* node = FindNode(key);
+    if (node == nullptr) throw std::out_of_range("Key does not exist.");
+    return node->data.second;
+  }
+  iterator find(const Key& key) const {
+    iterator result;
+    const Node* node = root_;
+    while (node != nullptr) {
+      if (Less(key, node->data.first)) {
+        result.path_.push_back(node);
+        node = node->left;
+      } else if (Less(node->data.first, key)) {
+        node = node->right;
+      } else {
+        result.path_.push_back(node);
+        return result;
+      }
+    }
+    return end();
+  }
+  bool contains(const Key& key) const { return FindNode(key) != nullptr; }
+  size_type count(const Key& key) const { return contains(key); }
+
+  key_compare key_comp() const { return this->compare(); }
+
+ private:
+  friend class rcu_map<Key, T, Compare>;
+
+  // Owns one reference to a node and drops it when destroyed, so that the
+  // partial results of a write are released if a copy of a value throws.
+  class NodeRef {
+   public:
+    NodeRef() {}
+    explicit NodeRef(Node* node) : node_(node) {}
+    NodeRef(NodeRef&& other) noexcept : node_(other.Release()) {}
+    NodeRef& operator=(NodeRef&& other) noexcept {
+      std::swap(node_, other.node_);
+      return *this;
+    }
+    ~NodeRef() { Unlink(node_); }
+    Node* operator->() const { return node_; }
+    Node* Get() const { return node_; }
+    Node* Release() {
+      Node* node = node_;
+      node_ = nullptr;
+      return node;
+    }
+    explicit operator bool() const { return node_ != nullptr; }
+
+   private:
+    Node* node_ = nullptr;
+  };
+
+  Node* root_ = nullptr;
+  size_type size_ = 0;
+
+  using RBTreeCompare<Compare>::compare;
+
+  bool Less(const Key& a, const Key& b) const { return compare()(a, b); }
+
+  static NodeRef Retain(Node* node) {
+    if (node != nullptr) node->refs.fetch_add(1, std::memory_order_relaxed);
+    return NodeRef(node);
+  }
+  static void Unlink(Node* node) {
+    while (node != nullptr &&
+           node->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      Node* right = node->right;
+      Unlink(node->left);
+      delete node;
+      node = right;
+    }
+  }
+  static bool IsRed(const Node* node) {
+    return node != nullptr && node->color == Color::RED;
+  }
+  static bool IsBlack(const Node* node) {
+    return node != nullptr && node->color == Color::BLACK;
+  }
+
+  // A node with the data of from between left and right.
+  static NodeRef Copy(Color color, NodeRef left, const Node* from,
+                      NodeRef right) {
+    return Link(new Node(color, from->data), std::move(left),
+                std::move(right));
+  }
+  static NodeRef Link(Node* node, NodeRef left, NodeRef right) {
+    node->left = left.Release();
+    node->right = right.Release();
+    return NodeRef(node);
+  }
+  // A node nobody else links to yet is recolored in place.
+  static NodeRef Recolor(NodeRef node, Color color) {
+    if (node->color == color) return node;
+    if (node->refs.load(std::memory_order_acquire) == 1) {
+      node->color = color;
+      return node;
+    }
+    return Copy(color, Retain(node->left), node.Get(), Retain(node->right));
+  }
+
+  const Node* FindNode(const Key& key) const {
+    const Node* node = root_;
+    while (node != nullptr) {
+      if (Less(key, node->data.first)) {
+        node = node->left;
+      } else if (Less(node->data.first, key)) {
+        node = node->right;
+      } else {
+        return node;
+      }
+    }
+    return nullptr;
+  }
+
+  template <typename M>
+  void Assign(const Key& key, M&& obj) {
+    NodeRef root =
+        Recolor(Insert(root_, key, std::forward<M>(obj)), Color::BLACK);
+    Unlink(root_);
+    root_ = root.Release();
+  }
+
+  // The rebalancing follows Kahrs, "Red-black trees with types" (2001): the
+  // new path is built bottom up and every step returns a fresh subtree.
+  template <typename M>
+  NodeRef Insert(Node* node, const Key& key, M&& obj) {
+    if (node == nullptr) {
+      return NodeRef(new Node(Color::RED, key, std::forward<M>(obj)));
+    }
+    if (Less(key, node->data.first)) {
+      NodeRef left = Insert(node->left, key, std::forward<M>(obj));
+      if (node->color == Color::RED) {
+        return Copy(Color::RED, std::move(left), node, Retain(node->right));
+      }
+      return Balance(std::move(left), node, Retain(node->right));
+    }
+    if (Less(node->data.first, key)) {
+      NodeRef right = Insert(node->right, key, std::forward<M>(obj));
+      if (node->color == Color::RED) {
+        return Copy(Color::RED, Retain(node->left), node, std::move(right));
+      }
+      return Balance(Retain(node->left), node, std::move(right));
+    }
+    return Link(new Node(node->color, node->data.first, std::forward<M>(obj)),
+                Retain(node->left), Retain(node->right));
+  }
+
+  // A black node with the data of x over a and b, with a red-red violation
+  // below it turned into a red node with two black children.
+  static NodeRef Balance(NodeRef a, const Node* x, NodeRef b) {
+    if (IsRed(a.Get()) && IsRed(b.Get())) {
+      return Copy(Color::RED, Recolor(std::move(a), Color::BLACK), x,
+                  Recolor(std::move(b), Color::BLACK));
+    }
+    if (IsRed(a.Get()) && IsRed(a->left)) {
+      return Copy(Color::RED, Recolor(Retain(a->left), Color::BLACK), a.Get(),
+                  Copy(Color::BLACK, Retain(a->right), x, std::move(b)));
+    }
+    if (IsRed(a.Get()) && IsRed(a->right)) {
+      Node* y = a->right;
+      return Copy(Color::RED,
+                  Copy(Color::BLACK, Retain(a->left), a.Get(),
+                       Retain(y->left)),
+                  y, Copy(Color::BLACK, Retain(y->right), x, std::move(b)));
+    }
+    if (IsRed(b.Get()) && IsRed(b->right)) {
+      return Copy(Color::RED,
+                  Copy(Color::BLACK, std::move(a), x, Retain(b->left)),
+                  b.Get(), Recolor(Retain(b->right), Color::BLACK));
+    }
+    if (IsRed(b.Get()) && IsRed(b->left)) {
+      Node* y = b->left;
+      return Copy(Color::RED,
+                  Copy(Color::BLACK, std::move(a), x, Retain(y->left)), y,
+                  Copy(Color::BLACK, Retain(y->right), b.Get(),
+                       Retain(b->right)));
+    }
+    return Copy(Color::BLACK, std::move(a), x, std::move(b));
+  }
+
+  // Removes key, which must be present below node. Below a black node the
+  // result is one black level lower, BalanceLeft and BalanceRight make up
+  // for that.
+  NodeRef Delete(Node* node, const Key& key) {
+    if (Less(key, node->data.first)) {
+      NodeRef left = Delete(node->left, key);
+      if (IsBlack(node->left)) {
+        return BalanceLeft(std::move(left), node, Retain(node->right));
+      }
+      return Copy(Color::RED, std::move(left), node, Retain(node->right));
+    }
+    if (Less(node->data.first, key)) {
+      NodeRef right = Delete(node->right, key);
+      if (IsBlack(node->right)) {
+        return BalanceRight(Retain(node->left), node, std::move(right));
+      }
+      return Copy(Color::RED, Retain(node->left), node, std::move(right));
+    }
+    return Append(Retain(node->left), Retain(node->right));
+  }
+
+  // a is one black level lower than c.
+  static NodeRef BalanceLeft(NodeRef a, const Node* x, NodeRef c) {
+    if (IsRed(a.Get())) {
+      return Copy(Color::RED, Recolor(std::move(a), Color::BLACK), x,
+                  std::move(c));
+    }
+    if (IsBlack(c.Get())) {
+      return Balance(std::move(a), x, Recolor(std::move(c), Color::RED));
+    }
+    Node* y = c->left;
+    return Copy(Color::RED, Copy(Color::BLACK, std::move(a), x,
+                                 Retain(y->left)),
+                y,
+                Balance(Retain(y->right), c.Get(),
+                        Recolor(Retain(c->right), Color::RED)));
+  }
+
+  // c is one black level lower than a.
+  static NodeRef BalanceRight(NodeRef a, const Node* x, NodeRef c) {
+    if (IsRed(c.Get())) {
+      return Copy(Color::RED, std::move(a), x,
+                  Recolor(std::move(c), Color::BLACK));
+    }
+    if (IsBlack(a.Get())) {
+      return Balance(Recolor(std::move(a), Color::RED), x, std::move(c));
+    }
+    Node* y = a->right;
+    return Copy(Color::RED,
+                Balance(Recolor(Retain(a->left), Color::RED), a.Get(),
+                        Retain(y->left)),
+                y, Copy(Color::BLACK, Retain(y->right), x, std::move(c)));
+  }
+
+  // Joins the subtrees of a removed node, all keys of a are less than the
+  // keys of b and both have the same black height.
+  static NodeRef Append(NodeRef a, NodeRef b) {
+    if (!a) return b;
+    if (!b) return a;
+    if (IsRed(a.Get()) && IsRed(b.Get())) {
+      NodeRef middle = Append(Retain(a->right), Retain(b->left));
+      if (IsRed(middle.Get())) {
+        return Copy(Color::RED,
+                    Copy(Color::RED, Retain(a->left), a.Get(),
+                         Retain(middle->left)),
+                    middle.Get(),
+                    Copy(Color::RED, Retain(middle->right), b.Get(),
+                         Retain(b->right)));
+      }
+      return Copy(Color::RED, Retain(a->left), a.Get(),
+                  Copy(Color::RED, std::move(middle), b.Get(),
+                       Retain(b->right)));
+    }
+    if (IsBlack(a.Get()) && IsBlack(b.Get())) {
+      NodeRef middle = Append(Retain(a->right), Retain(b->left));
+      if (IsRed(middle.Get())) {
+        return Copy(Color::RED,
+                    Copy(Color::BLACK, Retain(a->left), a.Get(),
+                         Retain(middle->left)),
+                    middle.Get(),
+                    Copy(Color::BLACK, Retain(middle->right), b.Get(),
+                         Retain(b->right)));
+      }
+      return BalanceLeft(Retain(a->left), a.Get(),
+                         Copy(Color::BLACK, std::move(middle), b.Get(),
+                              Retain(b->right)));
+    }
+    if (IsRed(b.Get())) {
+      return Copy(Color::RED, Append(std::move(a), Retain(b->left)), b.Get(),
+                  Retain(b->right));
+    }
+    return Copy(Color::RED, Retain(a->left), a.Get(),
+                Append(Retain(a->right), std::move(b)));
+  }
+};
+
+// Forward iterator over a snapshot. Without parent links it keeps the path
+// of nodes whose right part is still to be visited.
+template <typename Key, typename T>
+class PersistentMapIterator {
+  using Node = PersistentMapNode<Key, T>;
+
+ public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = std::pair<const Key, T>;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const value_type*;
+  using reference = const value_type&;
+
+  PersistentMapIterator() {}
+
+  reference operator*() const { return path_.back()->data; }
+  pointer operator->() const { return &path_.back()->data; }
+  PersistentMapIterator& operator++() {
+    const Node* node = path_.back()->right;
+    path_.pop_back();
+    PushLeft(node);
+    return *this;
+  }
+  PersistentMapIterator operator++(int) {
+    PersistentMapIterator result(*this);
+    ++*this;
+    return result;
+  }
+  bool operator==(const PersistentMapIterator& other) const {
+    return path_.empty() ? other.path_.empty()
+                         : !other.path_.empty() &&
+                               path_.back() == other.path_.back();
+  }
+  bool operator!=(const PersistentMapIterator& other) const {
+    return !(*this == other);
+  }
+
+ private:
+  template <typename, typename, typename>
+  friend class persistent_map;
+
+  explicit PersistentMapIterator(const Node* root) { PushLeft(root); }
+
+  void PushLeft(const Node* node) {
+    for (; node != nullptr; node = node->left) path_.push_back(node);
+  }
+
+  std::vector<const Node*> path_;
+};
+
+}  // namespace s21
+
+#endif  // CPP2_S21_CONTAINERS_1_SRC_MAP_S21_PERSISTENT_MAP_H_
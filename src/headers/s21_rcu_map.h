@@ -0,0 +1,168 @@
+#ifndef CPP2_S21_CONTAINERS_1_SRC_MAP_S21_RCU_MAP_H_
+#define CPP2_S21_CONTAINERS_1_SRC_MAP_S21_RCU_MAP_H_
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <optional>
+
+#include "EpochDomain.h"
+#include "s21_persistent_map.h"
+
+namespace s21 {
+
+// Map for read-mostly workloads. Readers look up and iterate without locks
+// and without atomic read-modify-write operations, writers are serialized and
+// publish a new version of the map for every change.
+//
+// Versions are persistent maps, so publishing one costs a path copy rather
+// than a copy of the map, and a version that readers may still see is freed
+// through epoch based reclamation once the last of them has left it.
+template <typename Key, typename T, typename Compare = std::less<Key>>
+class rcu_map {
+ public:
+  using key_type = Key;
+  using mapped_type = T;
+  using value_type = std::pair<const Key, T>;
+  using size_type = size_t;
+  using key_compare = Compare;
+  using map_type = persistent_map<Key, T, Compare>;
+
+  // Keeps the version of the map that was current when it was created alive
+  // and unchanged while it exists.
+  class read_guard {
+   public:
+    read_guard(read_guard&& other) noexcept
+        : domain_(other.domain_), slot_(other.slot_), map_(other.map_) {
+      other.slot_ = nullptr;
+    }
+    read_guard(const read_guard&) = delete;
+    read_guard& operator=(const read_guard&) = delete;
+    ~read_guard() {
+      if (slot_ != nullptr) domain_->Leave(slot_);
+    }
+
+    const map_type& operator*() const { return *map_; }
+    const map_type* operator->() const { return map_; }
+
+   private:
+    friend class rcu_map;
+
+    read_guard(EpochDomain* domain, EpochDomain::Slot* slot,
+               const map_type* map)
+        : domain_(domain), slot_(slot), map_(map) {}
+
+    EpochDomain* domain_;
+    EpochDomain::Slot* slot_;
+    const map_type* map_;
+  };
+
+  // The read side of one thread. It holds one reclamation slot, its
+  // read_guards may nest, and it must not outlive the map.
+  class reader {
+   public:
+    reader(reader&& other) noexcept : map_(other.map_), slot_(other.slot_) {
+      other.slot_ = nullptr;
+    }
+    reader(const reader&) = delete;
+    reader& operator=(const reader&) = delete;
+    ~reader() {
+      if (slot_ != nullptr) map_->domain_.Unregister(slot_);
+    }
+
+    read_guard pin() const {
+      map_->domain_.Enter(slot_);
+      return read_guard(&map_->domain_, slot_,
+                        map_->current_.load(std::memory_order_seq_cst));
+    }
+    bool contains(const Key& key) const { return pin()->contains(key); }
+    // Copy of the value for key, if there is one.
+    std::optional<T> get(const Key& key) const {
+      read_guard guard = pin();
+      const auto* node = guard->FindNode(key);
+      if (node == nullptr) return std::nullopt;
+      return node->data.second;
+    }
+    // Calls visit(value) without copying the value, if key is present.
+    template <typename Visit>
+    bool visit(const Key& key, Visit visit) const {
+      read_guard guard = pin();
+      const auto* node = guard->FindNode(key);
+      if (node != nullptr) visit(node->data.second);
+      return node != nullptr;
+    }
+
+   private:
+    friend class rcu_map;
+
+    explicit reader(rcu_map* map)
+        : map_(map), slot_(map->domain_.Register()) {}
+
+    rcu_map* map_;
+    EpochDomain::Slot* slot_;
+  };
+
+  rcu_map() : current_(new map_type()) {}
+  explicit rcu_map(const Compare& comp) : current_(new map_type(comp)) {}
+  rcu_map(const rcu_map&) = delete;
+  rcu_map& operator=(const rcu_map&) = delete;
+  // Every reader must be gone.
+  ~rcu_map() { delete current_.load(std::memory_order_relaxed); }
+
+  reader make_reader() { return reader(this); }
+
+  bool insert(const Key& key, const T& obj) {
+    bool inserted = false;
+    update([&](map_type& map) { inserted = map.insert(key, obj).second; });
+    return inserted;
+  }
+  template <typename M>
+  bool insert_or_assign(const Key& key, M&& obj) {
+    bool inserted = false;
+    update([&](map_type& map) {
+      inserted = map.insert_or_assign(key, std::forward<M>(obj)).second;
+    });
+    return inserted;
+  }
+  size_type erase(const Key& key) {
+    size_type erased = 0;
+    update([&](map_type& map) { erased = map.erase(key); });
+    return erased;
+  }
+  // Applies change(map_type&) to a copy of the current version and publishes
+  // the result, so that readers see all of its writes or none.
+  template <typename Change>
+  void update(Change change) {
+    std::lock_guard<std::mutex> lock(writer_);
+    map_type* previous = current_.load(std::memory_order_relaxed);
+    auto next = std::make_unique<map_type>(*previous);
+    change(*next);
+    current_.store(next.release(), std::memory_order_seq_cst);
+    domain_.Retire(previous);
+    domain_.Collect();
+  }
+
+  // A copy of the current version for the writing side.
+  map_type snapshot() const {
+    std::lock_guard<std::mutex> lock(writer_);
+    return *current_.load(std::memory_order_relaxed);
+  }
+  size_type size() const {
+    std::lock_guard<std::mutex> lock(writer_);
+    return current_.load(std::memory_order_relaxed)->size();
+  }
+  // Number of retired versions still waiting for readers to leave them.
+  size_type retired() const {
+    std::lock_guard<std::mutex> lock(writer_);
+    return domain_.Pending();
+  }
+
+ private:
+  std::atomic<map_type*> current_;
+  mutable std::mutex writer_;
+  EpochDomain domain_;
+};
+
+}  // namespace s21
+
+#endif  // CPP2_S21_CONTAINERS_1_SRC_MAP_S21_RCU_MAP_H_
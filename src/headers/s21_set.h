@@ -1,17 +1,33 @@
 #ifndef CPP2_S21_CONTAINERS_1_SRC_SET_S21_SET_H_
 #define CPP2_S21_CONTAINERS_1_SRC_SET_S21_SET_H_
 
+#include <algorithm>
+#include <iterator>
 #include <limits>
+#include <string>
 
 #include "RBTree.h"
+#include "SetAlgebra.h"
 
 namespace s21 {
 
 template <typename Key>
 class SetIterator;
 
-template <typename Key>
+// With Ranked set the tree keeps subtree sizes, which enables nth(), rank()
+// and count_range() at the cost of one counter per node.
+// With N > 0 a set of up to N elements keeps them sorted inside the object
+// and allocates nothing until it grows past N. Meanwhile every insertion and
+// erasure, as well as a move or swap, invalidates its iterators and
+// references to its elements. The object holds the N nodes even when empty,
+// so N pays off only where most sets come close to N elements.
+template <typename Key, typename Compare = std::less<Key>,
+          bool Ranked = false, size_t N = 0>
 class set {
+  using tree_type =
+      RBTree<Key, NoValue, Compare, Ranked ? Ranking::NODES : Ranking::NONE,
+             NodePool, N>;
+
  public:
   using key_type = Key;
   using value_type = Key;
@@ -20,14 +36,22 @@ class set {
   using iterator = SetIterator<Key>;
   using const_iterator = SetIterator<Key>;
   using size_type = size_t;
+  using key_compare = Compare;
+  using node_type = typename tree_type::node_type;
+  using insert_return_type = RBTreeInsertReturn<iterator, node_type>;
 
   set() {}
+  explicit set(const Compare& comp);
   set(std::initializer_list<value_type> const& items);
+  template <typename InputIt, typename = typename std::iterator_traits<
+                                  InputIt>::iterator_category>
+  set(InputIt first, InputIt last);
   set(const set& s);
-  set(set&& s);
+  set(const set& s, const ParallelPolicy& policy);
+  set(set&& s) noexcept(tree_type::kNothrowMove);
   ~set() {}
   set& operator=(const set& s);
-  set& operator=(set&& s);
+  set& operator=(set&& s) noexcept(tree_type::kNothrowMove);
   iterator begin();
   iterator end();
   const_iterator cbegin();
@@ -36,164 +60,558 @@ class set {
   size_type size() const;
   size_type max_size() const;
   void clear();
+  void clear_async(Reclaimer& reclaimer = Reclaimer::Global());
+  template <typename ForwardIt>
+  void assign_sorted(ForwardIt first, ForwardIt last);
+  void save(const std::string& path) const;
+  void load(const std::string& path);
   std::pair<iterator, bool> insert(const value_type& value);
+  std::pair<iterator, bool> insert(value_type&& value);
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args&&... args);
+  iterator insert(iterator hint, const value_type& value);
+  iterator insert(iterator hint, value_type&& value);
+  template <typename... Args>
+  iterator emplace_hint(iterator hint, Args&&... args);
   void erase(iterator pos);
-  void swap(set& other);
+  size_type erase(const Key& key);
+  void swap(set& other) noexcept(tree_type::kNothrowMove);
+  node_type extract(iterator pos);
+  node_type extract(const Key& key);
+  insert_return_type insert(node_type&& node);
   void merge(set& other);
+  set split_at(const Key& key);
+  void join(set& other);
   iterator find(const Key& key);
+  iterator find(iterator hint, const Key& key);
+  void find_many(const Key* keys, size_type count, iterator* out);
+  void contains_many(const Key* keys, size_type count, uint64_t* bits);
+  template <typename K, typename = RequireTransparent<Compare, K>>
+  iterator find(const K& key);
   bool contains(const Key& key);
+  template <typename K, typename = RequireTransparent<Compare, K>>
+  bool contains(const K& key);
+  size_type count(const Key& key);
+  template <typename K, typename = RequireTransparent<Compare, K>>
+  size_type count(const K& key);
+  std::pair<iterator, iterator> equal_range(const Key& key);
+  template <typename K, typename = RequireTransparent<Compare, K>>
+  std::pair<iterator, iterator> equal_range(const K& key);
+  iterator lower_bound(const Key& key);
+  template <typename K, typename = RequireTransparent<Compare, K>>
+  iterator lower_bound(const K& key);
+  iterator upper_bound(const Key& key);
+  template <typename K, typename = RequireTransparent<Compare, K>>
+  iterator upper_bound(const K& key);
+  key_compare key_comp() const;
+  RBTreeStats stats() const;
+
+  iterator nth(size_type index);
+  size_type rank(const Key& key) const;
+  size_type count_range(const Key& lo, const Key& hi) const;
+
+  set set_union(set& other, const ParallelPolicy& policy = ParallelPolicy());
+  set set_intersection(set& other,
+                       const ParallelPolicy& policy = ParallelPolicy());
+  set set_difference(set& other,
+                     const ParallelPolicy& policy = ParallelPolicy());
+  set symmetric_difference(set& other,
+                           const ParallelPolicy& policy = ParallelPolicy());
 
  private:
-  RBTree<Key, bool> tree;
+  tree_type tree;
+
+  template <typename InputIt>
+  void assign_range(InputIt first, InputIt last);
+  set combine(set& other, SetOperation op, const ParallelPolicy& policy);
 };
 
+// Free forms of the set operations, the result is a new set.
+template <typename Key, typename Compare, bool Ranked, size_t N>
+set<Key, Compare, Ranked, N> set_union(
+    set<Key, Compare, Ranked, N>& a, set<Key, Compare, Ranked, N>& b,
+    const ParallelPolicy& policy = ParallelPolicy()) {
+  return a.set_union(b, policy);
+}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+set<Key, Compare, Ranked, N> set_intersection(
+    set<Key, Compare, Ranked, N>& a, set<Key, Compare, Ranked, N>& b,
+    const ParallelPolicy& policy = ParallelPolicy()) {
+  return a.set_intersection(b, policy);
+}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+set<Key, Compare, Ranked, N> set_difference(
+    set<Key, Compare, Ranked, N>& a, set<Key, Compare, Ranked, N>& b,
+    const ParallelPolicy& policy = ParallelPolicy()) {
+  return a.set_difference(b, policy);
+}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+set<Key, Compare, Ranked, N> symmetric_difference(
+    set<Key, Compare, Ranked, N>& a, set<Key, Compare, Ranked, N>& b,
+    const ParallelPolicy& policy = ParallelPolicy()) {
+  return a.symmetric_difference(b, policy);
+}
+
 template <typename Key>
-class SetIterator : public RBTreeIterator<Key, bool> {
+class SetIterator : public RBTreeIterator<Key, NoValue> {
  public:
   using key_type = Key;
   using value_type = Key;
-  SetIterator() : RBTreeIterator<Key, bool>() {}
-  SetIterator(const RBTreeIterator<Key, bool>& rbiter)
-      : RBTreeIterator<Key, bool>(rbiter) {}
-  SetIterator(const SetIterator& other) : RBTreeIterator<Key, bool>(other) {}
+  SetIterator() : RBTreeIterator<Key, NoValue>() {}
+  SetIterator(const RBTreeIterator<Key, NoValue>& rbiter)
+      : RBTreeIterator<Key, NoValue>(rbiter) {}
+  SetIterator(const SetIterator& other) : RBTreeIterator<Key, NoValue>(other) {}
   SetIterator(SetIterator&& other)
-      : RBTreeIterator<Key, bool>(std::move(other)) {}
+      : RBTreeIterator<Key, NoValue>(std::move(other)) {}
   SetIterator& operator=(const SetIterator& other);
   SetIterator& operator=(SetIterator&& other);
   SetIterator& operator++();
   SetIterator operator++(int);
   SetIterator& operator--();
   SetIterator operator--(int);
-  const value_type& operator*() const { return this->node->data.first; }
-  const value_type* operator->() const { return this->node->data.first; }
+  const value_type& operator*() const { return this->GetNode()->data.first; }
+  const value_type* operator->() const {
+    return &(this->GetNode()->data.first);
+  }
 };
 
-template <typename Key>
-set<Key>::set(std::initializer_list<value_type> const& items) {
-  for (auto item : items) {
-    tree.Insert(item, true);
-  }
+template <typename Key, typename Compare, bool Ranked, size_t N>
+set<Key, Compare, Ranked, N>::set(const Compare& comp) : tree(comp) {}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+set<Key, Compare, Ranked, N>::set(
+    std::initializer_list<value_type> const& items) {
+  assign_range(items.begin(), items.end());
 }
 
-template <typename Key>
-set<Key>::set(const set& s) : tree(s.tree) {}
+template <typename Key, typename Compare, bool Ranked, size_t N>
+template <typename InputIt, typename>
+set<Key, Compare, Ranked, N>::set(InputIt first, InputIt last) {
+  assign_range(first, last);
+}
 
-template <typename Key>
-set<Key>::set(set&& s) : tree(std::move(s.tree)) {}
+template <typename Key, typename Compare, bool Ranked, size_t N>
+set<Key, Compare, Ranked, N>::set(const set& s) : tree(s.tree) {}
 
-template <typename Key>
-set<Key>& set<Key>::operator=(const set& s) {
+// Copies with the given threads instead of those of ParallelCopyPolicy().
+template <typename Key, typename Compare, bool Ranked, size_t N>
+set<Key, Compare, Ranked, N>::set(const set& s, const ParallelPolicy& policy)
+    : tree(s.tree, policy) {}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+set<Key, Compare, Ranked, N>::set(set&& s) noexcept(tree_type::kNothrowMove)
+    : tree(std::move(s.tree)) {}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+set<Key, Compare, Ranked, N>& set<Key, Compare, Ranked, N>::operator=(
+    const set& s) {
   tree = s.tree;
   return *this;
 }
 
-template <typename Key>
-set<Key>& set<Key>::operator=(set&& s) {
+template <typename Key, typename Compare, bool Ranked, size_t N>
+set<Key, Compare, Ranked, N>& set<Key, Compare, Ranked, N>::operator=(
+    set&& s) noexcept(tree_type::kNothrowMove) {
   tree = std::move(s.tree);
   return *this;
 }
 
-template <typename Key>
-typename set<Key>::iterator set<Key>::begin() {
+template <typename Key, typename Compare, bool Ranked, size_t N>
+typename set<Key, Compare, Ranked, N>::iterator
+set<Key, Compare, Ranked, N>::begin() {
   return iterator(tree.begin());
 }
 
-template <typename Key>
-typename set<Key>::iterator set<Key>::end() {
+template <typename Key, typename Compare, bool Ranked, size_t N>
+typename set<Key, Compare, Ranked, N>::iterator
+set<Key, Compare, Ranked, N>::end() {
   return iterator(tree.end());
 }
 
-template <typename Key>
-typename set<Key>::const_iterator set<Key>::cbegin() {
+template <typename Key, typename Compare, bool Ranked, size_t N>
+typename set<Key, Compare, Ranked, N>::const_iterator
+set<Key, Compare, Ranked, N>::cbegin() {
   return const_iterator(tree.begin());
 }
 
-template <typename Key>
-typename set<Key>::const_iterator set<Key>::cend() {
+template <typename Key, typename Compare, bool Ranked, size_t N>
+typename set<Key, Compare, Ranked, N>::const_iterator
+set<Key, Compare, Ranked, N>::cend() {
   return const_iterator(tree.end());
 }
 
-template <typename Key>
-bool set<Key>::empty() const {
+template <typename Key, typename Compare, bool Ranked, size_t N>
+bool set<Key, Compare, Ranked, N>::empty() const {
   return tree.empty();
 }
 
-template <typename Key>
-typename set<Key>::size_type set<Key>::size() const {
+template <typename Key, typename Compare, bool Ranked, size_t N>
+typename set<Key, Compare, Ranked, N>::size_type
+set<Key, Compare, Ranked, N>::size() const {
   return tree.size();
 }
 
-template <typename Key>
-typename set<Key>::size_type set<Key>::max_size() const {
+template <typename Key, typename Compare, bool Ranked, size_t N>
+typename set<Key, Compare, Ranked, N>::size_type
+set<Key, Compare, Ranked, N>::max_size() const {
   return std::numeric_limits<size_t>::max() / sizeof(value_type);
 }
 
-template <typename Key>
-void set<Key>::clear() {
+template <typename Key, typename Compare, bool Ranked, size_t N>
+void set<Key, Compare, Ranked, N>::clear() {
   tree.clear();
 }
 
-template <typename Key>
-std::pair<typename set<Key>::iterator, bool> set<Key>::insert(
-    const value_type& value) {
-  try {
-    iterator place = tree.Insert(value, true);
-    return std::make_pair(place, true);
-  } catch (std::logic_error const&) {
-    return std::make_pair(tree.end(), false);
+// Empties the set in O(1), the keys are destroyed and their memory is freed
+// on the thread of reclaimer.
+template <typename Key, typename Compare, bool Ranked, size_t N>
+void set<Key, Compare, Ranked, N>::clear_async(Reclaimer& reclaimer) {
+  tree.ClearAsync(reclaimer);
+}
+
+// [first, last) must be strictly increasing; the tree is then built in
+// linear time instead of inserting element by element.
+template <typename Key, typename Compare, bool Ranked, size_t N>
+template <typename ForwardIt>
+void set<Key, Compare, Ranked, N>::assign_sorted(ForwardIt first,
+                                                 ForwardIt last) {
+  tree.AssignSorted(std::distance(first, last), [&first]() {
+    return RBTreeKey<Key>(*first++);
+  });
+}
+
+// Writes the keys to path in a binary format that load() reads back in
+// linear time. Keys must be trivially copyable. Both need RBTreeArchive.h.
+template <typename Key, typename Compare, bool Ranked, size_t N>
+void set<Key, Compare, Ranked, N>::save(const std::string& path) const {
+  tree.Save(path, ArchiveKind::SET);
+}
+
+// Replaces the contents with a set saved to path. Throws std::system_error if
+// the file cannot be read and std::runtime_error if it was not saved by a set
+// of the same key type or is damaged, the set is then left unchanged.
+template <typename Key, typename Compare, bool Ranked, size_t N>
+void set<Key, Compare, Ranked, N>::load(const std::string& path) {
+  tree.Load(path, ArchiveKind::SET, [](const auto&) { return true; });
+}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+template <typename InputIt>
+void set<Key, Compare, Ranked, N>::assign_range(InputIt first, InputIt last) {
+  using category = typename std::iterator_traits<InputIt>::iterator_category;
+  if constexpr (std::is_base_of_v<std::forward_iterator_tag, category>) {
+    Compare comp = key_comp();
+    auto unsorted =
+        std::adjacent_find(first, last, [&comp](const Key& a, const Key& b) {
+          return !comp(a, b);
+        });
+    if (unsorted == last) {
+      assign_sorted(first, last);
+      return;
+    }
   }
+  for (; first != last; ++first) insert(end(), *first);
 }
 
-template <typename Key>
-void set<Key>::erase(iterator pos) {
+template <typename Key, typename Compare, bool Ranked, size_t N>
+std::pair<typename set<Key, Compare, Ranked, N>::iterator, bool>
+set<Key, Compare, Ranked, N>::insert(const value_type& value) {
+  return tree.InsertUnique(value, NoValue());
+}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+std::pair<typename set<Key, Compare, Ranked, N>::iterator, bool>
+set<Key, Compare, Ranked, N>::insert(value_type&& value) {
+  return tree.InsertUnique(std::move(value), NoValue());
+}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+template <typename... Args>
+std::pair<typename set<Key, Compare, Ranked, N>::iterator, bool>
+set<Key, Compare, Ranked, N>::emplace(Args&&... args) {
+  return tree.EmplaceUnique(std::piecewise_construct,
+                            std::forward_as_tuple(std::forward<Args>(args)...),
+                            std::forward_as_tuple());
+}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+typename set<Key, Compare, Ranked, N>::iterator
+set<Key, Compare, Ranked, N>::insert(iterator hint, const value_type& value) {
+  return tree.TryEmplaceHint(hint, value, NoValue()).first;
+}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+typename set<Key, Compare, Ranked, N>::iterator
+set<Key, Compare, Ranked, N>::insert(iterator hint, value_type&& value) {
+  return tree.TryEmplaceHint(hint, std::move(value), NoValue()).first;
+}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+template <typename... Args>
+typename set<Key, Compare, Ranked, N>::iterator
+set<Key, Compare, Ranked, N>::emplace_hint(iterator hint, Args&&... args) {
+  return tree
+      .EmplaceUniqueHint(hint, std::piecewise_construct,
+                         std::forward_as_tuple(std::forward<Args>(args)...),
+                         std::forward_as_tuple())
+      .first;
+}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+void set<Key, Compare, Ranked, N>::erase(iterator pos) {
   if (pos != end()) {
-    typename RBTree<Key, bool>::iterator& tree_pos = pos;
-    tree.Delete(tree_pos->data.first);
+    tree.Erase(pos);
   }
 }
 
-template <typename Key>
-void set<Key>::swap(set& other) {
-  std::swap(tree, other.tree);
+template <typename Key, typename Compare, bool Ranked, size_t N>
+typename set<Key, Compare, Ranked, N>::size_type
+set<Key, Compare, Ranked, N>::erase(const Key& key) {
+  return tree.EraseUnique(key);
 }
 
-template <typename Key>
-void set<Key>::merge(set& other) {
-  if (tree == other.tree) return;
-  auto iter = other.begin();
-  while (iter != other.end()) {
-    auto value = *iter++;
-    if (insert(value).second) {
-      other.tree.Delete(value);
-    }
-  }
+template <typename Key, typename Compare, bool Ranked, size_t N>
+void set<Key, Compare, Ranked, N>::swap(set& other)
+    noexcept(tree_type::kNothrowMove) {
+  tree.Swap(other.tree);
 }
 
-template <typename Key>
-typename set<Key>::iterator set<Key>::find(const Key& key) {
+template <typename Key, typename Compare, bool Ranked, size_t N>
+typename set<Key, Compare, Ranked, N>::node_type
+set<Key, Compare, Ranked, N>::extract(iterator pos) {
+  return tree.Extract(pos);
+}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+typename set<Key, Compare, Ranked, N>::node_type
+set<Key, Compare, Ranked, N>::extract(const Key& key) {
+  iterator pos = find(key);
+  if (pos == end()) return node_type();
+  return extract(pos);
+}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+typename set<Key, Compare, Ranked, N>::insert_return_type
+set<Key, Compare, Ranked, N>::insert(node_type&& node) {
+  auto [pos, inserted] = tree.InsertNode(node);
+  return {iterator(pos), inserted, std::move(node)};
+}
+
+// Relinks the nodes whose keys are missing here, the rest stays in other.
+template <typename Key, typename Compare, bool Ranked, size_t N>
+void set<Key, Compare, Ranked, N>::merge(set& other) {
+  tree.Merge(other.tree, [](auto, auto) { return false; });
+}
+
+// Moves the elements not less than key into the returned set. The tree is cut
+// in O(log n), elements are neither copied nor reallocated. Unless the set is
+// Ranked, the sizes of both sets are then unknown, and the first size() of
+// each counts its elements in linear time.
+template <typename Key, typename Compare, bool Ranked, size_t N>
+set<Key, Compare, Ranked, N> set<Key, Compare, Ranked, N>::split_at(
+    const Key& key) {
+  set upper(key_comp());
+  tree.Split(key, upper.tree);
+  return upper;
+}
+
+// Takes over all elements of other in O(log n). They must all be less or all
+// be greater than ours, otherwise std::invalid_argument is thrown.
+template <typename Key, typename Compare, bool Ranked, size_t N>
+void set<Key, Compare, Ranked, N>::join(set& other) {
+  tree.Join(other.tree);
+}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+typename set<Key, Compare, Ranked, N>::iterator
+set<Key, Compare, Ranked, N>::find(const Key& key) {
   return iterator(tree.find(key));
 }
 
-template <typename Key>
-bool set<Key>::contains(const Key& key) {
+template <typename Key, typename Compare, bool Ranked, size_t N>
+typename set<Key, Compare, Ranked, N>::iterator
+set<Key, Compare, Ranked, N>::find(iterator hint, const Key& key) {
+  return iterator(tree.FindHint(hint, key));
+}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+template <typename K, typename>
+typename set<Key, Compare, Ranked, N>::iterator
+set<Key, Compare, Ranked, N>::find(const K& key) {
+  return iterator(tree.find(key));
+}
+
+// Looks up keys[0, count) with their descents interleaved, so that the cache
+// misses overlap, and stores the result for keys[i] in out[i].
+template <typename Key, typename Compare, bool Ranked, size_t N>
+void set<Key, Compare, Ranked, N>::find_many(const Key* keys, size_type count,
+                                             iterator* out) {
+  tree.FindMany(keys, count, out);
+}
+
+// Bit i % 64 of bits[i / 64] tells whether keys[i] is present. bits must hold
+// (count + 63) / 64 words.
+template <typename Key, typename Compare, bool Ranked, size_t N>
+void set<Key, Compare, Ranked, N>::contains_many(const Key* keys,
+                                                 size_type count,
+                                                 uint64_t* bits) {
+  tree.ContainsMany(keys, count, bits);
+}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+bool set<Key, Compare, Ranked, N>::contains(const Key& key) {
+  return tree.at(key);
+}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+template <typename K, typename>
+bool set<Key, Compare, Ranked, N>::contains(const K& key) {
   return tree.at(key);
 }
 
+template <typename Key, typename Compare, bool Ranked, size_t N>
+typename set<Key, Compare, Ranked, N>::size_type
+set<Key, Compare, Ranked, N>::count(const Key& key) {
+  return tree.at(key) != nullptr;
+}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+template <typename K, typename>
+typename set<Key, Compare, Ranked, N>::size_type
+set<Key, Compare, Ranked, N>::count(const K& key) {
+  return tree.at(key) != nullptr;
+}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+std::pair<typename set<Key, Compare, Ranked, N>::iterator,
+          typename set<Key, Compare, Ranked, N>::iterator>
+set<Key, Compare, Ranked, N>::equal_range(const Key& key) {
+  return std::make_pair(lower_bound(key), upper_bound(key));
+}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+template <typename K, typename>
+std::pair<typename set<Key, Compare, Ranked, N>::iterator,
+          typename set<Key, Compare, Ranked, N>::iterator>
+set<Key, Compare, Ranked, N>::equal_range(const K& key) {
+  return std::make_pair(lower_bound(key), upper_bound(key));
+}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+typename set<Key, Compare, Ranked, N>::iterator
+set<Key, Compare, Ranked, N>::lower_bound(const Key& key) {
+  return iterator(tree.LowerBound(key));
+}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+template <typename K, typename>
+typename set<Key, Compare, Ranked, N>::iterator
+set<Key, Compare, Ranked, N>::lower_bound(const K& key) {
+  return iterator(tree.LowerBound(key));
+}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+typename set<Key, Compare, Ranked, N>::iterator
+set<Key, Compare, Ranked, N>::upper_bound(const Key& key) {
+  return iterator(tree.UpperBound(key));
+}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+template <typename K, typename>
+typename set<Key, Compare, Ranked, N>::iterator
+set<Key, Compare, Ranked, N>::upper_bound(const K& key) {
+  return iterator(tree.UpperBound(key));
+}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+typename set<Key, Compare, Ranked, N>::key_compare
+set<Key, Compare, Ranked, N>::key_comp() const {
+  return tree.key_comp();
+}
+
+// Shape of the tree and, in builds with S21_RBTREE_STATS, counts of the
+// comparisons and rebalancing work done so far. Takes O(n).
+template <typename Key, typename Compare, bool Ranked, size_t N>
+RBTreeStats set<Key, Compare, Ranked, N>::stats() const {
+  return tree.Stats();
+}
+
+// Returns the element at position index in sorted order, or end().
+template <typename Key, typename Compare, bool Ranked, size_t N>
+typename set<Key, Compare, Ranked, N>::iterator
+set<Key, Compare, Ranked, N>::nth(size_type index) {
+  return iterator(tree.Select(index).first);
+}
+
+// Number of elements less than key.
+template <typename Key, typename Compare, bool Ranked, size_t N>
+typename set<Key, Compare, Ranked, N>::size_type
+set<Key, Compare, Ranked, N>::rank(const Key& key) const {
+  return tree.Rank(key);
+}
+
+// Number of elements in [lo, hi).
+template <typename Key, typename Compare, bool Ranked, size_t N>
+typename set<Key, Compare, Ranked, N>::size_type
+set<Key, Compare, Ranked, N>::count_range(const Key& lo, const Key& hi) const {
+  if (!tree.key_comp()(lo, hi)) return 0;
+  return tree.Rank(hi) - tree.Rank(lo);
+}
+
+// The set operations run on the trees directly and build the result without
+// inserting element by element, on several threads for large inputs.
+template <typename Key, typename Compare, bool Ranked, size_t N>
+set<Key, Compare, Ranked, N> set<Key, Compare, Ranked, N>::set_union(
+    set& other, const ParallelPolicy& policy) {
+  return combine(other, SetOperation::UNION, policy);
+}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+set<Key, Compare, Ranked, N>
+set<Key, Compare, Ranked, N>::set_intersection(
+    set& other, const ParallelPolicy& policy) {
+  return combine(other, SetOperation::INTERSECTION, policy);
+}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+set<Key, Compare, Ranked, N> set<Key, Compare, Ranked, N>::set_difference(
+    set& other, const ParallelPolicy& policy) {
+  return combine(other, SetOperation::DIFFERENCE, policy);
+}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+set<Key, Compare, Ranked, N>
+set<Key, Compare, Ranked, N>::symmetric_difference(
+    set& other, const ParallelPolicy& policy) {
+  return combine(other, SetOperation::SYMMETRIC, policy);
+}
+
+template <typename Key, typename Compare, bool Ranked, size_t N>
+set<Key, Compare, Ranked, N> set<Key, Compare, Ranked, N>::combine(
+    set& other, SetOperation op, const ParallelPolicy& policy) {
+  set result(key_comp());
+  result.tree = CombineTrees(tree, other.tree, op, policy);
+  return result;
+}
+
 template <typename Key>
 SetIterator<Key>& SetIterator<Key>::operator=(const SetIterator& other) {
-  RBTreeIterator<Key, bool>::operator=(other);
+  RBTreeIterator<Key, NoValue>::operator=(other);
   return *this;
 }
 
 template <typename Key>
 SetIterator<Key>& SetIterator<Key>::operator=(SetIterator&& other) {
-  RBTreeIterator<Key, bool>::operator=(std::move(other));
+  RBTreeIterator<Key, NoValue>::operator=(std::move(other));
   return *this;
 }
 
 template <typename Key>
 SetIterator<Key>& SetIterator<Key>::operator++() {
-  this->RBTreeIterator<Key, bool>::operator++();
+  this->RBTreeIterator<Key, NoValue>::operator++();
   return *this;
 }
 
@@ -206,7 +624,7 @@ SetIterator<Key> SetIterator<Key>::operator++(int) {
 
 template <typename Key>
 SetIterator<Key>& SetIterator<Key>::operator--() {
-  this->RBTreeIterator<Key, bool>::operator--();
+  this->RBTreeIterator<Key, NoValue>::operator--();
   return *this;
 }
 
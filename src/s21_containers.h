@@ -1,11 +1,16 @@
 #ifndef CPP2_S21_CONTAINERS_SRC_S21_CONTAINERS_H_
 #define CPP2_S21_CONTAINERS_SRC_S21_CONTAINERS_H_
 
+#include "headers/s21_concurrent_map.h"
 #include "headers/s21_list.h"
 #include "headers/s21_map.h"
+#include "headers/s21_mapped_map.h"
 #include "headers/s21_queue.h"
+#include "headers/s21_rcu_map.h"
 #include "headers/s21_set.h"
 #include "headers/s21_multiset.h"
+#include "headers/s21_persistent_map.h"
+#include "headers/RBTreeArchive.h"
 #include "headers/s21_stack.h"
 #include "headers/s21_vector.h"
 #include "headers/s21_array.h"
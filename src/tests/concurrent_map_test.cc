@@ -0,0 +1,244 @@
+#include <atomic>
+#include <thread>
+
+#include "test_header.h"
+
+namespace {
+
+struct Counted {
+  static std::atomic<int> live;
+  explicit Counted(int v) : value(v) { ++live; }
+  Counted(const Counted& other) : value(other.value) { ++live; }
+  ~Counted() { --live; }
+  int value;
+};
+
+std::atomic<int> Counted::live{0};
+
+}  // namespace
+
+TEST(concurrent_map_test, against_std) {
+  s21::concurrent_map<int, int> m1;
+  std::map<int, int> m2;
+  unsigned state = 3;
+  for (int i = 0; i < 20000; ++i) {
+    state = state * 1103515245 + 12345;
+    int key = static_cast<int>((state >> 8) % 2000);
+    if (i % 3 == 0) {
+      EXPECT_EQ(m1.erase(key), m2.erase(key));
+    } else {
+      EXPECT_EQ(m1.insert(key, i).second, m2.insert({key, i}).second);
+    }
+  }
+  EXPECT_EQ(m1.size(), m2.size());
+  auto it = m1.begin();
+  for (const auto& item : m2) {
+    ASSERT_TRUE(it != m1.end());
+    EXPECT_EQ(it->first, item.first);
+    EXPECT_EQ((it++)->second, item.second);
+  }
+  EXPECT_TRUE(it == m1.end());
+  for (int key = -1; key < 2001; ++key) {
+    EXPECT_EQ(m1.contains(key), m2.count(key) == 1);
+    auto lower = m2.lower_bound(key);
+    auto found = m1.lower_bound(key);
+    if (lower == m2.end()) {
+      EXPECT_TRUE(found == m1.end());
+    } else {
+      EXPECT_EQ(found->first, lower->first);
+    }
+    EXPECT_EQ(m1.find(key) == m1.end(), m2.find(key) == m2.end());
+  }
+  auto inserted = m1.insert({5000, 1});
+  EXPECT_TRUE(inserted.second);
+  EXPECT_EQ(inserted.first->first, 5000);
+  m1.clear();
+  EXPECT_TRUE(m1.empty());
+  EXPECT_TRUE(m1.begin() == m1.end());
+}
+
+TEST(concurrent_map_test, erase_while_iterating) {
+  s21::concurrent_map<int, int> m1 = {{1, 1}, {2, 2}, {3, 3}, {4, 4}};
+  std::vector<int> seen;
+  for (auto it = m1.begin(); it != m1.end(); ++it) {
+    seen.push_back(it->first);
+    m1.erase(it->first + 1);
+  }
+  EXPECT_EQ(seen, std::vector<int>({1, 3}));
+}
+
+// Writers insert and erase their own keys while readers walk the map. Every
+// walk must be in order, and every node must be freed in the end.
+TEST(concurrent_map_test, many_writers) {
+  constexpr int kWriters = 4;
+  constexpr int kKeys = 3000;
+  {
+    s21::concurrent_map<int, Counted> m1;
+    std::atomic<bool> done{false};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kWriters; ++t) {
+      threads.emplace_back([&m1, t]() {
+        for (int round = 0; round < 3; ++round) {
+          for (int i = t; i < kKeys; i += kWriters) m1.insert(i, Counted(i));
+          for (int i = t; i < kKeys; i += 2 * kWriters) m1.erase(i);
+        }
+      });
+    }
+    std::thread reader([&m1, &done]() {
+      while (!done.load()) {
+        int last = -1;
+        for (const auto& item : m1) {
+          EXPECT_LT(last, item.first);
+          EXPECT_EQ(item.first, item.second.value);
+          last = item.first;
+        }
+      }
+    });
+    for (std::thread& thread : threads) thread.join();
+    done = true;
+    reader.join();
+    EXPECT_EQ(m1.size(), kKeys / 2);
+    for (int i = 0; i < kKeys; ++i) {
+      EXPECT_EQ(m1.contains(i), i % (2 * kWriters) >= kWriters);
+    }
+  }
+  EXPECT_EQ(Counted::live, 0);
+}
+
+namespace {
+
+// A key that can tell when it is read after its node was destroyed.
+struct Probe {
+  static constexpr uint32_t kAlive = 0x600DF00D;
+  explicit Probe(int v) : value(v) {}
+  Probe(const Probe& other) : value(other.value) {}
+  ~Probe() { magic = 0; }
+  int value;
+  uint32_t magic = kAlive;
+};
+
+// Lets the test stop the inserting and the removing thread inside a search.
+struct Gate {
+  std::atomic<std::thread::id> inserter;
+  std::atomic<std::thread::id> remover;
+  std::atomic<int> phase{0};
+  std::atomic<size_t> sizeAfterErase{0};
+  std::atomic<bool> touchedDead{false};
+  int key = 0;
+  const s21::concurrent_map<Probe, int, struct GatedLess>* map = nullptr;
+};
+
+struct GatedLess {
+  Gate* gate;
+  bool operator()(const Probe& a, const Probe& b) const;
+};
+
+bool GatedLess::operator()(const Probe& a, const Probe& b) const {
+  if (a.magic != Probe::kAlive || b.magic != Probe::kAlive) {
+    gate->touchedDead = true;
+  }
+  std::thread::id self = std::this_thread::get_id();
+  if (self == gate->inserter.load() && gate->phase == 0 &&
+      a.value == gate->key && b.value == gate->key) {
+    // The inserter passes the old node on its top level, and goes on once
+    // the remover has marked it and is about to unlink it.
+    gate->phase = 1;
+    while (gate->phase < 3) std::this_thread::yield();
+  } else if (self == gate->remover.load() && gate->phase == 2 &&
+             gate->map->size() == gate->sizeAfterErase) {
+    gate->phase = 3;
+    while (gate->phase < 4) std::this_thread::yield();
+  }
+  return a.value < b.value;
+}
+
+}  // namespace
+
+// An insert that saw the old node of its key on an upper level, before it was
+// erased, links its new node in front of it there. Unlinking the old node
+// must not stop at the new one, which has the same key.
+TEST(concurrent_map_test, reinsert_while_erasing) {
+  Gate gate;
+  s21::concurrent_map<Probe, int, GatedLess> map(GatedLess{&gate});
+  gate.map = &map;
+  gate.remover = std::this_thread::get_id();
+  gate.phase = 5;
+  for (int key = 0; key < 100; ++key) map.insert(Probe(key), key);
+  for (int round = 0; round < 300; ++round) {
+    gate.key = 1000 + 2 * round;
+    map.insert(Probe(gate.key), 0);
+    gate.sizeAfterErase = map.size() - 1;
+    gate.phase = 0;
+    std::thread inserter([&]() {
+      // Node heights come from a per thread sequence, this varies them.
+      for (int skip = 0; skip < round % 16; ++skip) {
+        map.insert(Probe(-1), 0);
+        map.erase(Probe(-1));
+      }
+      gate.inserter = std::this_thread::get_id();
+      map.insert(Probe(gate.key), 1);
+      gate.inserter = std::thread::id();
+      gate.phase = 4;
+    });
+    while (gate.phase < 1) std::this_thread::yield();
+    gate.phase = 2;
+    map.erase(Probe(gate.key));
+    inserter.join();
+    gate.phase = 5;
+    for (int key = 0; key < 100; ++key) {
+      map.erase(Probe(key));
+      map.insert(Probe(key), key);
+    }
+    for (int key = 999; key < gate.key + 2; ++key) map.contains(Probe(key));
+    ASSERT_FALSE(gate.touchedDead) << "round " << round;
+  }
+}
+
+TEST(concurrent_map_test, more_domains_than_cached_slots) {
+  std::vector<std::unique_ptr<s21::EpochDomain>> domains;
+  for (int i = 0; i < 12; ++i) {
+    domains.push_back(std::make_unique<s21::EpochDomain>());
+  }
+  for (int round = 0; round < 100; ++round) {
+    for (auto& domain : domains) s21::EpochDomain::Guard guard(*domain);
+  }
+  for (auto& domain : domains) EXPECT_EQ(domain->SlotCount(), 1U);
+  {
+    // Slots in a read section are not given back while the guards live.
+    std::vector<std::unique_ptr<s21::EpochDomain::Guard>> guards;
+    for (auto& domain : domains) {
+      guards.push_back(std::make_unique<s21::EpochDomain::Guard>(*domain));
+    }
+    for (size_t i = 0; i < guards.size(); ++i) {
+      EXPECT_EQ(guards[i]->slot(), domains[i]->LocalSlot());
+    }
+  }
+  std::vector<s21::concurrent_map<int, int>> maps(9);
+  for (int i = 0; i < 1000; ++i) {
+    maps[i % maps.size()].insert(i, i);
+    EXPECT_TRUE(maps[i % maps.size()].contains(i));
+  }
+}
+
+TEST(concurrent_map_test, slots_of_exited_threads_are_reused) {
+  int live_before = Counted::live;
+  s21::EpochDomain domain;
+  for (int i = 0; i < 20; ++i) {
+    std::thread([&domain, i]() {
+      s21::EpochDomain::Guard guard(domain);
+      domain.Retire(guard.slot(), new Counted(i), [](void* object) {
+        delete static_cast<Counted*>(object);
+      });
+    }).join();
+  }
+  EXPECT_EQ(domain.SlotCount(), 1U);
+  EXPECT_LE(Counted::live - live_before, 1);
+  s21::concurrent_map<int, int> map;
+  for (int i = 0; i < 20; ++i) {
+    std::thread([&map, i]() {
+      map.insert(i, i);
+      map.erase(i);
+    }).join();
+  }
+  EXPECT_TRUE(map.empty());
+}
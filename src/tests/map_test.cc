@@ -226,5 +226,490 @@ TEST(map, MergeMap) {
     EXPECT_TRUE((*my_it).second == (*orig_it).second);
   }
   EXPECT_EQ(my_map_merge.contains(4), true);
-  EXPECT_EQ(my_map_merge.contains(3), true);
+  EXPECT_EQ(my_map_merge.contains(3), false);
+  EXPECT_EQ(my_map_merge.size(), orig_map_merge.size());
+}
+
+TEST(map, RangeConstructorMap) {
+  std::vector<std::pair<int, char>> items = {
+      {5, 'e'}, {1, 'a'}, {3, 'c'}, {1, 'z'}, {4, 'd'}};
+  s21::map<int, char> my_map(items.begin(), items.end());
+  std::map<int, char> orig_map(items.begin(), items.end());
+  EXPECT_EQ(my_map.size(), orig_map.size());
+  auto my_it = my_map.begin();
+  for (auto orig_it = orig_map.begin(); orig_it != orig_map.end();
+       ++my_it, ++orig_it) {
+    EXPECT_EQ((*my_it).first, (*orig_it).first);
+    EXPECT_EQ((*my_it).second, (*orig_it).second);
+  }
+}
+
+TEST(map, AssignSortedMap) {
+  std::map<int, std::string> orig_map;
+  for (int i = 0; i < 1000; ++i) orig_map[i * 2] = std::to_string(i);
+  s21::map<int, std::string> my_map = {{-1, "gone"}};
+  my_map.assign_sorted(orig_map.begin(), orig_map.end());
+  EXPECT_EQ(my_map.size(), orig_map.size());
+  EXPECT_FALSE(my_map.contains(-1));
+  auto my_it = my_map.begin();
+  for (auto orig_it = orig_map.begin(); orig_it != orig_map.end();
+       ++my_it, ++orig_it) {
+    EXPECT_EQ((*my_it).first, (*orig_it).first);
+    EXPECT_EQ((*my_it).second, (*orig_it).second);
+  }
+  my_map.insert(1, "odd");
+  my_map.erase(my_map.begin());
+  EXPECT_EQ((*my_map.begin()).first, 1);
+}
+
+TEST(map, InsertDuplicateMap) {
+  s21::map<int, char> my_map = {{1, 'a'}, {2, 'b'}};
+  auto result = my_map.insert(2, 'z');
+  EXPECT_FALSE(result.second);
+  EXPECT_EQ((*result.first).first, 2);
+  EXPECT_EQ((*result.first).second, 'b');
+  EXPECT_EQ(my_map.size(), 2);
+}
+
+TEST(map, EraseKeyMap) {
+  s21::map<int, char> my_map = {{1, 'a'}, {2, 'b'}, {3, 'c'}};
+  std::map<int, char> orig_map = {{1, 'a'}, {2, 'b'}, {3, 'c'}};
+  EXPECT_EQ(my_map.erase(2), orig_map.erase(2));
+  EXPECT_EQ(my_map.erase(2), orig_map.erase(2));
+  EXPECT_EQ(my_map.size(), orig_map.size());
+  EXPECT_FALSE(my_map.contains(2));
+}
+
+namespace {
+
+struct Tracked {
+  static int copies;
+  std::string payload;
+  Tracked() {}
+  explicit Tracked(std::string text) : payload(std::move(text)) {}
+  Tracked(const Tracked& other) : payload(other.payload) { ++copies; }
+  Tracked(Tracked&& other) noexcept : payload(std::move(other.payload)) {}
+  Tracked& operator=(const Tracked& other) {
+    payload = other.payload;
+    ++copies;
+    return *this;
+  }
+  Tracked& operator=(Tracked&& other) noexcept {
+    payload = std::move(other.payload);
+    return *this;
+  }
+};
+
+int Tracked::copies = 0;
+
+}  // namespace
+
+TEST(map, EmplaceMap) {
+  s21::map<int, Tracked> my_map;
+  Tracked::copies = 0;
+  auto result = my_map.emplace(1, "one");
+  EXPECT_TRUE(result.second);
+  EXPECT_EQ((*result.first).second.payload, "one");
+  EXPECT_FALSE(my_map.emplace(1, "uno").second);
+  EXPECT_EQ(my_map.at(1).payload, "one");
+  EXPECT_EQ(Tracked::copies, 0);
+}
+
+TEST(map, TryEmplaceMap) {
+  s21::map<std::string, Tracked> my_map;
+  Tracked::copies = 0;
+  std::string key = "key";
+  Tracked value("value");
+  EXPECT_TRUE(my_map.try_emplace(key, std::move(value)).second);
+  EXPECT_EQ(key, "key");
+  Tracked other("other");
+  EXPECT_FALSE(my_map.try_emplace(std::move(key), std::move(other)).second);
+  EXPECT_EQ(key, "key");
+  EXPECT_EQ(other.payload, "other");
+  EXPECT_EQ(my_map["key"].payload, "value");
+  EXPECT_EQ(Tracked::copies, 0);
+}
+
+TEST(map, MoveInsertMap) {
+  s21::map<int, Tracked> my_map;
+  Tracked::copies = 0;
+  my_map.insert(std::make_pair(1, Tracked("one")));
+  my_map[2] = Tracked("two");
+  EXPECT_EQ(my_map.size(), 2);
+  EXPECT_EQ(my_map[1].payload, "one");
+  EXPECT_EQ(my_map[2].payload, "two");
+  EXPECT_EQ(Tracked::copies, 0);
+}
+
+TEST(map, InsertOrAssignInPlaceMap) {
+  s21::map<int, std::string> my_map = {{1, "a"}, {2, "b"}};
+  std::map<int, std::string> orig_map = {{1, "a"}, {2, "b"}};
+  auto before = my_map.begin();
+  auto my_result = my_map.insert_or_assign(1, "z");
+  auto orig_result = orig_map.insert_or_assign(1, "z");
+  EXPECT_EQ(my_result.second, orig_result.second);
+  EXPECT_TRUE(my_result.first == before);
+  EXPECT_EQ((*before).second, "z");
+  my_result = my_map.insert_or_assign(3, "c");
+  orig_result = orig_map.insert_or_assign(3, "c");
+  EXPECT_EQ(my_result.second, orig_result.second);
+  EXPECT_EQ(my_map.size(), orig_map.size());
+}
+
+TEST(map, OrderStatisticsMap) {
+  s21::map<int, int, std::less<int>, true> m1;
+  std::map<int, int> m2;
+  for (int i = 0; i < 1000; ++i) {
+    int key = (i * 7919) % 1543;
+    m1.insert(key, i);
+    m2.insert({key, i});
+  }
+  for (int i = 0; i < 500; i += 3) {
+    m1.erase(i);
+    m2.erase(i);
+  }
+  size_t index = 0;
+  for (const auto& item : m2) {
+    EXPECT_EQ(m1.nth(index)->first, item.first);
+    EXPECT_EQ(m1.rank(item.first), index);
+    ++index;
+  }
+  EXPECT_TRUE(m1.nth(m2.size()) == m1.end());
+  EXPECT_EQ(m1.count_range(0, 10000), m2.size());
+  EXPECT_EQ(m1.count_range(100, 900),
+            std::distance(m2.lower_bound(100), m2.lower_bound(900)));
+}
+
+TEST(map, CustomCompareMap) {
+  s21::map<int, char, std::greater<int>> m1 = {{1, 'a'}, {3, 'c'}, {2, 'b'}};
+  std::map<int, char, std::greater<int>> m2 = {{1, 'a'}, {3, 'c'}, {2, 'b'}};
+  auto it1 = m1.begin();
+  for (const auto& item : m2) EXPECT_EQ((it1++)->first, item.first);
+  EXPECT_TRUE(m1.key_comp()(3, 2));
+}
+
+TEST(map, TransparentLookupMap) {
+  s21::map<std::string, int, std::less<>> m1;
+  m1["alpha"] = 1;
+  m1["beta"] = 2;
+  std::string_view probe = "beta";
+  EXPECT_TRUE(m1.contains(probe));
+  EXPECT_EQ(m1.find(probe)->second, 2);
+  EXPECT_EQ(m1.count(probe), 1);
+  EXPECT_EQ(m1.count(std::string_view("gamma")), 0);
+  EXPECT_TRUE(m1.find(std::string_view("gamma")) == m1.end());
+}
+
+TEST(map, BoundsMap) {
+  s21::map<int, int> m1;
+  std::map<int, int> m2;
+  for (int i = 0; i < 200; i += 3) {
+    m1.insert(i, i);
+    m2.insert({i, i});
+  }
+  for (int key = -2; key < 205; ++key) {
+    auto lower2 = m2.lower_bound(key);
+    auto upper2 = m2.upper_bound(key);
+    auto lower1 = m1.lower_bound(key);
+    auto upper1 = m1.upper_bound(key);
+    if (lower2 == m2.end()) {
+      EXPECT_TRUE(lower1 == m1.end());
+    } else {
+      EXPECT_EQ(lower1->first, lower2->first);
+    }
+    if (upper2 == m2.end()) {
+      EXPECT_TRUE(upper1 == m1.end());
+    } else {
+      EXPECT_EQ(upper1->first, upper2->first);
+    }
+    auto range = m1.equal_range(key);
+    EXPECT_TRUE(range.first == lower1);
+    EXPECT_TRUE(range.second == upper1);
+  }
+}
+
+TEST(map, HintedInsertMap) {
+  s21::map<int, int> m1;
+  std::map<int, int> m2;
+  for (int i = 0; i < 500; ++i) {
+    m1.insert(m1.end(), {i, i});
+    m2.insert(m2.end(), {i, i});
+  }
+  auto hint = m1.begin();
+  for (int i = -1; i > -500; --i) hint = m1.emplace_hint(hint, i, i);
+  for (int i = -1; i > -500; --i) m2.emplace_hint(m2.begin(), i, i);
+  // A wrong hint still inserts in the right place.
+  EXPECT_EQ(m1.insert(m1.begin(), {1000, 1})->first, 1000);
+  m2.insert(m2.begin(), {1000, 1});
+  EXPECT_EQ(m1.insert(m1.end(), {5, 99})->second, 5);
+  EXPECT_EQ(m1.size(), m2.size());
+  auto it1 = m1.begin();
+  for (const auto& item : m2) EXPECT_EQ((it1++)->first, item.first);
+}
+
+TEST(map, FindHintMap) {
+  s21::map<int, int> m1;
+  for (int i = 0; i < 300; ++i) m1.insert(i * 3, i);
+  auto hint = m1.find(150);
+  for (int key = 0; key < 900; ++key) {
+    EXPECT_TRUE(m1.find(hint, key) == m1.find(key));
+    EXPECT_TRUE(m1.find(m1.end(), key) == m1.find(key));
+  }
+}
+
+TEST(map, NodeHandleMap) {
+  s21::map<int, std::string> m1 = {{1, "one"}, {2, "two"}, {3, "three"}};
+  s21::map<int, std::string> m2;
+  auto node = m1.extract(2);
+  EXPECT_FALSE(node.empty());
+  EXPECT_EQ(node.mapped(), "two");
+  EXPECT_EQ(m1.size(), 2);
+  EXPECT_FALSE(m1.contains(2));
+  node.key() = 20;
+  auto result = m2.insert(std::move(node));
+  EXPECT_TRUE(result.inserted);
+  EXPECT_TRUE(result.node.empty());
+  EXPECT_EQ(result.position->second, "two");
+  EXPECT_TRUE(m1.extract(42).empty());
+
+  m2.insert({1, "uno"});
+  auto clash = m2.insert(m1.extract(m1.begin()));
+  EXPECT_FALSE(clash.inserted);
+  EXPECT_EQ(clash.node.mapped(), "one");
+  EXPECT_EQ(clash.position->second, "uno");
+}
+
+TEST(map, NodeOutlivesSourceMap) {
+  s21::map<int, std::string> m2;
+  {
+    s21::map<int, std::string> m1;
+    for (int i = 0; i < 100; ++i) m1.insert(i, std::to_string(i));
+    for (int i = 0; i < 100; i += 3) m2.insert(m1.extract(i));
+    s21::map<int, std::string> m3;
+    for (int i = 1; i < 100; i += 3) m3.insert(m1.extract(i));
+    m2.merge(m3);
+  }
+  EXPECT_EQ(m2.size(), 67);
+  for (auto& item : m2) EXPECT_EQ(item.second, std::to_string(item.first));
+  for (int i = 0; i < 100; i += 2) m2.erase(i);
+  for (int i = 100; i < 200; ++i) m2.insert(i, std::to_string(i));
+  for (auto& item : m2) EXPECT_EQ(item.second, std::to_string(item.first));
+}
+
+TEST(map, MergeAgainstStd) {
+  s21::map<int, int> m1;
+  s21::map<int, int> m1_other;
+  std::map<int, int> m2;
+  std::map<int, int> m2_other;
+  for (int i = 0; i < 1000; i += 2) {
+    m1.insert(i, i);
+    m2.insert({i, i});
+  }
+  for (int i = 0; i < 1000; i += 3) {
+    m1_other.insert(i, -i);
+    m2_other.insert({i, -i});
+  }
+  m1.merge(m1_other);
+  m2.merge(m2_other);
+  EXPECT_EQ(m1.size(), m2.size());
+  EXPECT_EQ(m1_other.size(), m2_other.size());
+  auto it1 = m1.begin();
+  for (const auto& item : m2) {
+    EXPECT_EQ(it1->first, item.first);
+    EXPECT_EQ((it1++)->second, item.second);
+  }
+  it1 = m1_other.begin();
+  for (const auto& item : m2_other) EXPECT_EQ((it1++)->first, item.first);
+}
+
+TEST(map, SplitAndJoinMap) {
+  s21::map<int, std::string> m1;
+  std::map<int, std::string> m2;
+  for (int i = 0; i < 1000; ++i) {
+    m1.insert(i, std::to_string(i));
+    m2.insert({i, std::to_string(i)});
+  }
+  auto upper = m1.split_at(600);
+  EXPECT_EQ(m1.size(), 600);
+  EXPECT_EQ(upper.size(), 400);
+  EXPECT_EQ(upper.begin()->first, 600);
+  EXPECT_EQ((--m1.end())->first, 599);
+  auto middle = m1.split_at(100);
+  EXPECT_EQ(m1.size(), 100);
+  EXPECT_EQ(middle.size(), 500);
+  s21::map<int, std::string> overlap = {{150, "x"}};
+  EXPECT_THROW(middle.join(overlap), std::invalid_argument);
+  middle.join(upper);
+  middle.join(m1);
+  EXPECT_TRUE(m1.empty());
+  EXPECT_TRUE(upper.empty());
+  EXPECT_EQ(middle.size(), m2.size());
+  auto it = middle.begin();
+  for (const auto& item : m2) {
+    EXPECT_EQ(it->first, item.first);
+    EXPECT_EQ((it++)->second, item.second);
+  }
+  EXPECT_TRUE(middle.split_at(2000).empty());
+}
+
+TEST(map, SplitSizesCountedLater) {
+  s21::map<int, int> lower;
+  for (int i = 0; i < 1000; ++i) lower.insert(i, i);
+  auto upper = lower.split_at(300);
+  upper.insert(5000, 0);
+  upper.erase(upper.begin());
+  lower.insert(-1, 0);
+  auto rest = upper.split_at(800);
+  rest.join(lower);
+  EXPECT_EQ(upper.size(), 499);
+  EXPECT_EQ(rest.size(), 502);
+  upper.insert(-5, 0);
+  EXPECT_EQ(upper.size(), 500);
+  auto top = rest.split_at(900);
+  while (!top.empty()) top.erase(top.begin());
+  EXPECT_EQ(top.size(), 0);
+  EXPECT_EQ(rest.size(), 401);
+}
+
+TEST(map, SetOperationsMap) {
+  s21::map<int, char> m1 = {{1, 'a'}, {2, 'a'}, {3, 'a'}, {5, 'a'}};
+  s21::map<int, char> m2 = {{2, 'b'}, {3, 'b'}, {4, 'b'}, {6, 'b'}};
+  s21::ParallelPolicy policy{2, 0};
+  auto joined = s21::set_union(m1, m2, policy);
+  std::map<int, char> expected = {{1, 'a'}, {2, 'a'}, {3, 'a'},
+                                  {4, 'b'}, {5, 'a'}, {6, 'b'}};
+  EXPECT_EQ(joined.size(), expected.size());
+  auto it = joined.begin();
+  for (const auto& item : expected) {
+    EXPECT_EQ(it->first, item.first);
+    EXPECT_EQ((it++)->second, item.second);
+  }
+  auto common = m2.set_intersection(m1);
+  EXPECT_EQ(common.size(), 2);
+  EXPECT_EQ(common.begin()->second, 'b');
+  EXPECT_EQ(m1.set_difference(m2, policy).size(), 2);
+  EXPECT_EQ(s21::symmetric_difference(m1, m2).size(), 4);
+}
+
+TEST(map, FindManyMap) {
+  s21::map<int, int> m1;
+  std::map<int, int> m2;
+  for (int i = 0; i < 1000; ++i) {
+    m1.insert(i * 71 % 1000 * 2, i);
+    m2.insert({i * 71 % 1000 * 2, i});
+  }
+  std::vector<int> keys;
+  for (int key = -5; key < 2005; key += 3) keys.push_back(key);
+  std::vector<s21::map<int, int>::iterator> found(keys.size());
+  m1.find_many(keys.data(), keys.size(), found.data());
+  std::vector<uint64_t> bits((keys.size() + 63) / 64, ~uint64_t(0));
+  m1.contains_many(keys.data(), keys.size(), bits.data());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    auto expected = m2.find(keys[i]);
+    bool present = bits[i / 64] >> (i % 64) & 1;
+    EXPECT_EQ(present, expected != m2.end());
+    if (expected == m2.end()) {
+      EXPECT_TRUE(found[i] == m1.end());
+    } else {
+      EXPECT_EQ(found[i]->second, expected->second);
+    }
+  }
+  s21::map<int, int> empty;
+  empty.find_many(keys.data(), 3, found.data());
+  EXPECT_TRUE(found[0] == empty.end() && found[2] == empty.end());
+}
+
+TEST(map, SaveAndLoadMap) {
+  std::string path = ::testing::TempDir() + "s21_map_archive";
+  s21::map<int, double> m1;
+  std::map<int, double> m2;
+  for (int i = 0; i < 5000; ++i) {
+    m1.insert(i * 37 % 5000 - 100, i / 4.0);
+    m2.insert({i * 37 % 5000 - 100, i / 4.0});
+  }
+  m1.save(path);
+  s21::map<int, double> loaded{{1, 1.0}};
+  loaded.load(path);
+  EXPECT_EQ(loaded.size(), m2.size());
+  auto it = loaded.begin();
+  for (const auto& [key, value] : m2) {
+    EXPECT_EQ(it->first, key);
+    EXPECT_EQ(it->second, value);
+    ++it;
+  }
+  loaded.insert(-1000, 0.5);
+  EXPECT_EQ(loaded.begin()->first, -1000);
+  s21::map<int, double>().save(path);
+  loaded.load(path);
+  EXPECT_TRUE(loaded.empty());
+  std::remove(path.c_str());
+}
+
+TEST(map, LoadRejectsBadArchives) {
+  std::string path = ::testing::TempDir() + "s21_map_bad_archive";
+  s21::map<int, int> m1{{1, 10}, {2, 20}, {3, 30}};
+  EXPECT_THROW(m1.load(path + ".missing"), std::system_error);
+  m1.save(path);
+  s21::map<int, long> other;
+  EXPECT_THROW(other.load(path), std::runtime_error);
+  s21::set<int> keys;
+  EXPECT_THROW(keys.load(path), std::runtime_error);
+  std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+  file.seekp(-1, std::ios::end);
+  file.put('\x7f');
+  file.close();
+  s21::map<int, int> m2{{5, 50}};
+  EXPECT_THROW(m2.load(path), std::runtime_error);
+  EXPECT_EQ(m2.size(), 1U);
+  EXPECT_EQ(m2.at(5), 50);
+  std::remove(path.c_str());
+}
+
+TEST(map, SmallMapAgainstStd) {
+  s21::map<std::string, std::string, std::less<std::string>, false, 4> m1;
+  std::map<std::string, std::string> m2;
+  for (int i = 0; i < 12; ++i) {
+    std::string key = std::to_string(i * 7 % 12);
+    m1[key] = std::string(32, char('a' + i));
+    m2[key] = std::string(32, char('a' + i));
+    if (i % 3 == 2) {
+      m1.erase(std::to_string(i));
+      m2.erase(std::to_string(i));
+    }
+    auto copy = m1;
+    ASSERT_EQ(copy.size(), m2.size());
+    ASSERT_TRUE(std::equal(m2.begin(), m2.end(), copy.begin(),
+                           [](const auto& a, const auto& b) {
+                             return a.first == b.first && a.second == b.second;
+                           }));
+  }
+  EXPECT_EQ(m1.at("7"), m2.at("7"));
+  EXPECT_TRUE(m1.insert_or_assign("7", "x").second == false);
+  EXPECT_EQ(m1.at("7"), "x");
+  m1.clear();
+  EXPECT_TRUE(m1.emplace("b", "2").second);
+  EXPECT_TRUE(m1.emplace("a", "1").second);
+  EXPECT_FALSE(m1.emplace("b", "3").second);
+  EXPECT_EQ(m1.begin()->first, "a");
+  EXPECT_EQ(m1["b"], "2");
+}
+
+TEST(map, ParallelCopyMap) {
+  s21::map<int, std::string> m1;
+  std::map<int, std::string> m2;
+  for (int i = 0; i < 5000; ++i) {
+    m1[i * 7919 % 5003] = std::to_string(i);
+    m2[i * 7919 % 5003] = std::to_string(i);
+  }
+  s21::map<int, std::string> copy(m1, {4, 100});
+  ASSERT_EQ(copy.size(), m2.size());
+  EXPECT_TRUE(std::equal(m2.begin(), m2.end(), copy.begin(),
+                         [](const auto& a, const auto& b) {
+                           return a.first == b.first && a.second == b.second;
+                         }));
+  m1.clear();
+  copy.erase(copy.begin());
+  copy[-1] = "x";
+  EXPECT_EQ(copy.size(), m2.size());
+  EXPECT_EQ(copy.at(-1), "x");
 }
@@ -0,0 +1,178 @@
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "test_header.h"
+
+namespace {
+
+std::string TempPath(const char* name) {
+  std::string path = ::testing::TempDir() + name;
+  std::remove(path.c_str());
+  return path;
+}
+
+template <typename Map>
+void ExpectEqual(const Map& map, const std::map<int, long>& expected) {
+  EXPECT_EQ(map.size(), expected.size());
+  auto it = map.begin();
+  for (const auto& item : expected) {
+    ASSERT_TRUE(it != map.end());
+    EXPECT_EQ(it->first, item.first);
+    EXPECT_EQ((it++)->second, item.second);
+  }
+  EXPECT_TRUE(it == map.end());
+  auto back = map.end();
+  for (auto item = expected.rbegin(); item != expected.rend(); ++item) {
+    EXPECT_EQ((--back)->first, item->first);
+  }
+}
+
+}  // namespace
+
+TEST(mapped_map_test, against_std) {
+  std::string path = TempPath("s21_mapped_map_std");
+  s21::mapped_map<int, long> m1(path);
+  std::map<int, long> m2;
+  unsigned state = 11;
+  for (int i = 0; i < 30000; ++i) {
+    state = state * 1103515245 + 12345;
+    int key = static_cast<int>((state >> 8) % 4000);
+    if (state >> 30 == 0) {
+      EXPECT_EQ(m1.erase(key), m2.erase(key));
+    } else if (state >> 30 == 1) {
+      m1.insert_or_assign(key, i);
+      m2.insert_or_assign(key, i);
+    } else {
+      EXPECT_EQ(m1.insert(key, i).second, m2.insert({key, i}).second);
+    }
+  }
+  ExpectEqual(m1, m2);
+  for (int key = -1; key < 4001; key += 7) {
+    EXPECT_EQ(m1.contains(key), m2.count(key) == 1);
+    auto lower = m2.lower_bound(key);
+    auto upper = m2.upper_bound(key);
+    EXPECT_EQ(m1.lower_bound(key) == m1.end(), lower == m2.end());
+    if (lower != m2.end()) {
+      EXPECT_EQ(m1.lower_bound(key)->first, lower->first);
+    }
+    if (upper != m2.end()) {
+      EXPECT_EQ(m1.upper_bound(key)->first, upper->first);
+    }
+  }
+  EXPECT_THROW(m1.at(5000), std::out_of_range);
+  std::remove(path.c_str());
+}
+
+TEST(mapped_map_test, reopen) {
+  std::string path = TempPath("s21_mapped_map_reopen");
+  std::map<int, long> expected;
+  {
+    s21::mapped_map<int, long> m1(path);
+    auto first = m1.insert(-1, -1).first;
+    for (int i = 0; i < 1000; ++i) {
+      m1.insert(i * 31 % 1000, i);
+      expected.emplace(i * 31 % 1000, i);
+    }
+    EXPECT_EQ(first->second, -1);
+    m1.erase(first);
+    m1.checkpoint();
+  }
+  s21::mapped_map<int, long> m2(path);
+  ExpectEqual(m2, expected);
+  m2.erase(500);
+  expected.erase(500);
+  m2.insert(2000, 7);
+  expected.emplace(2000, 7);
+  ExpectEqual(m2, expected);
+  m2.clear();
+  EXPECT_TRUE(m2.empty());
+  EXPECT_TRUE(m2.begin() == m2.end());
+  std::remove(path.c_str());
+}
+
+TEST(mapped_map_test, read_only_in_another_process) {
+  std::string path = TempPath("s21_mapped_map_shared");
+  {
+    s21::mapped_map<int, long> writer(path);
+    writer.reserve(5000);
+    for (int i = 0; i < 5000; ++i) writer.insert(i, i * 2L);
+  }
+  pid_t pid = fork();
+  if (pid == 0) {
+    s21::mapped_map<int, long> reader(path, s21::MappedMode::READ_ONLY);
+    bool ok = reader.size() == 5000 && reader.at(1234) == 2468 &&
+              std::prev(reader.end())->first == 4999;
+    _exit(ok ? 0 : 1);
+  }
+  int status = 0;
+  waitpid(pid, &status, 0);
+  EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  s21::mapped_map<int, long> reader(path, s21::MappedMode::READ_ONLY);
+  EXPECT_TRUE(reader.read_only());
+  EXPECT_EQ(reader.at(10), 20);
+  EXPECT_THROW(reader.insert(-1, 0), std::logic_error);
+  EXPECT_THROW(reader.erase(10), std::logic_error);
+  std::remove(path.c_str());
+}
+
+TEST(mapped_map_test, rejects_other_files) {
+  std::string path = TempPath("s21_mapped_map_bad");
+  using Map = s21::mapped_map<int, long>;
+  EXPECT_THROW((Map(path, s21::MappedMode::READ_ONLY)), std::system_error);
+  { Map m1(path); }
+  EXPECT_THROW((s21::mapped_map<int, int>(path)), std::runtime_error);
+  // A writer that dies in the middle of its changes leaves the file dirty.
+  pid_t pid = fork();
+  if (pid == 0) {
+    Map writer(path);
+    writer.insert(1, 1);
+    _exit(0);
+  }
+  waitpid(pid, nullptr, 0);
+  EXPECT_THROW((Map(path, s21::MappedMode::READ_ONLY)), std::runtime_error);
+  std::ofstream(path, std::ios::trunc) << "no map in here, just some text...."
+                                          "................................";
+  EXPECT_THROW(Map{path}, std::runtime_error);
+  std::remove(path.c_str());
+}
+
+TEST(mapped_map_test, one_writer_at_a_time) {
+  std::string path = TempPath("s21_mapped_map_locked");
+  using Map = s21::mapped_map<int, long>;
+  {
+    Map writer(path);
+    writer.insert(1, 1);
+    EXPECT_THROW(Map{path}, std::system_error);
+    EXPECT_THROW((Map(path, s21::MappedMode::READ_ONLY)), std::system_error);
+  }
+  {
+    Map reader(path, s21::MappedMode::READ_ONLY);
+    Map other(path, s21::MappedMode::READ_ONLY);
+    EXPECT_EQ(other.at(1), 1);
+    EXPECT_THROW(Map{path}, std::system_error);
+  }
+  Map writer(path);
+  EXPECT_EQ(writer.size(), 1u);
+  std::remove(path.c_str());
+}
+
+TEST(mapped_map_test, rejects_corrupt_links) {
+  std::string path = TempPath("s21_mapped_map_corrupt");
+  using Map = s21::mapped_map<int, long>;
+  auto overwrite = [&path](size_t offset, uint32_t value) {
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(offset);
+    file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+  };
+  {
+    Map writer(path);
+    for (int i = 0; i < 100; ++i) writer.insert(i, i);
+  }
+  overwrite(offsetof(s21::MappedMapHeader, root), 1000);
+  EXPECT_THROW(Map{path}, std::runtime_error);
+  overwrite(offsetof(s21::MappedMapHeader, root), 1);
+  // The left link of the third node.
+  overwrite(64 + 2 * sizeof(s21::MappedMapNode<int, long>), 70000);
+  EXPECT_THROW((Map(path, s21::MappedMode::READ_ONLY)), std::runtime_error);
+  std::remove(path.c_str());
+}
@@ -410,3 +410,270 @@ TEST(multiset_test, iter7) {
   auto it2 = std::move(it1);
   EXPECT_TRUE(it2 == s1.find(5));
 }
+
+TEST(multiset_test, range_constr) {
+  std::vector<int> items = {5, 1, 3, 3, 8, 1, 1};
+  s21::multiset<int> s1(items.begin(), items.end());
+  std::multiset<int> s2(items.begin(), items.end());
+  EXPECT_EQ(s1.size(), s2.size());
+  auto it1 = s1.begin();
+  for (int key : s2) EXPECT_EQ(*it1++, key);
+  EXPECT_TRUE(it1 == s1.end());
+}
+
+TEST(multiset_test, assign_sorted) {
+  std::vector<int> items = {1, 1, 1, 2, 4, 4, 7, 9, 9, 9, 9};
+  s21::multiset<int> s1 = {100};
+  s1.assign_sorted(items.begin(), items.end());
+  EXPECT_EQ(s1.size(), items.size());
+  EXPECT_EQ(s1.count(1), 3);
+  EXPECT_EQ(s1.count(9), 4);
+  EXPECT_EQ(s1.count(100), 0);
+  auto it1 = s1.begin();
+  for (int key : items) EXPECT_EQ(*it1++, key);
+  EXPECT_TRUE(it1 == s1.end());
+}
+
+TEST(multiset_test, erase_key) {
+  s21::multiset<int> s1 = {1, 3, 3, 3, 5};
+  std::multiset<int> s2 = {1, 3, 3, 3, 5};
+  EXPECT_EQ(s1.erase(3), s2.erase(3));
+  EXPECT_EQ(s1.erase(4), s2.erase(4));
+  EXPECT_EQ(s1.size(), s2.size());
+  auto it1 = s1.begin();
+  for (int key : s2) EXPECT_EQ(*it1++, key);
+}
+
+TEST(multiset_test, emplace) {
+  s21::multiset<std::string> s1;
+  std::multiset<std::string> s2;
+  s1.emplace(2, 'a');
+  s2.emplace(2, 'a');
+  auto result = s1.emplace("aa");
+  s2.emplace("aa");
+  EXPECT_EQ(*result.first, "aa");
+  EXPECT_EQ(s1.count("aa"), s2.count("aa"));
+  EXPECT_EQ(s1.size(), s2.size());
+  ++result.first;
+  EXPECT_TRUE(result.first == s1.end());
+}
+
+TEST(multiset_test, order_statistics) {
+  s21::multiset<int, std::less<int>, true> s1;
+  std::multiset<int> s2;
+  for (int i = 0; i < 1000; ++i) {
+    int key = (i * 7919) % 97;
+    s1.insert(key);
+    s2.insert(key);
+  }
+  for (int i = 0; i < 40; ++i) {
+    s1.erase(s1.find(i));
+    s2.erase(s2.find(i));
+  }
+  s1.erase(50);
+  s2.erase(50);
+  size_t index = 0;
+  for (auto it2 = s2.begin(); it2 != s2.end(); ++it2, ++index) {
+    EXPECT_EQ(*s1.nth(index), *it2);
+  }
+  EXPECT_TRUE(s1.nth(s2.size()) == s1.end());
+  for (int key = 0; key < 100; ++key) {
+    EXPECT_EQ(s1.rank(key), std::distance(s2.begin(), s2.lower_bound(key)));
+  }
+  EXPECT_EQ(s1.count_range(10, 60),
+            std::distance(s2.lower_bound(10), s2.lower_bound(60)));
+  auto it1 = s1.nth(5);
+  auto it3 = s1.begin();
+  for (int i = 0; i < 5; ++i) ++it3;
+  EXPECT_TRUE(it1 == it3);
+}
+
+TEST(multiset_test, custom_compare) {
+  s21::multiset<int, std::greater<int>> s1 = {1, 3, 3, 2, 5, 1};
+  std::multiset<int, std::greater<int>> s2 = {1, 3, 3, 2, 5, 1};
+  auto it1 = s1.begin();
+  for (int key : s2) EXPECT_EQ(*it1++, key);
+  EXPECT_TRUE(it1 == s1.end());
+  EXPECT_EQ(s1.count(3), 2);
+}
+
+TEST(multiset_test, transparent_lookup) {
+  s21::multiset<std::string, std::less<>> s1 = {"a", "b", "b", "c"};
+  std::string_view probe = "b";
+  EXPECT_EQ(s1.count(probe), 2);
+  EXPECT_TRUE(s1.contains(probe));
+  EXPECT_EQ(*s1.find(probe), "b");
+  auto range = s1.equal_range(probe);
+  EXPECT_EQ(*range.first, "b");
+  EXPECT_EQ(s1.count(std::string_view("d")), 0);
+}
+
+TEST(multiset_test, bounds) {
+  s21::multiset<int> s1;
+  std::multiset<int> s2;
+  for (int i = 0; i < 300; ++i) {
+    s1.insert((i * 7) % 101 / 2 * 2);
+    s2.insert((i * 7) % 101 / 2 * 2);
+  }
+  for (int key = -2; key < 105; ++key) {
+    auto lower1 = s1.lower_bound(key);
+    auto upper1 = s1.upper_bound(key);
+    auto lower2 = s2.lower_bound(key);
+    auto upper2 = s2.upper_bound(key);
+    auto it1 = s1.begin();
+    for (auto it2 = s2.begin(); it2 != lower2; ++it2) ++it1;
+    EXPECT_TRUE(it1 == lower1);
+    for (auto it2 = lower2; it2 != upper2; ++it2) ++it1;
+    EXPECT_TRUE(it1 == upper1);
+    auto range = s1.equal_range(key);
+    EXPECT_TRUE(range.first == lower1);
+    EXPECT_TRUE(range.second == upper1);
+  }
+}
+
+TEST(multiset_test, hinted_insert) {
+  s21::multiset<int> s1;
+  std::multiset<int> s2;
+  for (int i = 0; i < 300; ++i) {
+    int key = i / 3;
+    auto it = s1.insert(s1.end(), key);
+    EXPECT_EQ(*it, key);
+    s2.insert(s2.end(), key);
+  }
+  auto hint = s1.find(40);
+  s1.emplace_hint(hint, 40);
+  s2.emplace_hint(s2.end(), 40);
+  EXPECT_EQ(s1.size(), s2.size());
+  EXPECT_EQ(s1.count(40), 4);
+  auto it1 = s1.begin();
+  for (int key : s2) EXPECT_EQ(*it1++, key);
+  EXPECT_TRUE(s1.find(hint, 70) == s1.find(70));
+}
+
+TEST(multiset_test, node_handle) {
+  s21::multiset<int> s1 = {1, 2, 2, 2, 3};
+  s21::multiset<int> s2 = {2};
+  auto node = s1.extract(2);
+  EXPECT_EQ(node.value(), 2);
+  EXPECT_EQ(node.mapped(), 1);
+  EXPECT_EQ(s1.count(2), 2);
+  EXPECT_EQ(s1.size(), 4);
+  auto pos = s2.insert(std::move(node));
+  EXPECT_TRUE(node.empty());
+  EXPECT_EQ(*pos, 2);
+  EXPECT_EQ(s2.count(2), 2);
+  s2.insert(s1.extract(s1.begin()));
+  EXPECT_EQ(s2.size(), 3);
+  EXPECT_EQ(*s2.begin(), 1);
+  EXPECT_FALSE(s1.contains(1));
+}
+
+namespace {
+
+// A key whose copies throw on request.
+struct FragileKey {
+  static int copiesLeft;
+  int value = 0;
+  explicit FragileKey(int v) : value(v) {}
+  FragileKey(const FragileKey& other) : value(other.value) {
+    if (copiesLeft-- == 0) throw std::runtime_error("copy");
+  }
+  FragileKey(FragileKey&& other) noexcept = default;
+  FragileKey& operator=(const FragileKey& other) = default;
+  bool operator<(const FragileKey& other) const { return value < other.value; }
+};
+
+int FragileKey::copiesLeft = -1;
+
+}  // namespace
+
+TEST(multiset_test, failed_extract_keeps_counts) {
+  s21::multiset<FragileKey> s1;
+  for (int i = 0; i < 3; ++i) s1.insert(FragileKey(7));
+  FragileKey::copiesLeft = 0;
+  EXPECT_THROW(s1.extract(s1.begin()), std::runtime_error);
+  FragileKey::copiesLeft = -1;
+  EXPECT_EQ(s1.size(), 3);
+  EXPECT_EQ(s1.count(FragileKey(7)), 3);
+}
+
+TEST(multiset_test, merge_against_std) {
+  s21::multiset<int> s1;
+  s21::multiset<int> s1_1;
+  std::multiset<int> s2;
+  std::multiset<int> s2_1;
+  for (int i = 0; i < 300; ++i) {
+    s1.insert(i % 50);
+    s2.insert(i % 50);
+    s1_1.insert(i % 70 + 20);
+    s2_1.insert(i % 70 + 20);
+  }
+  s1.merge(s1_1);
+  s2.merge(s2_1);
+  EXPECT_EQ(s1.size(), s2.size());
+  EXPECT_EQ(s1_1.size(), s2_1.size());
+  EXPECT_TRUE(s1_1.empty());
+  auto it1 = s1.begin();
+  for (int key : s2) EXPECT_EQ(*it1++, key);
+}
+
+TEST(multiset_test, save_and_load) {
+  std::string path = ::testing::TempDir() + "s21_multiset_archive";
+  s21::multiset<int, std::less<int>, true> s1;
+  std::multiset<int> s2;
+  for (int i = 0; i < 2000; ++i) {
+    s1.insert(i * 7 % 300);
+    s2.insert(i * 7 % 300);
+  }
+  s1.save(path);
+  s21::multiset<int, std::less<int>, true> loaded;
+  loaded.load(path);
+  EXPECT_EQ(loaded.size(), s2.size());
+  EXPECT_EQ(loaded.count(42), s2.count(42));
+  EXPECT_EQ(loaded.rank(150), static_cast<size_t>(std::distance(
+                                  s2.begin(), s2.lower_bound(150))));
+  EXPECT_TRUE(std::equal(s2.begin(), s2.end(), loaded.begin()));
+  s21::map<int, size_t> counts;
+  EXPECT_THROW(counts.load(path), std::runtime_error);
+  std::remove(path.c_str());
+}
+
+// A record with count 0 would make a node that holds no element.
+TEST(multiset_test, load_rejects_zero_count) {
+  std::string path = ::testing::TempDir() + "s21_multiset_zero_count";
+  s21::TreeArchiveWriter out(path,
+                             static_cast<uint32_t>(s21::ArchiveKind::MULTISET),
+                             sizeof(int), sizeof(size_t), 2);
+  out.Append(1, size_t{2});
+  out.Append(2, size_t{0});
+  out.Commit();
+  s21::multiset<int> loaded{5, 5};
+  EXPECT_THROW(loaded.load(path), std::runtime_error);
+  EXPECT_EQ(loaded.size(), 2U);
+  EXPECT_EQ(loaded.count(5), 2U);
+  std::remove(path.c_str());
+}
+
+TEST(multiset_test, small_multiset_against_std) {
+  s21::multiset<int, std::less<int>, true, 4> s1;
+  std::multiset<int> s2;
+  for (int i = 0; i < 40; ++i) {
+    int key = i * 5 % 7;
+    s1.insert(key);
+    s2.insert(key);
+    if (i % 4 == 3) {
+      s1.erase(s1.find(key));
+      s2.erase(s2.find(key));
+    }
+    ASSERT_EQ(s1.size(), s2.size());
+    ASSERT_TRUE(std::equal(s2.begin(), s2.end(), s1.begin()));
+    ASSERT_EQ(s1.count_range(2, 5),
+              size_t(std::distance(s2.lower_bound(2), s2.lower_bound(5))));
+  }
+  EXPECT_EQ(s1.erase(3), s2.erase(3));
+  s1.clear();
+  s1.insert(1);
+  s1.insert(1);
+  EXPECT_EQ(s1.count(1), 2U);
+  EXPECT_EQ(*s1.nth(1), 1);
+}
@@ -0,0 +1,158 @@
+#include "test_header.h"
+
+TEST(node_pool_test, recycle) {
+  s21::NodePool<s21::RBTreeNode<int, int>> pool;
+  void* first = pool.Allocate();
+  void* second = pool.Allocate();
+  EXPECT_NE(first, second);
+  pool.Deallocate(first);
+  EXPECT_EQ(pool.Allocate(), first);
+  EXPECT_EQ(pool.capacity(),
+            (s21::NodePool<s21::RBTreeNode<int, int>>::kMinSlabSize));
+}
+
+TEST(node_pool_test, reserve) {
+  s21::NodePool<s21::RBTreeNode<int, int>> pool;
+  pool.Reserve(1000);
+  EXPECT_EQ(pool.capacity(), 1000);
+  for (int i = 0; i < 1000; ++i) pool.Allocate();
+  EXPECT_EQ(pool.capacity(), 1000);
+  pool.Allocate();
+  EXPECT_GT(pool.capacity(), 1000);
+}
+
+TEST(node_pool_test, release) {
+  s21::NodePool<s21::RBTreeNode<int, int>> pool;
+  for (int i = 0; i < 100; ++i) pool.Allocate();
+  EXPECT_GT(pool.bytes(), 0);
+  pool.Release();
+  EXPECT_EQ(pool.capacity(), 0);
+  EXPECT_EQ(pool.bytes(), 0);
+}
+
+TEST(node_pool_test, move) {
+  s21::NodePool<s21::RBTreeNode<int, int>> pool;
+  pool.Allocate();
+  auto capacity = pool.capacity();
+  s21::NodePool<s21::RBTreeNode<int, int>> other(std::move(pool));
+  EXPECT_EQ(pool.capacity(), 0);
+  EXPECT_EQ(other.capacity(), capacity);
+}
+
+TEST(node_pool_test, adopted_slabs_outlive_owner) {
+  using Pool = s21::NodePool<s21::RBTreeNode<int, int>>;
+  Pool pool;
+  Pool other;
+  int* value = new (pool.Allocate()) int(42);
+  other.Adopt(pool);
+  pool.Release();
+  EXPECT_EQ(*value, 42);
+  EXPECT_GT(other.bytes(), 0);
+  other.Deallocate(value);
+  EXPECT_EQ(other.bytes(), 0);
+  EXPECT_EQ(other.capacity(), 0);
+}
+
+TEST(node_pool_test, adopted_slots_go_back_to_owner) {
+  using Pool = s21::NodePool<s21::RBTreeNode<int, int>>;
+  Pool pool;
+  Pool other;
+  std::vector<void*> slots;
+  for (size_t i = 0; i < Pool::kMinSlabSize; ++i) {
+    slots.push_back(pool.Allocate());
+  }
+  other.Adopt(pool);
+  for (void* slot : slots) other.Deallocate(slot);
+  EXPECT_EQ(other.capacity(), 0);
+  pool.Allocate();
+  EXPECT_EQ(pool.capacity(), Pool::kMinSlabSize);
+}
+
+TEST(node_pool_test, small_trees_take_small_slabs) {
+  using Node = s21::RBTreeNode<int, int>;
+  s21::NodePool<Node> pool;
+  pool.Allocate();
+  pool.Allocate();
+  EXPECT_LE(pool.bytes(), 2 * sizeof(Node) + 2 * sizeof(void*));
+}
+
+// Slabs the owner added after the first adoption are found by the next one.
+TEST(node_pool_test, slots_of_later_slabs_go_back_to_owner) {
+  using Pool = s21::NodePool<s21::RBTreeNode<int, int>>;
+  Pool pool;
+  Pool other;
+  pool.Allocate();
+  other.Adopt(pool);
+  std::vector<void*> slots;
+  for (int i = 0; i < 100; ++i) slots.push_back(pool.Allocate());
+  auto capacity = pool.capacity();
+  other.Adopt(pool);
+  Pool third;
+  third.Adopt(other);
+  for (void* slot : slots) third.Deallocate(slot);
+  EXPECT_EQ(third.capacity(), 0);
+  for (int i = 0; i < 100; ++i) pool.Allocate();
+  EXPECT_EQ(pool.capacity(), capacity);
+}
+
+// A time partition kept by cutting off its oldest part over and over, while
+// elements are merged in and extracted, must not hold on to dead slabs.
+TEST(node_pool_test, bytes_bounded_across_split_merge_extract) {
+  s21::map<int, int> window;
+  int next = 0;
+  for (; next < 10000; ++next) window.insert(next, next);
+  size_t bound = 0;
+  for (int round = 0; round < 200; ++round) {
+    s21::map<int, int> incoming;
+    for (int i = 0; i < 50; ++i, ++next) incoming.insert(next, next);
+    window.merge(incoming);
+    for (int i = 0; i < 50; ++i, ++next) {
+      auto node = incoming.extract(incoming.insert(next, next).first);
+      window.insert(std::move(node));
+    }
+    for (int i = 0; i < 20; ++i) window.extract(next - 10100 + i);
+    window = window.split_at(next - 10000);
+    EXPECT_EQ(window.size(), 10000U);
+    // By then the elements of the first window are all gone.
+    if (round == 110) bound = window.stats().bytes * 5 / 4;
+    if (round > 110) {
+      EXPECT_LE(window.stats().bytes, bound);
+    }
+  }
+}
+
+TEST(node_pool_test, map_insert_erase) {
+  s21::map<int, std::string> my_map;
+  std::map<int, std::string> orig_map;
+  for (int i = 0; i < 5000; ++i) {
+    int key = (i * 7919) % 3001;
+    my_map.insert(key, std::to_string(i));
+    orig_map.insert(std::make_pair(key, std::to_string(i)));
+    if (i % 3 == 0) {
+      my_map.erase(my_map.begin());
+      orig_map.erase(orig_map.begin());
+    }
+  }
+  EXPECT_EQ(my_map.size(), orig_map.size());
+  auto my_it = my_map.begin();
+  auto orig_it = orig_map.begin();
+  for (; my_it != my_map.end(); ++my_it, ++orig_it) {
+    EXPECT_EQ((*my_it).first, (*orig_it).first);
+    EXPECT_EQ((*my_it).second, (*orig_it).second);
+  }
+  my_map.clear();
+  EXPECT_TRUE(my_map.empty());
+  my_map.insert(1, "one");
+  EXPECT_EQ(my_map.at(1), "one");
+}
+
+TEST(node_pool_test, heap_allocator) {
+  s21::RBTree<int, int, std::less<int>, s21::Ranking::NONE, s21::NodeHeap>
+      tree;
+  for (int i = 0; i < 100; ++i) tree.Insert(i, i);
+  tree.Delete(50);
+  EXPECT_EQ(tree.size(), 99);
+  EXPECT_EQ(tree.find(50), tree.end());
+  tree.clear();
+  EXPECT_TRUE(tree.empty());
+}
@@ -0,0 +1,123 @@
+#include <atomic>
+#include <thread>
+
+#include "test_header.h"
+
+namespace {
+
+// Counts the values alive, which shows how many nodes a snapshot copies and
+// whether the last one frees them all.
+struct Counted {
+  static std::atomic<int> live;
+  explicit Counted(int v) : value(v) { ++live; }
+  Counted(const Counted& other) : value(other.value) { ++live; }
+  ~Counted() { --live; }
+  int value;
+};
+
+std::atomic<int> Counted::live{0};
+
+template <typename Map>
+void ExpectEqual(const Map& map, const std::map<int, int>& expected) {
+  EXPECT_EQ(map.size(), expected.size());
+  auto it = map.begin();
+  for (const auto& item : expected) {
+    ASSERT_TRUE(it != map.end());
+    EXPECT_EQ(it->first, item.first);
+    EXPECT_EQ((it++)->second, item.second);
+  }
+  EXPECT_TRUE(it == map.end());
+}
+
+}  // namespace
+
+TEST(persistent_map_test, against_std) {
+  s21::persistent_map<int, int> m1;
+  std::map<int, int> m2;
+  unsigned state = 7;
+  for (int i = 0; i < 20000; ++i) {
+    state = state * 1103515245 + 12345;
+    int key = static_cast<int>((state >> 8) % 3000);
+    if (i % 3 == 0) {
+      EXPECT_EQ(m1.erase(key), m2.erase(key));
+    } else if (i % 3 == 1) {
+      EXPECT_EQ(m1.insert(key, i).second, m2.insert({key, i}).second);
+    } else {
+      EXPECT_EQ(m1.insert_or_assign(key, i).second,
+                m2.insert_or_assign(key, i).second);
+    }
+  }
+  ExpectEqual(m1, m2);
+  for (int key = -1; key < 3001; ++key) {
+    auto found = m2.find(key);
+    EXPECT_EQ(m1.contains(key), found != m2.end());
+    if (found != m2.end()) {
+      EXPECT_EQ(m1.at(key), found->second);
+      auto it = m1.find(key);
+      for (int step = 0; step < 3 && found != m2.end(); ++step) {
+        EXPECT_EQ((it++)->first, (found++)->first);
+      }
+    } else {
+      EXPECT_TRUE(m1.find(key) == m1.end());
+      EXPECT_THROW(m1.at(key), std::out_of_range);
+    }
+  }
+}
+
+TEST(persistent_map_test, snapshots_are_isolated) {
+  s21::persistent_map<int, int> m1 = {{1, 10}, {2, 20}, {3, 30}};
+  s21::persistent_map<int, int> snapshot = m1;
+  m1.erase(2);
+  m1.insert_or_assign(3, 33);
+  m1.insert(4, 40);
+  ExpectEqual(snapshot, {{1, 10}, {2, 20}, {3, 30}});
+  ExpectEqual(m1, {{1, 10}, {3, 33}, {4, 40}});
+  snapshot = m1;
+  m1.clear();
+  EXPECT_TRUE(m1.empty());
+  ExpectEqual(snapshot, {{1, 10}, {3, 33}, {4, 40}});
+  s21::persistent_map<int, int> moved(std::move(snapshot));
+  EXPECT_TRUE(snapshot.empty());
+  EXPECT_EQ(moved.size(), 3);
+}
+
+TEST(persistent_map_test, copy_shares_nodes) {
+  {
+    s21::persistent_map<int, Counted> m1;
+    for (int i = 0; i < 1024; ++i) m1.insert(i, Counted(i));
+    EXPECT_EQ(Counted::live, 1024);
+    s21::persistent_map<int, Counted> snapshot(m1);
+    EXPECT_EQ(Counted::live, 1024);
+    // A write copies one path, at most twice the black height long.
+    m1.insert_or_assign(500, Counted(-1));
+    EXPECT_GT(Counted::live, 1024);
+    EXPECT_LE(Counted::live, 1024 + 2 * 11 + 4);
+    EXPECT_EQ(snapshot.at(500).value, 500);
+    EXPECT_EQ(m1.at(500).value, -1);
+    for (int i = 0; i < 1024; i += 2) m1.erase(i);
+    EXPECT_EQ(snapshot.size(), 1024);
+    EXPECT_EQ(m1.size(), 512);
+  }
+  EXPECT_EQ(Counted::live, 0);
+}
+
+TEST(persistent_map_test, snapshots_across_threads) {
+  {
+    s21::persistent_map<int, Counted> m1;
+    for (int i = 0; i < 2000; ++i) m1.insert(i, Counted(i));
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+      readers.emplace_back([snapshot = m1, t]() mutable {
+        long sum = 0;
+        for (const auto& item : snapshot) sum += item.second.value;
+        EXPECT_EQ(sum, 1999 * 2000 / 2);
+        for (int i = t; i < 2000; i += 4) snapshot.erase(i);
+        EXPECT_EQ(snapshot.size(), 1500);
+      });
+    }
+    for (int i = 0; i < 2000; i += 3) m1.erase(i);
+    for (std::thread& reader : readers) reader.join();
+    EXPECT_EQ(m1.size(), 1333);
+  }
+  EXPECT_EQ(Counted::live, 0);
+}
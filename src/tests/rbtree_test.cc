@@ -0,0 +1,762 @@
+#include "test_header.h"
+
+namespace {
+
+using IntTree = s21::RBTree<int, int>;
+
+// Returns the black height of the subtree, or -1 if a red-black property or
+// a parent link is broken.
+int BlackHeight(const s21::RBTreeNodeBase* node) {
+  if (node == nullptr) return 1;
+  for (const s21::RBTreeNodeBase* child : {node->left, node->right}) {
+    if (child == nullptr) continue;
+    if (child->parent() != node) return -1;
+    if (node->color() == s21::Color::RED && child->color() == s21::Color::RED)
+      return -1;
+  }
+  int left = BlackHeight(node->left);
+  int right = BlackHeight(node->right);
+  if (left < 0 || left != right) return -1;
+  return left + (node->color() == s21::Color::BLACK ? 1 : 0);
+}
+
+template <typename Tree>
+bool IsValidTree(Tree& tree) {
+  if (tree.empty()) return tree.begin() == tree.end();
+  const s21::RBTreeNodeBase* root = &*tree.begin();
+  while (!root->parent()->IsHeader()) root = root->parent();
+  const s21::RBTreeNodeBase* header = root->parent();
+  return root->color() == s21::Color::BLACK && BlackHeight(root) > 0 &&
+         header->left == s21::RBTreeNodeBase::Minimum(
+                             const_cast<s21::RBTreeNodeBase*>(root)) &&
+         header->right == s21::RBTreeNodeBase::Maximum(
+                              const_cast<s21::RBTreeNodeBase*>(root));
+}
+
+template <typename Tree>
+size_t CheckWeights(const s21::RBTreeNodeBase* node, bool& ok) {
+  if (node == nullptr) return 0;
+  size_t weight = CheckWeights<Tree>(node->left, ok) + 1 +
+                  CheckWeights<Tree>(node->right, ok);
+  if (static_cast<const typename Tree::Node*>(node)->weight != weight)
+    ok = false;
+  return weight;
+}
+
+}  // namespace
+
+TEST(rbtree_test, iterator_size) {
+  EXPECT_EQ(sizeof(IntTree::iterator), sizeof(void*));
+}
+
+TEST(rbtree_test, compact_nodes) {
+  EXPECT_EQ(sizeof(s21::RBTreeNodeBase), 3 * sizeof(void*));
+  EXPECT_EQ(sizeof(s21::RBTreeNode<std::string, s21::NoValue>),
+            3 * sizeof(void*) + sizeof(std::string));
+  EXPECT_EQ(sizeof(s21::RBTreeNode<int64_t, int64_t>), 5 * sizeof(void*));
+}
+
+TEST(rbtree_test, color_packed_into_parent) {
+  s21::RBTreeNodeBase parent;
+  s21::RBTreeNodeBase node;
+  EXPECT_EQ(node.color(), s21::Color::RED);
+  node.SetColor(s21::Color::BLACK);
+  node.SetParent(&parent);
+  EXPECT_EQ(node.parent(), &parent);
+  EXPECT_EQ(node.color(), s21::Color::BLACK);
+  node.SetColor(s21::Color::RED);
+  EXPECT_EQ(node.parent(), &parent);
+  node.SetParent(nullptr);
+  EXPECT_EQ(node.color(), s21::Color::RED);
+}
+
+TEST(rbtree_test, key_only_tree) {
+  s21::RBTree<std::string, s21::NoValue> tree;
+  tree.InsertUnique(std::string("b"), s21::NoValue());
+  tree.EmplaceUnique("a");
+  tree.TryEmplace(std::string("c"));
+  EXPECT_FALSE(tree.EmplaceUnique(std::string("c")).second);
+  s21::RBTree<std::string, s21::NoValue> copy(tree);
+  std::string expected = "a";
+  for (auto it = copy.begin(); it != copy.end(); ++it, ++expected[0])
+    EXPECT_EQ(it->data.first, expected);
+  EXPECT_EQ(copy.size(), 3);
+}
+
+TEST(rbtree_test, empty_comparator_takes_no_space) {
+  size_t counters = 0;
+#ifdef S21_RBTREE_STATS
+  counters = sizeof(s21::RBTreeCounters);
+#endif
+  // The size and the count taken while it is unknown.
+  EXPECT_EQ(sizeof(IntTree), sizeof(s21::RBTreeNodeBase) + 2 * sizeof(size_t) +
+                                 sizeof(IntTree::allocator_type) + counters);
+  EXPECT_EQ(sizeof(s21::RBTree<int, int, std::greater<int>>), sizeof(IntTree));
+}
+
+TEST(rbtree_test, custom_comparator) {
+  s21::RBTree<int, int, std::greater<int>> tree;
+  for (int i = 0; i < 100; ++i) tree.Insert(i, i);
+  EXPECT_TRUE(IsValidTree(tree));
+  int expected = 99;
+  for (auto it = tree.begin(); it != tree.end(); ++it, --expected)
+    EXPECT_EQ(it->data.first, expected);
+  EXPECT_EQ(tree.find(42)->data.second, 42);
+  EXPECT_EQ(tree.EraseUnique(42), 1);
+  EXPECT_TRUE(tree.find(42) == tree.end());
+}
+
+TEST(rbtree_test, empty_begin_end) {
+  IntTree tree;
+  EXPECT_TRUE(tree.begin() == tree.end());
+  tree.Insert(1, 1);
+  tree.Delete(1);
+  EXPECT_TRUE(tree.begin() == tree.end());
+  EXPECT_TRUE(IsValidTree(tree));
+}
+
+TEST(rbtree_test, begin_end_cached) {
+  IntTree tree;
+  for (int i = 10; i > 0; --i) tree.Insert(i, i);
+  EXPECT_EQ(tree.begin()->data.first, 1);
+  EXPECT_EQ((--tree.end())->data.first, 10);
+  tree.Insert(0, 0);
+  tree.Insert(11, 11);
+  EXPECT_EQ(tree.begin()->data.first, 0);
+  EXPECT_EQ((--tree.end())->data.first, 11);
+  tree.Delete(0);
+  tree.Delete(11);
+  EXPECT_EQ(tree.begin()->data.first, 1);
+  EXPECT_EQ((--tree.end())->data.first, 10);
+  auto last = tree.end();
+  --last;
+  ++last;
+  EXPECT_TRUE(last == tree.end());
+}
+
+TEST(rbtree_test, random_against_std) {
+  IntTree tree;
+  std::set<int> orig;
+  unsigned state = 12345;
+  for (int i = 0; i < 20000; ++i) {
+    state = state * 1103515245 + 12345;
+    int key = static_cast<int>((state >> 8) % 2000);
+    if (orig.count(key)) {
+      tree.Delete(key);
+      orig.erase(key);
+    } else {
+      tree.Insert(key, key);
+      orig.insert(key);
+    }
+  }
+  EXPECT_TRUE(IsValidTree(tree));
+  EXPECT_EQ(tree.size(), orig.size());
+  auto it = tree.begin();
+  for (int key : orig) EXPECT_EQ((it++)->data.first, key);
+  EXPECT_TRUE(it == tree.end());
+  auto rit = tree.end();
+  for (auto orig_it = orig.rbegin(); orig_it != orig.rend(); ++orig_it)
+    EXPECT_EQ((--rit)->data.first, *orig_it);
+}
+
+TEST(rbtree_test, copy_and_move) {
+  IntTree tree;
+  for (int i = 0; i < 100; ++i) tree.Insert(i, i * 2);
+  IntTree copy(tree);
+  EXPECT_TRUE(IsValidTree(copy));
+  EXPECT_EQ(copy.size(), 100);
+  EXPECT_EQ((--copy.end())->data.second, 198);
+  IntTree moved(std::move(copy));
+  EXPECT_TRUE(copy.empty());
+  EXPECT_TRUE(copy.begin() == copy.end());
+  EXPECT_EQ(moved.begin()->data.first, 0);
+  copy = moved;
+  moved = std::move(tree);
+  EXPECT_EQ(copy.size(), 100);
+  EXPECT_EQ(moved.size(), 100);
+  EXPECT_TRUE(IsValidTree(copy));
+}
+
+TEST(rbtree_test, assign_sorted_shape) {
+  for (int count = 0; count < 300; ++count) {
+    IntTree tree;
+    int next = 0;
+    tree.AssignSorted(count, [&next]() {
+      ++next;
+      return std::make_pair(next * 10, next);
+    });
+    ASSERT_TRUE(IsValidTree(tree)) << count;
+    ASSERT_EQ(tree.size(), static_cast<size_t>(count));
+    int expected = 10;
+    for (auto it = tree.begin(); it != tree.end(); ++it, expected += 10)
+      ASSERT_EQ(it->data.first, expected);
+  }
+}
+
+TEST(rbtree_test, assign_sorted_then_modify) {
+  IntTree tree;
+  int next = 0;
+  tree.AssignSorted(1000, [&next]() {
+    next += 2;
+    return std::make_pair(next, next);
+  });
+  for (int i = 1; i < 2000; i += 2) tree.Insert(i, i);
+  for (int i = 2; i <= 2000; i += 4) tree.Delete(i);
+  EXPECT_TRUE(IsValidTree(tree));
+  EXPECT_EQ(tree.size(), 1500);
+}
+
+TEST(rbtree_test, insert_unique) {
+  IntTree tree;
+  auto first = tree.InsertUnique(5, 50);
+  EXPECT_TRUE(first.second);
+  auto second = tree.InsertUnique(5, 60);
+  EXPECT_FALSE(second.second);
+  EXPECT_TRUE(first.first == second.first);
+  EXPECT_EQ(second.first->data.second, 50);
+  EXPECT_THROW(tree.Insert(5, 70), std::logic_error);
+  EXPECT_EQ(tree.size(), 1);
+}
+
+TEST(rbtree_test, erase_unique) {
+  IntTree tree;
+  for (int i = 0; i < 10; ++i) tree.Insert(i, i);
+  EXPECT_EQ(tree.EraseUnique(4), 1);
+  EXPECT_EQ(tree.EraseUnique(4), 0);
+  EXPECT_THROW(tree.Delete(4), std::invalid_argument);
+  EXPECT_EQ(tree.size(), 9);
+  EXPECT_TRUE(IsValidTree(tree));
+}
+
+TEST(rbtree_test, ranked_random_against_std) {
+  using RankedTree = s21::RBTree<int, int, std::less<int>, s21::Ranking::NODES>;
+  RankedTree tree;
+  std::set<int> orig;
+  unsigned state = 777;
+  for (int i = 0; i < 20000; ++i) {
+    state = state * 1103515245 + 12345;
+    int key = static_cast<int>((state >> 8) % 2000);
+    if (orig.count(key)) {
+      tree.Delete(key);
+      orig.erase(key);
+    } else {
+      tree.Insert(key, key);
+      orig.insert(key);
+    }
+  }
+  ASSERT_TRUE(IsValidTree(tree));
+  bool ok = true;
+  const s21::RBTreeNodeBase* root = &*tree.begin();
+  while (!root->parent()->IsHeader()) root = root->parent();
+  EXPECT_EQ(CheckWeights<RankedTree>(root, ok), orig.size());
+  EXPECT_TRUE(ok);
+  size_t index = 0;
+  for (int key : orig) {
+    auto [it, offset] = tree.Select(index);
+    EXPECT_EQ(it->data.first, key);
+    EXPECT_EQ(offset, 0);
+    EXPECT_EQ(tree.Rank(key), index);
+    ++index;
+  }
+  EXPECT_TRUE(tree.Select(orig.size()).first == tree.end());
+}
+
+TEST(rbtree_test, ranked_copy_and_sorted_build) {
+  using RankedTree = s21::RBTree<int, int, std::less<int>, s21::Ranking::NODES>;
+  RankedTree tree;
+  int next = 0;
+  tree.AssignSorted(500, [&next]() {
+    ++next;
+    return std::make_pair(next, next);
+  });
+  RankedTree copy(tree);
+  for (int i = 0; i < 500; ++i) {
+    EXPECT_EQ(tree.Select(i).first->data.first, i + 1);
+    EXPECT_EQ(copy.Select(i).first->data.first, i + 1);
+  }
+  EXPECT_EQ(copy.TotalWeight(), 500);
+}
+
+TEST(rbtree_test, payload_ranking) {
+  s21::RBTree<int, size_t, std::less<int>, s21::Ranking::PAYLOAD> tree;
+  for (int i = 0; i < 10; ++i) tree.Insert(i, i + 1);
+  EXPECT_EQ(tree.TotalWeight(), 55);
+  EXPECT_EQ(tree.Rank(3), 6);
+  auto [it, offset] = tree.Select(7);
+  EXPECT_EQ(it->data.first, 3);
+  EXPECT_EQ(offset, 1);
+  it->data.second = 100;
+  tree.UpdateWeight(it);
+  EXPECT_EQ(tree.TotalWeight(), 151);
+  EXPECT_EQ(tree.Rank(4), 106);
+}
+
+TEST(rbtree_test, find_hint_every_pair) {
+  IntTree tree;
+  for (int i = 0; i < 64; ++i) tree.Insert(i * 2, i);
+  for (auto hint = tree.begin();; ++hint) {
+    for (int key = -1; key < 130; ++key) {
+      auto found = tree.FindHint(hint, key);
+      ASSERT_TRUE(found == tree.find(key)) << key;
+    }
+    if (hint == tree.end()) break;
+  }
+}
+
+TEST(rbtree_test, insert_hint_any_position) {
+  for (int hintKey = -1; hintKey <= 40; ++hintKey) {
+    IntTree tree;
+    for (int i = 0; i < 40; i += 2) tree.Insert(i, i);
+    for (int key = 0; key < 40; ++key) {
+      auto hint = hintKey < 0 ? tree.end() : tree.LowerBound(hintKey);
+      auto result = tree.TryEmplaceHint(hint, key, key);
+      EXPECT_EQ(result.second, key % 2 == 1);
+      EXPECT_EQ(result.first->data.first, key);
+    }
+    ASSERT_TRUE(IsValidTree(tree));
+    EXPECT_EQ(tree.size(), 40);
+    int expected = 0;
+    for (auto it = tree.begin(); it != tree.end(); ++it)
+      EXPECT_EQ(it->data.first, expected++);
+  }
+}
+
+TEST(rbtree_test, merge_relinks_nodes) {
+  using RankedTree = s21::RBTree<int, int, std::less<int>, s21::Ranking::NODES>;
+  RankedTree tree;
+  RankedTree other;
+  for (int i = 0; i < 1000; i += 2) tree.Insert(i, i);
+  for (int i = 0; i < 1000; i += 3) other.Insert(i, -i);
+  std::vector<const s21::RBTreeNodeBase*> moved;
+  for (auto it = other.begin(); it != other.end(); ++it) {
+    if (it->data.first % 2 != 0) moved.push_back(&*it);
+  }
+  tree.Merge(other, [](auto, auto) { return false; });
+  ASSERT_TRUE(IsValidTree(tree));
+  ASSERT_TRUE(IsValidTree(other));
+  EXPECT_EQ(tree.size(), 500 + moved.size());
+  EXPECT_EQ(other.size(), 334 - moved.size());
+  for (const s21::RBTreeNodeBase* node : moved) {
+    int key = static_cast<const RankedTree::Node*>(node)->data.first;
+    EXPECT_EQ(&*tree.find(key), node);
+  }
+  bool ok = true;
+  const s21::RBTreeNodeBase* root = &*tree.begin();
+  while (!root->parent()->IsHeader()) root = root->parent();
+  EXPECT_EQ(CheckWeights<RankedTree>(root, ok), tree.size());
+  EXPECT_TRUE(ok);
+  EXPECT_EQ(tree.Rank(501), 251 + 83);
+}
+
+TEST(rbtree_test, extract_and_insert_node) {
+  IntTree tree;
+  IntTree other;
+  for (int i = 0; i < 200; ++i) tree.Insert(i, i);
+  for (int i = 0; i < 200; i += 2) {
+    auto node = tree.Extract(tree.find(i));
+    EXPECT_EQ(node.key(), i);
+    EXPECT_TRUE(other.InsertNode(node).second);
+    EXPECT_TRUE(node.empty());
+  }
+  EXPECT_TRUE(IsValidTree(tree));
+  EXPECT_TRUE(IsValidTree(other));
+  EXPECT_EQ(tree.size(), 100);
+  EXPECT_EQ(other.size(), 100);
+  tree.clear();
+  for (int i = 0; i < 200; i += 2) EXPECT_EQ(other.find(i)->data.second, i);
+}
+
+TEST(rbtree_test, split_at_every_key) {
+  using RankedTree = s21::RBTree<int, int, std::less<int>, s21::Ranking::NODES>;
+  for (int count = 0; count < 70; ++count) {
+    for (int cut = -1; cut <= count; ++cut) {
+      RankedTree tree;
+      IntTree plain;
+      for (int i = 0; i < count; ++i) {
+        tree.Insert(i * 71 % count, i);
+        plain.Insert(i * 71 % count, i);
+      }
+      RankedTree upper;
+      IntTree plainUpper;
+      tree.Split(cut, upper);
+      plain.Split(cut, plainUpper);
+      ASSERT_TRUE(IsValidTree(tree)) << count << " " << cut;
+      ASSERT_TRUE(IsValidTree(upper)) << count << " " << cut;
+      ASSERT_TRUE(IsValidTree(plain));
+      ASSERT_TRUE(IsValidTree(plainUpper));
+      size_t below = static_cast<size_t>(std::clamp(cut, 0, count));
+      EXPECT_EQ(tree.size(), below);
+      EXPECT_EQ(upper.size(), count - below);
+      EXPECT_EQ(plain.size(), below);
+      EXPECT_EQ(plainUpper.size(), count - below);
+      EXPECT_EQ(tree.TotalWeight(), below);
+      EXPECT_EQ(upper.TotalWeight(), count - below);
+      int expected = 0;
+      for (auto it = tree.begin(); it != tree.end(); ++it)
+        ASSERT_EQ(it->data.first, expected++);
+      for (auto it = upper.begin(); it != upper.end(); ++it)
+        ASSERT_EQ(it->data.first, expected++);
+      EXPECT_EQ(expected, count);
+    }
+  }
+}
+
+TEST(rbtree_test, join_any_sizes) {
+  using RankedTree = s21::RBTree<int, int, std::less<int>, s21::Ranking::NODES>;
+  for (int lower = 0; lower < 40; ++lower) {
+    for (int upper = 0; upper < 40; ++upper) {
+      RankedTree tree;
+      RankedTree other;
+      for (int i = 0; i < lower; ++i) tree.Insert(i, i);
+      for (int i = 0; i < upper; ++i) other.Insert(lower + i, i);
+      // Alternate which side is joined onto which.
+      RankedTree& target = (lower + upper) % 2 ? tree : other;
+      RankedTree& source = (lower + upper) % 2 ? other : tree;
+      target.Join(source);
+      ASSERT_TRUE(IsValidTree(target)) << lower << " " << upper;
+      EXPECT_TRUE(source.empty());
+      EXPECT_TRUE(source.begin() == source.end());
+      ASSERT_EQ(target.size(), static_cast<size_t>(lower + upper));
+      EXPECT_EQ(target.TotalWeight(), target.size());
+      int expected = 0;
+      for (auto it = target.begin(); it != target.end(); ++it)
+        ASSERT_EQ(it->data.first, expected++);
+      for (int i = 0; i < lower + upper; ++i)
+        ASSERT_EQ(target.Select(i).first->data.first, i);
+    }
+  }
+}
+
+TEST(rbtree_test, join_overlapping_throws) {
+  IntTree tree;
+  IntTree other;
+  for (int i = 0; i < 10; ++i) tree.Insert(i * 2, i);
+  other.Insert(5, 5);
+  EXPECT_THROW(tree.Join(other), std::invalid_argument);
+  EXPECT_EQ(tree.size(), 10);
+  EXPECT_EQ(other.size(), 1);
+  EXPECT_TRUE(IsValidTree(tree));
+}
+
+// A join that throws leaves both trees as they were: inline trees are not
+// promoted, and no arena of the other tree is adopted.
+TEST(rbtree_test, join_overlapping_changes_nothing) {
+  using SmallTree = s21::RBTree<int, int, std::less<int>, s21::Ranking::NONE,
+                                s21::NodePool, 8>;
+  SmallTree small;
+  SmallTree small_other;
+  small.InsertUnique(1, 1);
+  small.InsertUnique(3, 3);
+  small_other.InsertUnique(2, 2);
+  size_t small_bytes = small.Stats().bytes;
+  size_t small_other_bytes = small_other.Stats().bytes;
+  EXPECT_THROW(small.Join(small_other), std::invalid_argument);
+  EXPECT_EQ(small.Stats().bytes, small_bytes);
+  EXPECT_EQ(small_other.Stats().bytes, small_other_bytes);
+  IntTree tree;
+  IntTree other;
+  for (int i = 0; i < 100; ++i) tree.Insert(i * 2, i);
+  for (int i = 0; i < 100; ++i) other.Insert(i * 2 + 1, i);
+  size_t bytes = tree.Stats().bytes;
+  EXPECT_THROW(tree.Join(other), std::invalid_argument);
+  EXPECT_EQ(tree.Stats().bytes, bytes);
+}
+
+TEST(rbtree_test, split_and_join_random) {
+  IntTree tree;
+  std::set<int> orig;
+  unsigned state = 4242;
+  for (int round = 0; round < 200; ++round) {
+    state = state * 1103515245 + 12345;
+    int key = static_cast<int>((state >> 8) % 5000);
+    if (orig.insert(key).second) tree.Insert(key, key);
+    state = state * 1103515245 + 12345;
+    int cut = static_cast<int>((state >> 8) % 5000);
+    IntTree upper;
+    tree.Split(cut, upper);
+    ASSERT_TRUE(IsValidTree(tree));
+    ASSERT_TRUE(IsValidTree(upper));
+    upper.Insert(-1 - round, 0);
+    upper.Delete(-1 - round);
+    tree.Join(upper);
+    ASSERT_TRUE(IsValidTree(tree));
+    ASSERT_EQ(tree.size(), orig.size());
+  }
+  auto it = tree.begin();
+  for (int key : orig) EXPECT_EQ((it++)->data.first, key);
+}
+
+TEST(rbtree_test, combine_trees_in_parallel) {
+  using RankedTree = s21::RBTree<int, int, std::less<int>, s21::Ranking::NODES>;
+  RankedTree a;
+  RankedTree b;
+  for (int i = 0; i < 5000; ++i) a.Insert(i * 2, i);
+  for (int i = 0; i < 3000; ++i) b.Insert(i * 3, i);
+  for (unsigned threads : {1u, 2u, 5u, 8u}) {
+    RankedTree result = s21::CombineTrees(a, b, s21::SetOperation::UNION,
+                                          s21::ParallelPolicy{threads, 0});
+    ASSERT_TRUE(IsValidTree(result)) << threads;
+    EXPECT_EQ(result.size(), 5000 + 1500);
+    EXPECT_EQ(result.TotalWeight(), result.size());
+    bool ok = true;
+    const s21::RBTreeNodeBase* root = &*result.begin();
+    while (!root->parent()->IsHeader()) root = root->parent();
+    CheckWeights<RankedTree>(root, ok);
+    EXPECT_TRUE(ok);
+    RankedTree common = s21::CombineTrees(
+        a, b, s21::SetOperation::INTERSECTION, s21::ParallelPolicy{threads, 0});
+    ASSERT_TRUE(IsValidTree(common));
+    EXPECT_EQ(common.size(), 1500);
+    int expected = 0;
+    for (auto it = common.begin(); it != common.end(); ++it, expected += 6)
+      EXPECT_EQ(it->data.first, expected);
+  }
+}
+
+TEST(rbtree_test, stats) {
+  IntTree tree;
+  EXPECT_EQ(tree.Stats().height, 0U);
+  for (int i = 0; i < 1000; ++i) tree.InsertUnique(i, i);
+  for (int i = 0; i < 1000; i += 2) tree.EraseUnique(i);
+  s21::RBTreeStats stats = tree.Stats();
+  EXPECT_EQ(stats.nodes, 500U);
+  EXPECT_GE(stats.height, 9U);
+  EXPECT_LE(stats.height, 2 * 9U);
+  EXPECT_GE(stats.height, stats.blackHeight);
+  EXPECT_LE(stats.height, 2 * stats.blackHeight);
+  EXPECT_GE(stats.bytes, 500 * sizeof(IntTree::Node));
+#ifdef S21_RBTREE_STATS
+  EXPECT_GT(stats.comparisons, 1000U);
+  EXPECT_GT(stats.rotations, 900U);
+  EXPECT_EQ(stats.fixInsertCalls, 1000U);
+  EXPECT_GE(stats.fixInsertLevels, stats.fixInsertCalls);
+  EXPECT_GT(stats.fixDeleteCalls, 0U);
+  EXPECT_GE(stats.fixDeleteIterations, stats.fixDeleteCalls / 2);
+  IntTree copy(tree);
+  EXPECT_EQ(copy.Stats().rotations, 0U);
+#else
+  EXPECT_EQ(stats.comparisons + stats.rotations + stats.fixInsertCalls +
+                stats.fixDeleteIterations,
+            0U);
+#endif
+}
+
+TEST(rbtree_test, container_stats) {
+  s21::map<int, int> map{{1, 1}, {2, 2}, {3, 3}};
+  s21::set<int> set{1, 2, 3, 4};
+  s21::multiset<int> multiset{1, 1, 1, 2};
+  EXPECT_EQ(map.stats().height, 2U);
+  EXPECT_EQ(set.stats().nodes, 4U);
+  EXPECT_EQ(multiset.stats().nodes, 2U);
+  EXPECT_EQ(multiset.stats().blackHeight, 1U);
+}
+
+TEST(rbtree_test, moves_relink_inline_header) {
+  static_assert(std::is_nothrow_move_constructible_v<IntTree> &&
+                std::is_nothrow_move_assignable_v<IntTree> &&
+                std::is_nothrow_move_constructible_v<s21::map<int, int>> &&
+                std::is_nothrow_move_constructible_v<s21::set<int>> &&
+                std::is_nothrow_move_assignable_v<s21::multiset<int>>);
+  IntTree a;
+  IntTree b;
+  for (int i = 0; i < 100; ++i) a.InsertUnique(i, i);
+  a.Swap(b);
+  EXPECT_TRUE(a.empty() && a.begin() == a.end());
+  EXPECT_EQ(b.size(), 100U);
+  EXPECT_TRUE(IsValidTree(a) && IsValidTree(b));
+  IntTree c(std::move(b));
+  EXPECT_TRUE(b.empty() && b.begin() == b.end());
+  EXPECT_TRUE(IsValidTree(c));
+  EXPECT_EQ((--c.end())->data.first, 99);
+  b.InsertUnique(-1, -1);
+  b = std::move(c);
+  EXPECT_EQ(b.size(), 100U);
+  EXPECT_EQ(b.begin()->data.first, 0);
+  EXPECT_TRUE(IsValidTree(b) && IsValidTree(c));
+  IntTree empty;
+  IntTree moved(std::move(empty));
+  EXPECT_TRUE(moved.empty() && moved.begin() == moved.end());
+  moved.InsertUnique(1, 1);
+  empty.InsertUnique(2, 2);
+  EXPECT_TRUE(IsValidTree(moved) && IsValidTree(empty));
+}
+
+TEST(rbtree_test, small_tree_keeps_elements_inline) {
+  using SmallTree =
+      s21::RBTree<int, int, std::less<int>, s21::Ranking::NODES,
+                  s21::NodePool, 8>;
+  auto inline_in = [](SmallTree& tree) {
+    const char* begin = reinterpret_cast<const char*>(&tree);
+    const char* node = reinterpret_cast<const char*>(&*tree.begin());
+    return node >= begin && node < begin + sizeof(tree);
+  };
+  SmallTree tree;
+  std::set<int> expected;
+  for (int key : {5, 1, 7, 3, 8, 2, 6, 4}) {
+    tree.InsertUnique(key, key);
+    expected.insert(key);
+    ASSERT_TRUE(IsValidTree(tree));
+    ASSERT_TRUE(inline_in(tree));
+    bool ok = true;
+    const s21::RBTreeNodeBase* root = &*tree.begin();
+    while (!root->parent()->IsHeader()) root = root->parent();
+    EXPECT_EQ(CheckWeights<SmallTree>(root, ok), tree.size());
+    EXPECT_TRUE(ok);
+  }
+  EXPECT_TRUE(std::equal(expected.begin(), expected.end(), tree.begin(),
+                         [](int key, const auto& node) {
+                           return key == node.data.first;
+                         }));
+  EXPECT_EQ(tree.Rank(6), 5U);
+  EXPECT_EQ(tree.Select(2).first->data.first, 3);
+  EXPECT_EQ(tree.EraseUnique(3), 1U);
+  EXPECT_TRUE(IsValidTree(tree) && inline_in(tree));
+  SmallTree copy(tree);
+  EXPECT_TRUE(IsValidTree(copy) && inline_in(copy));
+  tree.InsertUnique(3, 3);
+  tree.InsertUnique(9, 9);
+  EXPECT_EQ(tree.size(), 9U);
+  EXPECT_TRUE(IsValidTree(tree));
+  EXPECT_FALSE(inline_in(tree));
+  EXPECT_EQ(tree.Rank(9), 8U);
+  tree.clear();
+  tree.InsertUnique(1, 1);
+  EXPECT_TRUE(inline_in(tree));
+  tree.Swap(copy);
+  EXPECT_EQ(tree.size(), 7U);
+  EXPECT_EQ(copy.size(), 1U);
+  EXPECT_TRUE(IsValidTree(tree) && IsValidTree(copy));
+  EXPECT_TRUE(inline_in(tree) && inline_in(copy));
+}
+
+namespace {
+
+// Heap allocation that fails once the given number of nodes is used up.
+template <typename Node>
+class LimitedHeap : public s21::NodeHeap<Node> {
+ public:
+  static int allocationsLeft;
+
+  void* Allocate() {
+    if (allocationsLeft-- == 0) throw std::bad_alloc();
+    return s21::NodeHeap<Node>::Allocate();
+  }
+  LimitedHeap Share(const void*) const { return LimitedHeap(); }
+};
+
+template <typename Node>
+int LimitedHeap<Node>::allocationsLeft = -1;
+
+}  // namespace
+
+TEST(rbtree_test, failed_promote_keeps_inline_elements) {
+  using SmallTree = s21::RBTree<int, std::string, std::less<int>,
+                                s21::Ranking::NONE, LimitedHeap, 4>;
+  using Limit = LimitedHeap<SmallTree::Node>;
+  SmallTree tree;
+  for (int key = 0; key < 4; ++key) {
+    tree.InsertUnique(key, std::string(40, char('a' + key)));
+  }
+  Limit::allocationsLeft = 2;
+  EXPECT_THROW(tree.InsertUnique(4, std::string(40, 'e')), std::bad_alloc);
+  Limit::allocationsLeft = -1;
+  EXPECT_EQ(tree.size(), 4U);
+  EXPECT_TRUE(IsValidTree(tree));
+  for (int key = 0; key < 4; ++key) {
+    EXPECT_EQ(*tree.at(key), std::string(40, char('a' + key)));
+  }
+  tree.InsertUnique(4, std::string(40, 'e'));
+  EXPECT_EQ(tree.size(), 5U);
+  EXPECT_TRUE(IsValidTree(tree));
+  EXPECT_EQ(*tree.at(0), std::string(40, 'a'));
+}
+
+namespace {
+
+// Counts live instances and throws from the copy constructor on request.
+// Copies may be made by several threads.
+struct Tracked {
+  static std::atomic<int> live;
+  static std::atomic<int> copiesLeft;
+  int value = 0;
+  explicit Tracked(int v) : value(v) { ++live; }
+  Tracked(const Tracked& other) : value(other.value) {
+    if (copiesLeft-- == 0) throw std::runtime_error("copy");
+    ++live;
+  }
+  ~Tracked() { --live; }
+};
+
+std::atomic<int> Tracked::live{0};
+std::atomic<int> Tracked::copiesLeft{-1};
+
+}  // namespace
+
+TEST(rbtree_test, copy_and_teardown_without_recursion) {
+  using TrackedTree = s21::RBTree<int, Tracked>;
+  {
+    TrackedTree tree;
+    unsigned state = 77;
+    while (tree.size() < 100000) {
+      state = state * 1103515245 + 12345;
+      int key = static_cast<int>(state >> 4);
+      tree.InsertUnique(key, Tracked(key));
+    }
+    EXPECT_EQ(Tracked::live, 100000);
+    TrackedTree copy(tree);
+    EXPECT_TRUE(IsValidTree(copy));
+    EXPECT_EQ(Tracked::live, 200000);
+    Tracked::copiesLeft = 5000;
+    EXPECT_THROW(TrackedTree failed(tree), std::runtime_error);
+    Tracked::copiesLeft = -1;
+    EXPECT_EQ(Tracked::live, 200000);
+    copy.clear();
+    EXPECT_EQ(Tracked::live, 100000);
+  }
+  EXPECT_EQ(Tracked::live, 0);
+}
+
+TEST(rbtree_test, parallel_copy) {
+  using RankedTree = s21::RBTree<int, int, std::less<int>, s21::Ranking::NODES>;
+  RankedTree tree;
+  unsigned state = 99;
+  while (tree.size() < 20000) {
+    state = state * 1103515245 + 12345;
+    int key = static_cast<int>(state >> 4);
+    tree.InsertUnique(key, key);
+  }
+  for (unsigned threads : {1u, 2u, 3u, 8u, 16u}) {
+    RankedTree copy(tree, {threads, 1000});
+    ASSERT_TRUE(IsValidTree(copy));
+    EXPECT_EQ(copy.size(), tree.size());
+    EXPECT_EQ(copy.TotalWeight(), tree.size());
+    auto it = copy.begin();
+    for (auto& node : tree) {
+      ASSERT_EQ(it->data.first, node.data.first);
+      ++it;
+    }
+    copy.InsertUnique(-1, -1);
+    copy.EraseUnique(tree.begin()->data.first);
+    EXPECT_TRUE(IsValidTree(copy));
+  }
+  s21::ParallelPolicy saved = s21::ParallelCopyPolicy();
+  s21::ParallelCopyPolicy() = {4, 1000};
+  RankedTree assigned;
+  assigned = tree;
+  s21::ParallelCopyPolicy() = saved;
+  EXPECT_TRUE(IsValidTree(assigned));
+  EXPECT_EQ(assigned.size(), tree.size());
+}
+
+TEST(rbtree_test, parallel_copy_throws) {
+  using TrackedTree = s21::RBTree<int, Tracked>;
+  {
+    TrackedTree tree;
+    for (int key = 0; key < 20000; ++key) tree.InsertUnique(key, Tracked(key));
+    Tracked::copiesLeft = 15000;
+    EXPECT_THROW(TrackedTree failed(tree, {4, 1000}), std::runtime_error);
+    Tracked::copiesLeft = -1;
+    EXPECT_EQ(Tracked::live, 20000);
+  }
+  EXPECT_EQ(Tracked::live, 0);
+}
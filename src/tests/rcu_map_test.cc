@@ -0,0 +1,109 @@
+#include <atomic>
+#include <thread>
+
+#include "test_header.h"
+
+namespace {
+
+struct Counted {
+  static std::atomic<int> live;
+  explicit Counted(int v) : value(v) { ++live; }
+  Counted(const Counted& other) : value(other.value) { ++live; }
+  ~Counted() { --live; }
+  int value;
+};
+
+std::atomic<int> Counted::live{0};
+
+constexpr int kKeys = 64;
+
+}  // namespace
+
+TEST(rcu_map_test, reads_and_writes) {
+  s21::rcu_map<int, std::string> m1;
+  auto reader = m1.make_reader();
+  EXPECT_TRUE(m1.insert(1, "one"));
+  EXPECT_FALSE(m1.insert(1, "uno"));
+  EXPECT_TRUE(m1.insert_or_assign(2, "two"));
+  EXPECT_FALSE(m1.insert_or_assign(2, "dos"));
+  EXPECT_TRUE(reader.contains(1));
+  EXPECT_EQ(reader.get(1).value(), "one");
+  EXPECT_EQ(reader.get(2).value(), "dos");
+  EXPECT_FALSE(reader.get(3).has_value());
+  size_t length = 0;
+  EXPECT_TRUE(reader.visit(2, [&](const std::string& s) { length = s.size(); }));
+  EXPECT_EQ(length, 3);
+  EXPECT_EQ(m1.erase(1), 1);
+  EXPECT_EQ(m1.erase(1), 0);
+  EXPECT_FALSE(reader.contains(1));
+  m1.update([](auto& map) {
+    for (int i = 10; i < 20; ++i) map.insert(i, std::to_string(i));
+  });
+  EXPECT_EQ(m1.size(), 11);
+  auto guard = reader.pin();
+  int expected = 10;
+  for (auto it = guard->find(10); it != guard->end(); ++it) {
+    EXPECT_EQ(it->first, expected++);
+  }
+  EXPECT_EQ(expected, 20);
+}
+
+TEST(rcu_map_test, pinned_version_outlives_writes) {
+  {
+    s21::rcu_map<int, Counted> m1;
+    for (int i = 0; i < 100; ++i) m1.insert(i, Counted(i));
+    auto reader = m1.make_reader();
+    {
+      auto guard = reader.pin();
+      m1.update([](auto& map) {
+        for (int i = 0; i < 100; ++i) map.erase(i);
+      });
+      EXPECT_EQ(m1.size(), 0);
+      EXPECT_EQ(guard->size(), 100);
+      EXPECT_EQ(guard->at(42).value, 42);
+      EXPECT_EQ(Counted::live, 100);
+      EXPECT_EQ(m1.retired(), 1);
+    }
+    m1.insert(1, Counted(1));
+    EXPECT_EQ(m1.retired(), 0);
+    EXPECT_EQ(Counted::live, 1);
+  }
+  EXPECT_EQ(Counted::live, 0);
+}
+
+// Every version the writer publishes maps all keys to the same value, a
+// reader that saw a mix would have seen a half applied update.
+TEST(rcu_map_test, readers_see_whole_versions) {
+  s21::rcu_map<int, int> m1;
+  m1.update([](auto& map) {
+    for (int i = 0; i < kKeys; ++i) map.insert(i, 0);
+  });
+  std::atomic<bool> done{false};
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 3; ++t) {
+    readers.emplace_back([&m1, &done]() {
+      auto reader = m1.make_reader();
+      int last = 0;
+      while (!done.load()) {
+        auto guard = reader.pin();
+        int first = guard->begin()->second;
+        int count = 0;
+        for (const auto& item : *guard) {
+          EXPECT_EQ(item.second, first);
+          ++count;
+        }
+        EXPECT_EQ(count, kKeys);
+        EXPECT_GE(first, last);
+        last = first;
+      }
+    });
+  }
+  for (int version = 1; version <= 300; ++version) {
+    m1.update([version](auto& map) {
+      for (int i = 0; i < kKeys; ++i) map.insert_or_assign(i, version);
+    });
+  }
+  done = true;
+  for (std::thread& reader : readers) reader.join();
+  EXPECT_EQ(m1.make_reader().get(7).value(), 300);
+}
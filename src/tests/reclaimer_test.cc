@@ -0,0 +1,88 @@
+#include "test_header.h"
+
+namespace {
+
+// Counts live instances; they may be destroyed on the reclaimer's thread.
+struct Counted {
+  static std::atomic<int> live;
+  int value = 0;
+  explicit Counted(int v) : value(v) { ++live; }
+  Counted(const Counted& other) : value(other.value) { ++live; }
+  ~Counted() { --live; }
+};
+
+std::atomic<int> Counted::live{0};
+
+}  // namespace
+
+TEST(reclaimer_test, map_clear_async) {
+  s21::Reclaimer reclaimer;
+  s21::map<int, Counted> map;
+  for (int i = 0; i < 10000; ++i) map.insert({i, Counted(i)});
+  map.clear_async(reclaimer);
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(map.begin(), map.end());
+  map.insert({1, Counted(1)});
+  EXPECT_EQ(map.at(1).value, 1);
+  reclaimer.Wait();
+  EXPECT_EQ(reclaimer.Pending(), 0U);
+  EXPECT_EQ(Counted::live, 1);
+  map.clear();
+  EXPECT_EQ(Counted::live, 0);
+}
+
+TEST(reclaimer_test, throttled_jobs_finish) {
+  s21::Reclaimer reclaimer({64, std::chrono::microseconds(10)});
+  for (int round = 0; round < 3; ++round) {
+    s21::map<int, Counted> map;
+    for (int i = 0; i < 2000; ++i) map.insert({i, Counted(i)});
+    map.clear_async(reclaimer);
+  }
+  EXPECT_LE(reclaimer.Pending(), 3U);
+  reclaimer.Wait();
+  EXPECT_EQ(Counted::live, 0);
+}
+
+TEST(reclaimer_test, destructor_finishes_jobs) {
+  {
+    s21::Reclaimer reclaimer({16, std::chrono::microseconds(100)});
+    s21::map<int, Counted> map;
+    for (int i = 0; i < 1000; ++i) map.insert({i, Counted(i)});
+    map.clear_async(reclaimer);
+  }
+  EXPECT_EQ(Counted::live, 0);
+}
+
+TEST(reclaimer_test, heap_allocated_nodes) {
+  s21::Reclaimer reclaimer;
+  s21::RBTree<int, Counted, std::less<int>, s21::Ranking::NONE, s21::NodeHeap>
+      tree;
+  for (int i = 0; i < 1000; ++i) tree.InsertUnique(i, Counted(i));
+  tree.ClearAsync(reclaimer);
+  EXPECT_TRUE(tree.empty());
+  reclaimer.Wait();
+  EXPECT_EQ(Counted::live, 0);
+}
+
+TEST(reclaimer_test, sets_and_extracted_nodes) {
+  s21::set<int> set;
+  s21::multiset<int> multiset;
+  for (int i = 0; i < 1000; ++i) {
+    set.insert(i);
+    multiset.insert(i % 10);
+  }
+  auto node = set.extract(500);
+  set.clear_async();
+  multiset.clear_async();
+  EXPECT_TRUE(set.empty());
+  EXPECT_EQ(multiset.size(), 0U);
+  s21::Reclaimer::Global().Wait();
+  EXPECT_EQ(node.value(), 500);
+  set.insert(std::move(node));
+  EXPECT_TRUE(set.contains(500));
+
+  s21::set<int, std::less<int>, false, 8> small;
+  for (int i = 0; i < 5; ++i) small.insert(i);
+  small.clear_async();
+  EXPECT_TRUE(small.empty());
+}
@@ -327,3 +327,331 @@ TEST(set_test, iter7) {
   auto it2 = std::move(it1);
   EXPECT_TRUE(it2 == s1.find(5));
 }
+
+TEST(set_test, range_constr) {
+  std::vector<int> sorted = {1, 2, 3, 5, 8, 13, 21};
+  std::vector<int> unsorted = {21, 1, 13, 2, 8, 3, 5, 1};
+  s21::set<int> s1(sorted.begin(), sorted.end());
+  s21::set<int> s2(unsorted.begin(), unsorted.end());
+  std::set<int> s3(unsorted.begin(), unsorted.end());
+  EXPECT_EQ(s1.size(), s3.size());
+  EXPECT_EQ(s2.size(), s3.size());
+  auto it1 = s1.begin();
+  auto it2 = s2.begin();
+  for (int key : s3) {
+    EXPECT_EQ(*it1++, key);
+    EXPECT_EQ(*it2++, key);
+  }
+}
+
+TEST(set_test, assign_sorted) {
+  std::vector<int> keys;
+  for (int i = 0; i < 777; ++i) keys.push_back(i * 3);
+  s21::set<int> s1 = {1, 2};
+  s1.assign_sorted(keys.begin(), keys.end());
+  EXPECT_EQ(s1.size(), keys.size());
+  EXPECT_FALSE(s1.contains(1));
+  EXPECT_TRUE(s1.contains(3 * 776));
+  auto it = s1.begin();
+  for (int key : keys) EXPECT_EQ(*it++, key);
+  EXPECT_TRUE(s1.insert(4).second);
+  EXPECT_FALSE(s1.insert(6).second);
+}
+
+TEST(set_test, insert_duplicate) {
+  s21::set<int> s1 = {1, 2, 3};
+  auto result = s1.insert(2);
+  EXPECT_FALSE(result.second);
+  EXPECT_EQ(*result.first, 2);
+  EXPECT_EQ(s1.size(), 3);
+}
+
+TEST(set_test, erase_key) {
+  s21::set<int> s1 = {1, 2, 3};
+  std::set<int> s2 = {1, 2, 3};
+  EXPECT_EQ(s1.erase(3), s2.erase(3));
+  EXPECT_EQ(s1.erase(7), s2.erase(7));
+  EXPECT_EQ(s1.size(), s2.size());
+}
+
+TEST(set_test, emplace) {
+  s21::set<std::string> s1;
+  std::set<std::string> s2;
+  EXPECT_EQ(s1.emplace(3, 'x').second, s2.emplace(3, 'x').second);
+  EXPECT_EQ(s1.emplace("xxx").second, s2.emplace("xxx").second);
+  std::string moved = "moved";
+  s1.insert(std::move(moved));
+  EXPECT_TRUE(s1.contains("moved"));
+  EXPECT_EQ(s1.size(), 2);
+  EXPECT_EQ(*s1.begin(), "moved");
+}
+
+TEST(set_test, order_statistics) {
+  s21::set<int, std::less<int>, true> s1;
+  std::set<int> s2;
+  for (int i = 0; i < 1000; ++i) {
+    int key = (i * 7919) % 1543;
+    s1.insert(key);
+    s2.insert(key);
+  }
+  for (int i = 0; i < 500; i += 3) {
+    s1.erase(i);
+    s2.erase(i);
+  }
+  size_t index = 0;
+  for (int key : s2) {
+    EXPECT_EQ(*s1.nth(index), key);
+    EXPECT_EQ(s1.rank(key), index);
+    ++index;
+  }
+  EXPECT_TRUE(s1.nth(s2.size()) == s1.end());
+  EXPECT_EQ(s1.count_range(100, 900),
+            std::distance(s2.lower_bound(100), s2.lower_bound(900)));
+  EXPECT_EQ(s1.count_range(900, 100), 0);
+}
+
+TEST(set_test, custom_compare) {
+  s21::set<int, std::greater<int>> s1 = {5, 1, 4, 2, 3};
+  std::set<int, std::greater<int>> s2 = {5, 1, 4, 2, 3};
+  auto it1 = s1.begin();
+  for (int key : s2) EXPECT_EQ(*it1++, key);
+  EXPECT_EQ(s1.count(4), 1);
+  EXPECT_EQ(s1.count(6), 0);
+}
+
+TEST(set_test, transparent_lookup) {
+  s21::set<std::string, std::less<>> s1 = {"alpha", "beta"};
+  std::string_view probe = "alpha";
+  EXPECT_TRUE(s1.contains(probe));
+  EXPECT_EQ(*s1.find(probe), "alpha");
+  EXPECT_EQ(s1.count(probe), 1);
+  EXPECT_FALSE(s1.contains(std::string_view("gamma")));
+}
+
+TEST(set_test, bounds) {
+  s21::set<int> s1;
+  std::set<int> s2;
+  for (int i = 0; i < 200; i += 3) {
+    s1.insert(i);
+    s2.insert(i);
+  }
+  for (int key = -2; key < 205; ++key) {
+    auto lower2 = s2.lower_bound(key);
+    auto upper2 = s2.upper_bound(key);
+    auto lower1 = s1.lower_bound(key);
+    auto upper1 = s1.upper_bound(key);
+    EXPECT_EQ(lower2 == s2.end(), lower1 == s1.end());
+    if (lower2 != s2.end()) {
+      EXPECT_EQ(*lower1, *lower2);
+    }
+    EXPECT_EQ(upper2 == s2.end(), upper1 == s1.end());
+    if (upper2 != s2.end()) {
+      EXPECT_EQ(*upper1, *upper2);
+    }
+    auto range = s1.equal_range(key);
+    EXPECT_EQ(range.first == range.second, s2.count(key) == 0);
+  }
+}
+
+TEST(set_test, range_scan) {
+  s21::set<int> s1;
+  for (int i = 0; i < 1000; ++i) s1.insert(i * 2);
+  int sum = 0;
+  for (auto it = s1.lower_bound(101); it != s1.upper_bound(199); ++it)
+    sum += *it;
+  int expected = 0;
+  for (int i = 102; i <= 198; i += 2) expected += i;
+  EXPECT_EQ(sum, expected);
+}
+
+TEST(set_test, hinted_insert) {
+  s21::set<int> s1;
+  std::set<int> s2;
+  for (int i = 0; i < 200; ++i) {
+    int key = (i * 37) % 211;
+    s1.insert(s1.end(), key);
+    s2.insert(s2.end(), key);
+  }
+  auto hint = s1.find(50);
+  EXPECT_EQ(*s1.emplace_hint(hint, 51), 51);
+  s2.emplace_hint(s2.end(), 51);
+  EXPECT_EQ(s1.size(), s2.size());
+  auto it1 = s1.begin();
+  for (int key : s2) EXPECT_EQ(*it1++, key);
+  EXPECT_TRUE(s1.find(hint, 51) == s1.find(51));
+  EXPECT_TRUE(s1.find(hint, 1000) == s1.end());
+}
+
+TEST(set_test, node_handle) {
+  s21::set<int> s1 = {1, 2, 3, 4};
+  s21::set<int> s2 = {3};
+  auto node = s1.extract(s1.begin());
+  EXPECT_EQ(node.value(), 1);
+  EXPECT_EQ(s1.size(), 3);
+  auto result = s2.insert(std::move(node));
+  EXPECT_TRUE(result.inserted);
+  EXPECT_EQ(*result.position, 1);
+  auto clash = s2.insert(s1.extract(3));
+  EXPECT_FALSE(clash.inserted);
+  EXPECT_EQ(clash.node.value(), 3);
+  EXPECT_TRUE(s1.insert(std::move(clash.node)).inserted);
+  EXPECT_TRUE(s1.contains(3));
+  EXPECT_FALSE(s2.insert(s21::set<int>::node_type()).inserted);
+}
+
+TEST(set_test, merge_keeps_duplicates_in_other) {
+  s21::set<std::string> s1 = {"a", "c", "e"};
+  s21::set<std::string> s1_1 = {"b", "c", "d", "e", "f"};
+  std::set<std::string> s2 = {"a", "c", "e"};
+  std::set<std::string> s2_1 = {"b", "c", "d", "e", "f"};
+  s1.merge(s1_1);
+  s2.merge(s2_1);
+  EXPECT_EQ(s1.size(), s2.size());
+  EXPECT_EQ(s1_1.size(), s2_1.size());
+  auto it1 = s1.begin();
+  for (const auto& key : s2) EXPECT_EQ(*it1++, key);
+  it1 = s1_1.begin();
+  for (const auto& key : s2_1) EXPECT_EQ(*it1++, key);
+  s1.merge(s1);
+  EXPECT_EQ(s1.size(), s2.size());
+}
+
+TEST(set_test, split_and_join) {
+  s21::set<int, std::greater<int>> s1 = {1, 2, 3, 4, 5, 6, 7, 8};
+  auto low = s1.split_at(4);
+  EXPECT_EQ(s1.size(), 4);
+  EXPECT_EQ(low.size(), 4);
+  EXPECT_EQ(*s1.begin(), 8);
+  EXPECT_EQ(*low.begin(), 4);
+  low.insert(0);
+  low.join(s1);
+  EXPECT_EQ(low.size(), 9);
+  int expected = 8;
+  for (int key : low) EXPECT_EQ(key, expected--);
+}
+
+TEST(set_test, set_operations_against_std) {
+  s21::set<int> s1;
+  s21::set<int> s1_1;
+  std::set<int> s2;
+  std::set<int> s2_1;
+  unsigned state = 99;
+  for (int i = 0; i < 3000; ++i) {
+    state = state * 1103515245 + 12345;
+    int key = static_cast<int>((state >> 8) % 4000);
+    (i % 3 ? s1 : s1_1).insert(key);
+    (i % 3 ? s2 : s2_1).insert(key);
+  }
+  std::set<int> expected[4];
+  std::set_union(s2.begin(), s2.end(), s2_1.begin(), s2_1.end(),
+                 std::inserter(expected[0], expected[0].end()));
+  std::set_intersection(s2.begin(), s2.end(), s2_1.begin(), s2_1.end(),
+                        std::inserter(expected[1], expected[1].end()));
+  std::set_difference(s2.begin(), s2.end(), s2_1.begin(), s2_1.end(),
+                      std::inserter(expected[2], expected[2].end()));
+  std::set_symmetric_difference(s2.begin(), s2.end(), s2_1.begin(),
+                                s2_1.end(),
+                                std::inserter(expected[3], expected[3].end()));
+  for (s21::ParallelPolicy policy :
+       {s21::ParallelPolicy{1, 0}, s21::ParallelPolicy{4, 0},
+        s21::ParallelPolicy{3, 100000}}) {
+    s21::set<int> results[4] = {s21::set_union(s1, s1_1, policy),
+                                s1.set_intersection(s1_1, policy),
+                                s1.set_difference(s1_1, policy),
+                                s21::symmetric_difference(s1, s1_1, policy)};
+    for (int op = 0; op < 4; ++op) {
+      EXPECT_EQ(results[op].size(), expected[op].size());
+      auto it = results[op].begin();
+      for (int key : expected[op]) EXPECT_EQ(*it++, key);
+    }
+  }
+  EXPECT_EQ(s1.size(), s2.size());
+  EXPECT_EQ(s1_1.size(), s2_1.size());
+}
+
+TEST(set_test, find_many) {
+  s21::set<std::string> s1 = {"delta", "alpha", "echo", "charlie"};
+  std::string keys[] = {"echo", "bravo", "alpha", "foxtrot", "delta"};
+  s21::set<std::string>::iterator found[5];
+  s1.find_many(keys, 5, found);
+  uint64_t bits = 0;
+  s1.contains_many(keys, 5, &bits);
+  EXPECT_EQ(bits, 0b10101);
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_TRUE(found[i] == s1.find(keys[i]));
+  }
+}
+
+TEST(set_test, save_and_load) {
+  std::string path = ::testing::TempDir() + "s21_set_archive";
+  s21::set<long, std::greater<long>> s1;
+  std::set<long, std::greater<long>> s2;
+  for (long i = 0; i < 3000; ++i) {
+    s1.insert(i * i % 2003);
+    s2.insert(i * i % 2003);
+  }
+  s1.save(path);
+  s21::set<long, std::greater<long>> loaded;
+  loaded.load(path);
+  EXPECT_EQ(loaded.size(), s2.size());
+  EXPECT_TRUE(std::equal(s2.begin(), s2.end(), loaded.begin()));
+  s21::set<long> ascending;
+  EXPECT_THROW(ascending.load(path), std::runtime_error);
+  EXPECT_TRUE(ascending.empty());
+  std::remove(path.c_str());
+}
+
+TEST(set_test, small_set_against_std) {
+  using SmallSet = s21::set<int, std::less<int>, false, 8>;
+  SmallSet s1;
+  std::set<int> s2;
+  unsigned state = 7;
+  for (int step = 0; step < 3000; ++step) {
+    state = state * 1103515245 + 12345;
+    int key = (state >> 8) % 12;
+    switch ((state >> 20) % 8) {
+      case 0:
+      case 1:
+        EXPECT_EQ(s1.insert(key).second, s2.insert(key).second);
+        break;
+      case 2:
+        EXPECT_EQ(s1.erase(key), s2.erase(key));
+        break;
+      case 3: {
+        SmallSet copy(s1);
+        s1 = std::move(copy);
+        break;
+      }
+      case 4: {
+        SmallSet other{key, key + 20};
+        s1.swap(other);
+        other.swap(s1);
+        break;
+      }
+      case 5: {
+        SmallSet upper = s1.split_at(key);
+        s1.join(upper);
+        break;
+      }
+      case 6: {
+        auto node = s1.extract(key);
+        EXPECT_EQ(node.empty(), s2.count(key) == 0);
+        s1.insert(std::move(node));
+        break;
+      }
+      case 7:
+        if (s2.size() > 10) {
+          s1.clear();
+          s2.clear();
+        }
+        break;
+    }
+    ASSERT_EQ(s1.size(), s2.size());
+    ASSERT_TRUE(std::equal(s2.begin(), s2.end(), s1.begin()));
+  }
+  SmallSet other{100, 50};
+  s1.merge(other);
+  s2.insert({100, 50});
+  EXPECT_TRUE(other.empty());
+  EXPECT_TRUE(std::equal(s2.begin(), s2.end(), s1.begin()));
+}